@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "BufferedFileWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Largest single write handed to the OS.
+    constexpr size_t MaxWriteChunk = 0x40000000u;
+}
+
+BufferedFileWriter::BufferedFileWriter(std::wstring const& path, OpenMode mode, uint64_t startOffset, size_t bufferBytes)
+    : m_capacity(bufferBytes), m_startOffset(startOffset)
+{
+    if (bufferBytes == 0) throw std::invalid_argument("BufferedFileWriter buffer must not be empty");
+    m_buffer.reset(new uint8_t[bufferBytes]);
+
+#if defined(_WIN32)
+    // Read/write sharing so the document being saved may still be open (and mapped) for reading.
+    HANDLE file = ::CreateFileW(
+        path.c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr,
+        mode == OpenMode::Truncate ? CREATE_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to open output file for writing");
+    }
+    m_file = file;
+
+    LARGE_INTEGER offset{};
+    offset.QuadPart = static_cast<LONGLONG>(startOffset);
+    const bool seeked = ::SetFilePointerEx(file, offset, nullptr, FILE_BEGIN) != 0;
+#else
+    const int flags = O_WRONLY | O_CLOEXEC | (mode == OpenMode::Truncate ? (O_CREAT | O_TRUNC) : 0);
+    m_fd = ::open(std::filesystem::path(path).c_str(), flags, 0644);
+    if (m_fd < 0)
+    {
+        throw std::runtime_error("Failed to open output file for writing");
+    }
+
+    const bool seeked = ::lseek(m_fd, static_cast<off_t>(startOffset), SEEK_SET) >= 0;
+#endif
+    if (!seeked)
+    {
+        Close();
+        throw std::runtime_error("Failed to seek output file");
+    }
+}
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+    Close();
+}
+
+void BufferedFileWriter::Write(void const* data, size_t size)
+{
+    // Large blocks skip the buffer once it is drained; small ones are coalesced.
+    if (size >= m_capacity)
+    {
+        Flush();
+        WriteToFile(static_cast<uint8_t const*>(data), size);
+        return;
+    }
+
+    if (m_used + size > m_capacity) Flush();
+    std::memcpy(m_buffer.get() + m_used, data, size);
+    m_used += size;
+}
+
+void BufferedFileWriter::Flush()
+{
+    if (m_used == 0) return;
+    WriteToFile(m_buffer.get(), m_used);
+    m_used = 0;
+}
+
+void BufferedFileWriter::WriteToFile(uint8_t const* bytes, size_t size)
+{
+    while (size > 0)
+    {
+        const size_t chunk = size < MaxWriteChunk ? size : MaxWriteChunk;
+#if defined(_WIN32)
+        DWORD written = 0;
+        if (!::WriteFile(m_file, bytes, static_cast<DWORD>(chunk), &written, nullptr) || written == 0)
+        {
+            throw std::runtime_error("WriteFile failed");
+        }
+#else
+        const ssize_t written = ::write(m_fd, bytes, chunk);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0)
+        {
+            throw std::runtime_error("write failed");
+        }
+#endif
+        ++m_diskWrites;
+        m_bytesWritten += static_cast<uint64_t>(written);
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void BufferedFileWriter::Finish()
+{
+    Flush();
+
+    // When rewriting the tail of an existing file, drop whatever followed the old tail.
+#if defined(_WIN32)
+    const bool truncated = ::SetEndOfFile(m_file) != 0;
+#else
+    const bool truncated = ::ftruncate(m_fd, static_cast<off_t>(m_startOffset + m_bytesWritten)) == 0;
+#endif
+    if (!truncated)
+    {
+        throw std::runtime_error("Failed to set end of output file");
+    }
+    Close();
+}
+
+void BufferedFileWriter::Abandon() noexcept
+{
+    m_used = 0;
+#if defined(_WIN32)
+    if (!m_file) return;
+
+    LARGE_INTEGER offset{};
+    offset.QuadPart = static_cast<LONGLONG>(m_startOffset);
+    if (::SetFilePointerEx(m_file, offset, nullptr, FILE_BEGIN))
+    {
+        ::SetEndOfFile(m_file);
+    }
+#else
+    if (m_fd < 0) return;
+
+    (void)::ftruncate(m_fd, static_cast<off_t>(m_startOffset));
+#endif
+    Close();
+}
+
+void BufferedFileWriter::Close() noexcept
+{
+#if defined(_WIN32)
+    if (m_file)
+    {
+        ::CloseHandle(m_file);
+        m_file = nullptr;
+    }
+#else
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Sequential file writer that coalesces small writes into one large buffer, so a
+// producer emitting many tiny blocks (PDFium's save path) costs a handful of
+// write calls. Throws std::runtime_error on I/O failure.
+class BufferedFileWriter
+{
+public:
+    static constexpr size_t DefaultBufferBytes = 4u * 1024u * 1024u;
+
+    enum class OpenMode
+    {
+        Truncate, // create or replace the file
+        Existing, // keep the file and start writing at startOffset
+    };
+
+    BufferedFileWriter(std::wstring const& path, OpenMode mode, uint64_t startOffset = 0, size_t bufferBytes = DefaultBufferBytes);
+    ~BufferedFileWriter();
+
+    BufferedFileWriter(BufferedFileWriter const&) = delete;
+    BufferedFileWriter& operator=(BufferedFileWriter const&) = delete;
+
+    void Write(void const* data, size_t size);
+
+    // Flushes, cuts the file off at the current position and closes it.
+    void Finish();
+
+    // Undo: cut the file back to where writing started and close it (best effort).
+    void Abandon() noexcept;
+
+    uint64_t BytesWritten() const noexcept { return m_bytesWritten; }
+    uint64_t DiskWrites() const noexcept { return m_diskWrites; }
+
+private:
+    void Flush();
+    void WriteToFile(uint8_t const* bytes, size_t size);
+    void Close() noexcept;
+
+#if defined(_WIN32)
+    void* m_file{ nullptr }; // HANDLE
+#else
+    int m_fd{ -1 };
+#endif
+    std::unique_ptr<uint8_t[]> m_buffer{};
+    size_t m_capacity{};
+    size_t m_used{};
+    uint64_t m_startOffset{};
+    uint64_t m_bytesWritten{};
+    uint64_t m_diskWrites{};
+};
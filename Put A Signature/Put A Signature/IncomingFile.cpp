@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "IncomingFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+IncomingFile::IncomingFile(uint64_t size)
+{
+    if (size == 0) throw std::invalid_argument("File is empty");
+    if (size > (std::numeric_limits<size_t>::max)()) throw std::length_error("File too large for memory");
+
+    // new[] without () leaves the bytes uninitialized: the OS commits pages as chunks land.
+    m_data.reset(new uint8_t[static_cast<size_t>(size)]);
+    m_size = size;
+}
+
+void IncomingFile::Write(uint64_t offset, uint8_t const* data, size_t size)
+{
+    if (size == 0) return;
+    if (offset > m_size || size > m_size - offset) throw std::out_of_range("Data past the end of the file");
+
+    std::memcpy(m_data.get() + offset, data, size);
+
+    // Merge [begin, end) with every arrived range it overlaps or touches.
+    uint64_t begin = offset;
+    uint64_t end = offset + size;
+    auto it = m_ranges.upper_bound(begin);
+    if (it != m_ranges.begin() && std::prev(it)->second >= begin) --it;
+    while (it != m_ranges.end() && it->first <= end)
+    {
+        begin = (std::min)(begin, it->first);
+        end = (std::max)(end, it->second);
+        m_received -= it->second - it->first;
+        it = m_ranges.erase(it);
+    }
+    m_ranges.emplace(begin, end);
+    m_received += end - begin;
+}
+
+bool IncomingFile::Has(uint64_t offset, uint64_t size) const noexcept
+{
+    if (size == 0) return true;
+    if (offset > m_size || size > m_size - offset) return false;
+
+    auto it = m_ranges.upper_bound(offset);
+    if (it == m_ranges.begin()) return false;
+    return std::prev(it)->second >= offset + size;
+}
+
+FileByteRange IncomingFile::NextMissing(uint64_t from, uint64_t maxLength) const noexcept
+{
+    if (!m_data || Complete() || maxLength == 0) return {};
+
+    auto gapAt = [this, maxLength](uint64_t position) -> FileByteRange
+    {
+        auto it = m_ranges.upper_bound(position);
+        if (it != m_ranges.begin() && std::prev(it)->second > position)
+        {
+            position = std::prev(it)->second; // inside an arrived range: skip to its end
+        }
+        if (position >= m_size) return {};
+
+        const uint64_t gapEnd = it == m_ranges.end() ? m_size : it->first;
+        return { position, (std::min)(gapEnd - position, maxLength) };
+    };
+
+    FileByteRange range = gapAt(from < m_size ? from : 0);
+    if (range.length == 0) range = gapAt(0);
+    return range;
+}
+
+void IncomingFile::Close() noexcept
+{
+    m_data.reset();
+    m_size = 0;
+    m_received = 0;
+    m_ranges.clear();
+}
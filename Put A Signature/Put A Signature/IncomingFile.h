@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+// Byte range of a file; length 0 means "nothing".
+struct FileByteRange
+{
+    uint64_t offset{};
+    uint64_t length{};
+};
+
+// Buffer for a file of known size whose bytes arrive in chunks, in any order (a
+// stream read piece by piece, seeking to what the parser asks for first). Tracks
+// which ranges have arrived so a reader can tell what is safe to touch.
+//
+// The buffer is allocated uninitialized, so creating one for a very large file does
+// not touch its memory up front. Move-only.
+class IncomingFile
+{
+public:
+    IncomingFile() noexcept = default;
+    explicit IncomingFile(uint64_t size);
+
+    IncomingFile(IncomingFile&&) noexcept = default;
+    IncomingFile& operator=(IncomingFile&&) noexcept = default;
+    IncomingFile(IncomingFile const&) = delete;
+    IncomingFile& operator=(IncomingFile const&) = delete;
+
+    bool IsOpen() const noexcept { return m_data != nullptr; }
+    uint8_t const* Data() const noexcept { return m_data.get(); }
+    uint64_t Size() const noexcept { return m_size; }
+
+    // Copies bytes in at `offset`. Throws std::out_of_range past the end of the file.
+    void Write(uint64_t offset, uint8_t const* data, size_t size);
+
+    // True if every byte of [offset, offset + size) has arrived.
+    bool Has(uint64_t offset, uint64_t size) const noexcept;
+
+    uint64_t BytesReceived() const noexcept { return m_received; }
+    bool Complete() const noexcept { return m_data && m_received == m_size; }
+
+    // First missing range at or after `from` (wrapping around to the start), at most
+    // maxLength long. Length 0 once the file is complete.
+    FileByteRange NextMissing(uint64_t from, uint64_t maxLength) const noexcept;
+
+    void Close() noexcept;
+
+private:
+    std::unique_ptr<uint8_t[]> m_data{};
+    uint64_t m_size{};
+    uint64_t m_received{};
+
+    // Arrived ranges as start -> end (exclusive); never overlapping or touching.
+    std::map<uint64_t, uint64_t> m_ranges{};
+};
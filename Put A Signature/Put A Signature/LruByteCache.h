@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+struct CacheStats
+{
+    uint64_t hits{};
+    uint64_t misses{};
+    uint64_t evictions{};
+    size_t entries{};
+    size_t bytes{};
+    size_t budgetBytes{};
+};
+
+// Least-recently-used cache bounded by a byte budget instead of an entry count.
+// Callers pass each entry's size on insert; the oldest entries are evicted until
+// the total fits the budget again. A budget of 0 disables caching.
+//
+// Not thread-safe: the owner is expected to call it from a single thread.
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+class LruByteCache
+{
+public:
+    explicit LruByteCache(size_t budgetBytes = 0) noexcept
+        : m_budgetBytes(budgetBytes)
+    {
+    }
+
+    // Returns the cached value and marks it most recently used, or nullptr on a miss.
+    TValue* Find(TKey const& key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+        {
+            ++m_misses;
+            return nullptr;
+        }
+
+        m_order.splice(m_order.begin(), m_order, it->second);
+        ++m_hits;
+        return &it->second->value;
+    }
+
+    // Inserts (or replaces) an entry. Values larger than the whole budget are not kept.
+    void Insert(TKey const& key, TValue value, size_t bytes)
+    {
+        Erase(key);
+        if (bytes > m_budgetBytes) return;
+
+        m_order.push_front(Entry{ key, std::move(value), bytes });
+        m_index.emplace(key, m_order.begin());
+        m_bytes += bytes;
+        Trim();
+    }
+
+    bool Erase(TKey const& key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return false;
+
+        m_bytes -= it->second->bytes;
+        m_order.erase(it->second);
+        m_index.erase(it);
+        return true;
+    }
+
+    // Drops every entry whose key matches; returns how many were removed.
+    template <typename TPredicate>
+    size_t EraseIf(TPredicate const& predicate)
+    {
+        size_t removed = 0;
+        for (auto it = m_order.begin(); it != m_order.end();)
+        {
+            if (predicate(it->key))
+            {
+                m_bytes -= it->bytes;
+                m_index.erase(it->key);
+                it = m_order.erase(it);
+                ++removed;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    // Calls visit(key, value) for every entry, most recently used first. Neither the
+    // order nor the hit/miss counters change.
+    template <typename TVisit>
+    void ForEach(TVisit const& visit) const
+    {
+        for (Entry const& entry : m_order)
+        {
+            visit(entry.key, entry.value);
+        }
+    }
+
+    void Clear() noexcept
+    {
+        m_order.clear();
+        m_index.clear();
+        m_bytes = 0;
+    }
+
+    void SetBudget(size_t budgetBytes)
+    {
+        m_budgetBytes = budgetBytes;
+        Trim();
+    }
+
+    size_t Budget() const noexcept { return m_budgetBytes; }
+    size_t Bytes() const noexcept { return m_bytes; }
+
+    CacheStats Stats() const noexcept
+    {
+        CacheStats stats{};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.entries = m_index.size();
+        stats.bytes = m_bytes;
+        stats.budgetBytes = m_budgetBytes;
+        return stats;
+    }
+
+private:
+    struct Entry
+    {
+        TKey key;
+        TValue value;
+        size_t bytes{};
+    };
+
+    void Trim()
+    {
+        while (m_bytes > m_budgetBytes && !m_order.empty())
+        {
+            Entry& oldest = m_order.back();
+            m_bytes -= oldest.bytes;
+            m_index.erase(oldest.key);
+            m_order.pop_back();
+            ++m_evictions;
+        }
+    }
+
+    std::list<Entry> m_order{};
+    std::unordered_map<TKey, typename std::list<Entry>::iterator, THash> m_index{};
+    size_t m_budgetBytes{};
+    size_t m_bytes{};
+    uint64_t m_hits{};
+    uint64_t m_misses{};
+    uint64_t m_evictions{};
+};
@@ -1,11 +1,10 @@
 #include "pch.h"
 #include "MainWindow.xaml.h"
+#include "TraceLog.h"
 #if __has_include("MainWindow.g.cpp")
 #include "MainWindow.g.cpp"
 #endif
 
-#include "SignatureCapture.h"
-
 #include <winrt/Microsoft.UI.Xaml.Media.Imaging.h>
 #include <winrt/Microsoft.UI.Xaml.Shapes.h>
 #include <winrt/Microsoft.UI.Xaml.Media.h>
@@ -13,12 +12,21 @@
 #include <winrt/Windows.Storage.Pickers.h>
 #include <winrt/Windows.Storage.h>
 #include <winrt/Windows.ApplicationModel.DataTransfer.h>
-#include <winrt/Windows.Security.Cryptography.h>
+#include <winrt/Windows.Storage.Streams.h>
+#include <winrt/Windows.UI.Core.h>
 
 #include <shobjidl.h> // IInitializeWithWindow
 #include <microsoft.ui.xaml.window.h> // IWindowNative
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cwchar> // swprintf_s
+#include <limits>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <utility>
 
 using namespace winrt;
 using namespace Microsoft::UI::Xaml;
@@ -33,6 +41,192 @@ namespace winrt::Put_A_Signature::implementation
 
     namespace
     {
+        // Progressive page rendering: work per slice before yielding to input,
+        // and how often partial output is pushed to the screen on slow pages.
+        constexpr std::chrono::milliseconds RenderTimeSlice{ 8 };
+        constexpr std::chrono::milliseconds PartialRenderInterval{ 200 };
+
+        constexpr float PageRenderScale = 2.0f;
+
+        // Documents without a file path are read in chunks of this size, in the order
+        // PDFium asks for them, so the first page shows before the whole file is in.
+        constexpr uint64_t LoadChunkBytes = 256 * 1024;
+
+        // Pages on each side of the visible one rendered ahead of time into the render cache.
+        constexpr int32_t PrefetchRadius = 2;
+
+        // Zoom tiles are rendered in half-scale steps (so small zoom changes reuse cached
+        // tiles) and never beyond this scale.
+        constexpr float MaxZoomTileScale = 16.0f;
+
+        // Continuous view: pages are laid out at their natural size (1 pt = 96/72 DIP)
+        // and rendered at this scale so they stay sharp on high-DPI screens.
+        constexpr float ContinuousPageScale = 1.5f;
+
+        // Matches reported by one search; the status line says when there are more.
+        constexpr size_t MaxSearchMatches = 1000;
+
+        // Redrawn regions stacked over the single-page image before it is rendered again
+        // as a whole.
+        constexpr size_t MaxPagePatches = 32;
+
+        // Pages of form fields scanned per executor task in the background.
+        constexpr int32_t FormScanPageBudget = 32;
+
+        // Default signature box, and the gap left between it and a search match it is anchored to.
+        constexpr double SignatureBoxWidthPts = 200.0;
+        constexpr double SignatureBoxHeightPts = 80.0;
+        constexpr double SignatureAnchorGapPts = 6.0;
+
+        // Pen used on the signature canvas, and for the stamped strokes.
+        constexpr double SignatureStrokeThickness = 3.0;
+        constexpr uint32_t SignatureStrokeArgb = 0xFF000000;
+
+        void CancelRequest(std::unordered_map<int32_t, PdfCancellationToken>& requests, int32_t pageIndex)
+        {
+            auto it = requests.find(pageIndex);
+            if (it == requests.end()) return;
+            it->second.Cancel();
+            requests.erase(it);
+        }
+
+        void CancelAllRequests(std::unordered_map<int32_t, PdfCancellationToken>& requests)
+        {
+            for (auto& request : requests) request.second.Cancel();
+            requests.clear();
+        }
+
+        struct RenderSlice
+        {
+            PdfRenderStatus status{ PdfRenderStatus::Idle };
+            Windows::Graphics::Imaging::SoftwareBitmap bitmap{ nullptr };
+        };
+
+        // The handler's stamp journal as the UI mirrors it.
+        struct StampJournalState
+        {
+            std::vector<PdfStamp> pending{};
+            bool canUndo{ false };
+            bool canRedo{ false };
+        };
+
+        // What the UI needs to put a document of the session back on screen.
+        struct DocumentView
+        {
+            std::vector<PdfSize> pageSizes{};
+            StampJournalState journal{};
+            bool leftClosed{ false }; // the document left was dropped from the session
+        };
+
+        // A file read through StorageFile whose bytes have not all arrived yet.
+        bool IsStreaming(PdfDocumentHandler const& pdf) noexcept
+        {
+            const PdfLoadStatus status = pdf.ProgressiveLoadStatus();
+            return status == PdfLoadStatus::NeedData || status == PdfLoadStatus::Ready;
+        }
+
+        std::wstring FormatMegabytes(size_t bytes)
+        {
+            wchar_t text[32]{};
+            swprintf_s(text, L"%.1f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+            return text;
+        }
+
+        struct PageImage
+        {
+            Windows::Graphics::Imaging::SoftwareBitmap bitmap{ nullptr };
+            bool awaitingData{ false }; // the page's bytes have not arrived yet
+        };
+
+        // Where a progressive load stands after a chunk: its status, what to read next,
+        // and which of the pages the UI is waiting on can be shown now.
+        struct LoadStep
+        {
+            PdfLoadStatus status{ PdfLoadStatus::Idle };
+            FileByteRange next{};
+            std::vector<int32_t> arrivedPages{};
+        };
+
+        winrt::Windows::Foundation::IAsyncOperation<Windows::Storage::Streams::IBuffer> ReadChunkAsync(
+            Windows::Storage::Streams::IRandomAccessStream stream, FileByteRange range)
+        {
+            TraceSpan span("file.read");
+            Windows::Storage::Streams::Buffer buffer(static_cast<uint32_t>(range.length));
+            stream.Seek(range.offset);
+            co_return co_await stream.ReadAsync(buffer, buffer.Capacity(), Windows::Storage::Streams::InputStreamOptions::None);
+        }
+
+        // Runs on the PDF executor. Asking about a waiting page also moves its data to
+        // the front of the read order.
+        LoadStep FeedChunk(PdfDocumentHandler& pdf, uint64_t offset, Windows::Storage::Streams::IBuffer const& chunk, std::vector<int32_t> const& waitingPages)
+        {
+            if (chunk.Length() == 0) throw std::runtime_error("Unexpected end of file");
+            pdf.AddLoadData(offset, chunk.data(), chunk.Length());
+
+            LoadStep step{};
+            step.status = pdf.ContinueProgressiveLoad();
+            if (step.status == PdfLoadStatus::Ready || step.status == PdfLoadStatus::Complete)
+            {
+                for (int32_t pageIndex : waitingPages)
+                {
+                    if (pdf.IsPageAvailable(pageIndex)) step.arrivedPages.push_back(pageIndex);
+                }
+            }
+            step.next = pdf.NextLoadRange(LoadChunkBytes);
+            return step;
+        }
+
+        // Where a width x height signature goes next to a search match such as "Signature:"
+        // or "Initial here": on the same line right after it, or above it when there is
+        // no room on the right. Kept inside the page.
+        PdfRect SignatureRectNear(PdfRect const& anchor, PdfSize const& page, double width, double height)
+        {
+            PdfRect rect{ anchor.x + anchor.width + SignatureAnchorGapPts, anchor.y, width, height };
+            if (rect.x + width > page.width)
+            {
+                rect.x = anchor.x;
+                rect.y = anchor.y + anchor.height + SignatureAnchorGapPts;
+            }
+            rect.x = std::clamp(rect.x, 0.0, (std::max)(page.width - width, 0.0));
+            rect.y = std::clamp(rect.y, 0.0, (std::max)(page.height - height, 0.0));
+            return rect;
+        }
+
+        // Rects on pageIndex whose pixels differ between two journal states: where a stamp
+        // was placed, removed, or moved from and to.
+        std::vector<PdfRect> ChangedStampRects(std::vector<PdfStamp> const& before, std::vector<PdfStamp> const& after, int32_t pageIndex)
+        {
+            auto missingFrom = [](std::vector<PdfStamp> const& stamps, PdfStamp const& stamp)
+            {
+                return std::none_of(stamps.begin(), stamps.end(), [&stamp](PdfStamp const& other)
+                {
+                    return other.id == stamp.id && other.pageIndex == stamp.pageIndex && other.image == stamp.image
+                        && other.rect.x == stamp.rect.x && other.rect.y == stamp.rect.y
+                        && other.rect.width == stamp.rect.width && other.rect.height == stamp.rect.height;
+                });
+            };
+
+            std::vector<PdfRect> rects{};
+            for (PdfStamp const& stamp : before)
+            {
+                if (stamp.pageIndex == pageIndex && missingFrom(after, stamp)) rects.push_back(stamp.rect);
+            }
+            for (PdfStamp const& stamp : after)
+            {
+                if (stamp.pageIndex == pageIndex && missingFrom(before, stamp)) rects.push_back(stamp.rect);
+            }
+            return rects;
+        }
+
+        // The largest width x height box (aspect kept) centred in `box`.
+        PdfRect FitInside(PdfRect const& box, double width, double height)
+        {
+            const double fit = (std::min)(box.width / width, box.height / height);
+            const double fittedWidth = width * fit;
+            const double fittedHeight = height * fit;
+            return PdfRect{ box.x + (box.width - fittedWidth) / 2.0, box.y + (box.height - fittedHeight) / 2.0, fittedWidth, fittedHeight };
+        }
+
         template <typename TPicker>
         void InitializePickerWithWindow(TPicker const& picker, HWND hwnd)
         {
@@ -95,6 +289,12 @@ namespace winrt::Put_A_Signature::implementation
     {
         InitializeComponent();
 
+        // Coroutines awaiting PDFium work continue on the UI thread.
+        m_pdfExecutor.SetResumer([dispatcher = DispatcherQueue()](std::function<void()> resume)
+        {
+            dispatcher.TryEnqueue([resume = std::move(resume)]() { resume(); });
+        });
+
         // Enable Windows 11 Mica backdrop (best-effort).
         try
         {
@@ -111,6 +311,7 @@ namespace winrt::Put_A_Signature::implementation
         SetEmptyStateVisible(true);
         UpdateNavigationUi();
 
+        SetTraceThreadName("UI");
         StatusText().Text(L"Ready");
     }
 
@@ -121,18 +322,30 @@ namespace winrt::Put_A_Signature::implementation
 
     void MainWindow::UpdateNavigationUi()
     {
-        const bool loaded = m_pdf.IsLoaded() && m_pageCount > 0;
+        const bool loaded = m_pageCount > 0;
 
         PrevPageButton().IsEnabled(loaded && m_currentPageIndex > 0);
         NextPageButton().IsEnabled(loaded && (m_currentPageIndex + 1) < m_pageCount);
 
-        PlaceSignatureButton().IsEnabled(loaded);
-        SaveSignedPdfButton().IsEnabled(loaded);
+        NextSignatureFieldButton().IsEnabled(loaded);
+        PlaceSignatureButton().IsEnabled(loaded && !m_streaming);
+        UndoStampButton().IsEnabled(loaded && m_canUndoStamp);
+        RedoStampButton().IsEnabled(loaded && m_canRedoStamp);
+        SaveSignedPdfButton().IsEnabled(loaded && !m_streaming);
+
+        // Text indexing works outwards from the page being viewed.
+        m_indexFocus.store(m_currentPageIndex, std::memory_order_relaxed);
 
         if (loaded)
         {
             PageNumberBox().Text(to_hstring(m_currentPageIndex + 1));
             PageCountText().Text(to_hstring(m_pageCount));
+
+            if (static_cast<int32_t>(ThumbnailList().Items().Size()) == m_pageCount)
+            {
+                ThumbnailList().SelectedIndex(m_currentPageIndex);
+                ThumbnailList().ScrollIntoView(ThumbnailList().SelectedItem());
+            }
         }
         else
         {
@@ -141,26 +354,143 @@ namespace winrt::Put_A_Signature::implementation
         }
     }
 
+    // Drops what the UI holds for the document on screen, before another one is loaded or
+    // shown. The page it was on is remembered for when it comes back.
+    void MainWindow::ResetDocumentUi()
+    {
+        for (OpenDocument& document : m_openDocuments)
+        {
+            if (document.id == m_documentId && m_pageCount > 0) document.pageIndex = m_currentPageIndex;
+        }
+
+        // Nothing queued for the previous document is worth finishing.
+        m_renderCancel.Cancel();
+        m_loadCancel.Cancel();
+        m_loadCancel = PdfCancellationToken{};
+        m_pdfExecutor.DropPending(PdfTaskPriority::Prefetch);
+        m_pageCount = 0;
+        m_pageSizes.clear();
+        m_pagesAwaitingData.clear();
+        m_streaming = false;
+        m_backgroundCancel.Cancel();
+        m_pdfExecutor.Post(PdfTaskPriority::Visible, [this]() { m_textIndex.Clear(); });
+        m_searchMatches.clear();
+        m_searchAnchor.reset();
+        m_placementAnchor.reset();
+        UpdatePlacementHighlight();
+        m_pendingStamps.clear();
+        m_canUndoStamp = false;
+        m_canRedoStamp = false;
+        m_draggedStamp.reset();
+        StampDragOutline().Visibility(Visibility::Collapsed);
+        ResetPageLists();
+    }
+
     winrt::Windows::Foundation::IAsyncAction MainWindow::LoadPdfFromFileAsync(Windows::Storage::StorageFile const& file)
     {
         if (!file) co_return;
 
         StatusText().Text(L"Loading PDF...");
 
+        // Covers everything up to the first page on screen: what users mean by "opening".
+        TraceSpan openSpan("ui.open");
         bool loaded = false;
         std::wstring errorMessage{};
-
-        winrt::Windows::Storage::Streams::IBuffer fileBuffer{ nullptr };
+        Windows::Storage::Streams::IRandomAccessStream stream{ nullptr };
+        PdfLoadStatus loadStatus = PdfLoadStatus::Idle;
+        FileByteRange nextRange{};
+        PdfDocumentId documentId = m_documentId;
 
         try
         {
-            // Packaged-app friendly: read via StorageFile and load PDF from memory.
-            fileBuffer = co_await winrt::Windows::Storage::FileIO::ReadBufferAsync(file);
-            winrt::com_array<uint8_t> bytes;
-            winrt::Windows::Security::Cryptography::CryptographicBuffer::CopyToByteArray(fileBuffer, bytes);
-            m_pdf.LoadFromBytes(std::vector<uint8_t>(bytes.begin(), bytes.end()));
-            m_pageCount = m_pdf.PageCount();
-            m_currentPageIndex = 0;
+            ResetDocumentUi();
+
+            // The document joins the session in a slot of its own. The slot on screen is
+            // reused when it holds nothing, or a file that never finished streaming in.
+            const PdfDocumentId previousId = m_documentId;
+            documentId = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, previousId]()
+            {
+                if (!m_pdf->IsLoaded() || IsStreaming(*m_pdf))
+                {
+                    m_pdf->Close();
+                    return previousId;
+                }
+                const PdfDocumentId id = m_documents.Add();
+                PdfDocumentHandler& next = m_documents.Use(id);
+                next.SetStampMode(m_pdf->StampMode()); // the toggle is one setting for the session
+                m_pdf = &next;
+                return id;
+            });
+            if (documentId == previousId)
+            {
+                m_openDocuments.erase(std::remove_if(m_openDocuments.begin(), m_openDocuments.end(),
+                    [previousId](OpenDocument const& document) { return document.id == previousId; }), m_openDocuments.end());
+            }
+            m_documentId = documentId;
+
+            // Preferred: map the file so PDFium reads only what it needs.
+            bool opened = false;
+            const std::wstring path{ file.Path() };
+            if (!path.empty())
+            {
+                try
+                {
+                    m_pageSizes = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, path]()
+                    {
+                        m_pdf->LoadFromPath(path);
+                        return m_pdf->PageSizesPoints();
+                    });
+                    opened = true;
+                }
+                catch (...)
+                {
+                    // No direct file access (e.g. a brokered location); read through StorageFile instead.
+                }
+            }
+
+            int32_t firstPage = 0;
+            if (!opened)
+            {
+                // Packaged-app friendly: stream the file through StorageFile in the order
+                // PDFium asks for it. A linearized file opens after its first few chunks;
+                // the rest keeps arriving once the first page is on screen.
+                PdfCancellationToken cancel = m_loadCancel;
+                stream = co_await file.OpenReadAsync();
+                const uint64_t size = stream.Size();
+                LoadStep step = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, size]()
+                {
+                    m_pdf->BeginProgressiveLoad(size);
+                    LoadStep first{};
+                    first.status = m_pdf->ContinueProgressiveLoad();
+                    first.next = m_pdf->NextLoadRange(LoadChunkBytes);
+                    return first;
+                });
+                while (step.status == PdfLoadStatus::NeedData && step.next.length > 0)
+                {
+                    auto chunk = co_await ReadChunkAsync(stream, step.next);
+                    step = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, offset = step.next.offset, chunk, cancel]()
+                    {
+                        return cancel.IsCancelled() ? LoadStep{} : FeedChunk(*m_pdf, offset, chunk, {});
+                    });
+                    if (cancel.IsCancelled()) co_return; // another document was opened meanwhile
+                }
+                if (step.status != PdfLoadStatus::Ready && step.status != PdfLoadStatus::Complete)
+                {
+                    throw std::runtime_error("Failed to load PDF (corrupt PDF, password needed, or PDFium load error)");
+                }
+                loadStatus = step.status;
+                nextRange = step.next;
+
+                auto opening = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]()
+                {
+                    return std::make_pair(m_pdf->PageSizesPoints(), m_pdf->FirstAvailablePage());
+                });
+                m_pageSizes = std::move(opening.first);
+                firstPage = opening.second;
+            }
+            m_pageCount = static_cast<int32_t>(m_pageSizes.size());
+            m_currentPageIndex = std::clamp(firstPage, 0, (std::max)(m_pageCount - 1, 0));
+            ResetPageLists();
             loaded = true;
         }
         catch (std::exception const& ex)
@@ -174,193 +504,1356 @@ namespace winrt::Put_A_Signature::implementation
 
         if (!loaded)
         {
-            DocInfoText().Text(L"(no file loaded)");
-            SetEmptyStateVisible(true);
-            UpdateNavigationUi();
+            if (m_documentId != documentId) co_return; // another document was shown meanwhile
+
+            // Back to the most recently opened document, if any; it drops the failed slot.
+            if (!m_openDocuments.empty())
+            {
+                co_await ShowDocumentAsync(m_openDocuments.back().id);
+            }
+            else
+            {
+                DocInfoText().Text(L"(no file loaded)");
+                SetEmptyStateVisible(true);
+                UpdateNavigationUi();
+                UpdateDocumentPicker();
+            }
             StatusText().Text(errorMessage.empty() ? L"Failed to load PDF" : winrt::hstring(errorMessage));
             co_return;
         }
 
+        m_openDocuments.push_back(OpenDocument{ documentId, file.Name(), m_currentPageIndex });
+        m_streaming = loadStatus == PdfLoadStatus::Ready;
         DocInfoText().Text(file.Name());
         SetEmptyStateVisible(false);
         UpdateNavigationUi();
-        co_await RenderCurrentPageAsync();
+        UpdateDocumentPicker();
+        if (loadStatus == PdfLoadStatus::Ready)
+        {
+            // Indexing starts once the rest of the file is in.
+            StreamRemainingPdfAsync(stream, nextRange, m_loadCancel);
+        }
+        else
+        {
+            StartBackgroundScans();
+        }
+        if (!m_continuousView) co_await RenderCurrentPageAsync();
     }
 
-    winrt::Windows::Foundation::IAsyncAction MainWindow::RenderCurrentPageAsync()
+    winrt::fire_and_forget MainWindow::StreamRemainingPdfAsync(Windows::Storage::Streams::IRandomAccessStream stream, FileByteRange next, PdfCancellationToken cancel)
     {
-        if (!m_pdf.IsLoaded() || m_pageCount <= 0) co_return;
+        auto lifetime = get_strong();
 
-        StatusText().Text(L"Rendering...");
+        try
+        {
+            PdfLoadStatus status = PdfLoadStatus::Ready;
+            while (next.length > 0)
+            {
+                auto chunk = co_await ReadChunkAsync(stream, next);
+                if (cancel.IsCancelled()) co_return;
 
-        const int32_t pageIndex = m_currentPageIndex;
+                // The token is checked again on the executor: a newer document may have
+                // been opened between queueing this chunk and running it.
+                std::vector<int32_t> waiting(m_pagesAwaitingData.begin(), m_pagesAwaitingData.end());
+                LoadStep step = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, offset = next.offset, chunk, waiting = std::move(waiting), cancel]()
+                {
+                    return cancel.IsCancelled() ? LoadStep{} : FeedChunk(*m_pdf, offset, chunk, waiting);
+                });
+                if (cancel.IsCancelled()) co_return;
 
-        Windows::Graphics::Imaging::SoftwareBitmap pageBitmap{ nullptr };
+                for (int32_t pageIndex : step.arrivedPages)
+                {
+                    m_pagesAwaitingData.erase(pageIndex);
+                    if (!m_continuousView && pageIndex == m_currentPageIndex) RenderCurrentPageAsync();
+                    RefreshPageImages(pageIndex);
+                }
+                status = step.status;
+                next = step.next;
+            }
+            if (status != PdfLoadStatus::Complete) throw std::runtime_error("PDF ended early");
 
-        // 1) Render via PDFium
-        try
-        {
-            pageBitmap = m_pdf.RenderPageToSoftwareBitmap(pageIndex, 2.0f /*scale*/);
-        }
-        catch (std::exception const& ex)
-        {
-            std::wstring msg = L"PDF render failed: ";
-            msg += winrt::to_hstring(ex.what()).c_str();
-            StatusText().Text(winrt::hstring(msg));
-            co_return;
+            // Pages whose dictionaries were not in yet got placeholder sizes.
+            auto sizes = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, cancel]()
+            {
+                return cancel.IsCancelled() ? std::vector<PdfSize>{} : m_pdf->PageSizesPoints();
+            });
+            if (cancel.IsCancelled()) co_return;
+            m_pageSizes = std::move(sizes);
+            m_streaming = false;
+            UpdateNavigationUi();
+            StartBackgroundScans();
         }
         catch (...)
         {
-            StatusText().Text(L"PDF render failed (unknown error)");
-            co_return;
+            if (!cancel.IsCancelled()) StatusText().Text(L"Failed to read the rest of the PDF");
         }
+    }
 
-        // 2) Display in WinUI (this can fail with HRESULTs if the bitmap is incompatible)
+    // Puts another document of the session on screen, on the page it was left on, with its
+    // pending stamps. A document the pool parked is reopened from its file first.
+    winrt::Windows::Foundation::IAsyncAction MainWindow::ShowDocumentAsync(PdfDocumentId id)
+    {
+        auto shown = std::find_if(m_openDocuments.begin(), m_openDocuments.end(),
+            [id](OpenDocument const& document) { return document.id == id; });
+        if (shown == m_openDocuments.end()) co_return;
+
+        StatusText().Text(L"Opening document...");
+        ResetDocumentUi();
+        const winrt::hstring name = shown->name;
+        const int32_t pageIndex = shown->pageIndex;
+        const PdfDocumentId leftId = m_documentId;
+
+        std::optional<DocumentView> view{};
+        std::wstring errorMessage{};
         try
         {
-            Microsoft::UI::Xaml::Media::Imaging::SoftwareBitmapSource source;
-            co_await source.SetBitmapAsync(pageBitmap);
-            PdfPageImage().Source(source);
-            StatusText().Text(L"Ready");
-        }
-        catch (winrt::hresult_error const& e)
-        {
-            wchar_t hex[11]{};
-            swprintf_s(hex, L"%08X", static_cast<uint32_t>(e.code().value));
+            view = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, id, leftId]()
+            {
+                // Reopening can throw; until it succeeds the document on screen stays current.
+                PdfDocumentHandler& next = m_documents.Use(id);
+                next.SetStampMode(m_pdf->StampMode());
+                DocumentView shownView{};
 
-            std::wstring msg = L"Display failed: 0x";
-            msg += hex;
-            msg += L" ";
-            msg += e.message().c_str();
-            StatusText().Text(winrt::hstring(msg));
+                // A file still streaming in (or an empty slot) cannot be resumed later.
+                if (leftId != id && (!m_pdf->IsLoaded() || IsStreaming(*m_pdf)))
+                {
+                    m_documents.Remove(leftId);
+                    shownView.leftClosed = true;
+                }
+                m_pdf = &next;
+
+                shownView.pageSizes = m_pdf->PageSizesPoints();
+                shownView.journal = StampJournalState{ m_pdf->PendingStamps(), m_pdf->CanUndoStamp(), m_pdf->CanRedoStamp() };
+                return shownView;
+            });
         }
         catch (std::exception const& ex)
         {
-            std::wstring msg = L"Display failed: ";
-            msg += winrt::to_hstring(ex.what()).c_str();
-            StatusText().Text(winrt::hstring(msg));
+            errorMessage = winrt::to_hstring(ex.what());
         }
         catch (...)
         {
-            StatusText().Text(L"Display failed (unknown error)");
+            errorMessage = L"unknown error";
         }
-    }
-
-    winrt::fire_and_forget MainWindow::OpenPdfButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
-    {
-        auto lifetime = get_strong();
-        StatusText().Text(L"Picking PDF...");
 
-        Windows::Storage::Pickers::FileOpenPicker picker;
-        picker.FileTypeFilter().Append(L".pdf");
+        if (!view)
+        {
+            // The file was moved or changed since it was parked: it leaves the session.
+            co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, id]() { m_documents.Remove(id); });
+            m_openDocuments.erase(std::remove_if(m_openDocuments.begin(), m_openDocuments.end(),
+                [id](OpenDocument const& document) { return document.id == id; }), m_openDocuments.end());
+
+            const bool leftIsOpen = std::any_of(m_openDocuments.begin(), m_openDocuments.end(),
+                [leftId](OpenDocument const& document) { return document.id == leftId; });
+            if (leftIsOpen)
+            {
+                co_await ShowDocumentAsync(leftId);
+            }
+            else
+            {
+                DocInfoText().Text(L"(no file loaded)");
+                SetEmptyStateVisible(true);
+                UpdateNavigationUi();
+                UpdateDocumentPicker();
+            }
 
-        HWND hwnd = GetWindowHwnd(*this);
-        InitializePickerWithWindow(picker, hwnd);
+            std::wstring msg = L"Could not reopen ";
+            msg += name.c_str();
+            msg += L": ";
+            msg += errorMessage;
+            StatusText().Text(winrt::hstring(msg));
+            co_return;
+        }
 
-        Windows::Storage::StorageFile file = co_await picker.PickSingleFileAsync();
-        if (!file)
+        if (view->leftClosed)
         {
-            StatusText().Text(L"Open canceled");
-            co_return;
+            m_openDocuments.erase(std::remove_if(m_openDocuments.begin(), m_openDocuments.end(),
+                [leftId](OpenDocument const& document) { return document.id == leftId; }), m_openDocuments.end());
         }
 
-        co_await LoadPdfFromFileAsync(file);
+        m_documentId = id;
+        m_pageSizes = std::move(view->pageSizes);
+        m_pageCount = static_cast<int32_t>(m_pageSizes.size());
+        m_currentPageIndex = std::clamp(pageIndex, 0, (std::max)(m_pageCount - 1, 0));
+        m_pendingStamps = std::move(view->journal.pending);
+        m_canUndoStamp = view->journal.canUndo;
+        m_canRedoStamp = view->journal.canRedo;
+        ResetPageLists();
+
+        DocInfoText().Text(name);
+        SetEmptyStateVisible(false);
+        UpdateNavigationUi();
+        UpdateDocumentPicker();
+        StartBackgroundScans();
+        if (m_continuousView)
+        {
+            ShowPage(m_currentPageIndex);
+            StatusText().Text(L"Ready");
+        }
+        else
+        {
+            co_await RenderCurrentPageAsync();
+        }
     }
 
-    winrt::fire_and_forget MainWindow::PlaceSignatureButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    // One entry per open document; the picker replaces the file name once there are two.
+    void MainWindow::UpdateDocumentPicker()
     {
-        auto lifetime = get_strong();
+        m_updatingDocumentPicker = true;
 
-        if (!m_pdf.IsLoaded())
+        auto picker = DocumentPicker();
+        picker.Items().Clear();
+        int32_t selectedIndex = -1;
+        for (size_t i = 0; i < m_openDocuments.size(); ++i)
         {
-            StatusText().Text(L"Load a PDF first");
-            co_return;
+            picker.Items().Append(box_value(m_openDocuments[i].name));
+            if (m_openDocuments[i].id == m_documentId) selectedIndex = static_cast<int32_t>(i);
         }
+        picker.SelectedIndex(selectedIndex);
 
-        StatusText().Text(L"Capturing signature...");
+        const bool several = m_openDocuments.size() > 1;
+        picker.Visibility(several ? Visibility::Visible : Visibility::Collapsed);
+        DocInfoText().Visibility(several ? Visibility::Collapsed : Visibility::Visible);
+        CloseDocumentButton().Visibility(m_openDocuments.empty() ? Visibility::Collapsed : Visibility::Visible);
 
-        Windows::Graphics::Imaging::SoftwareBitmap signatureBitmap =
-            co_await SignatureCapture::CaptureElementAsync(SignatureCanvas());
-
-        // Minimal placeholder placement: stamp near bottom-left-ish.
-        // NOTE: PDF coordinate system origin is bottom-left; UI is top-left.
-        // You will likely replace this with proper UI->PDF coordinate conversion.
-        PdfRect rectInPdfPoints{};
-        rectInPdfPoints.x = 72;        // 1 inch from left
-        rectInPdfPoints.y = 72;        // 1 inch from bottom
-        rectInPdfPoints.width = 200;   // points
-        rectInPdfPoints.height = 80;   // points
-
-        StatusText().Text(L"Stamping signature...");
-        m_pdf.StampSignatureBitmap(m_currentPageIndex, signatureBitmap, rectInPdfPoints);
-
-        // Re-render the page so the user sees the result.
-        co_await RenderCurrentPageAsync();
-
-        StatusText().Text(L"Signature placed");
+        m_updatingDocumentPicker = false;
     }
 
-    winrt::fire_and_forget MainWindow::SaveSignedPdfButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    // Keeps the session under its memory budget (PdfDocumentPool::Enforce) and shows where
+    // the memory goes: the total in the header, one line per document in its tooltip.
+    winrt::fire_and_forget MainWindow::UpdateDocumentMemoryAsync()
     {
         auto lifetime = get_strong();
 
-        if (!m_pdf.IsLoaded())
+        struct PoolReport
+        {
+            size_t totalBytes{};
+            size_t budgetBytes{};
+            std::vector<PdfPooledDocument> documents{};
+        };
+        PoolReport report{};
+        try
+        {
+            report = co_await m_pdfExecutor.Run(PdfTaskPriority::Background, [this]()
+            {
+                PoolReport pool{};
+                pool.totalBytes = m_documents.Enforce();
+                pool.budgetBytes = m_documents.Budget();
+                pool.documents = m_documents.Documents();
+                return pool;
+            });
+        }
+        catch (...)
         {
-            StatusText().Text(L"Load a PDF first");
             co_return;
         }
 
-        StatusText().Text(L"Picking save location...");
-
-        Windows::Storage::Pickers::FileSavePicker picker;
-        picker.SuggestedFileName(L"signed");
-        picker.FileTypeChoices().Insert(L"PDF Document", single_threaded_vector<hstring>({ L".pdf" }));
-
-        HWND hwnd = GetWindowHwnd(*this);
-        InitializePickerWithWindow(picker, hwnd);
-
-        Windows::Storage::StorageFile outFile = co_await picker.PickSaveFileAsync();
-        if (!outFile)
+        if (m_openDocuments.empty())
         {
-            StatusText().Text(L"Save canceled");
+            DocumentMemoryText().Text(L"");
+            Controls::ToolTipService::SetToolTip(DocumentMemoryText(), nullptr);
             co_return;
         }
 
-        StatusText().Text(L"Saving...");
-        m_pdf.SaveAs(outFile.Path().c_str());
+        std::wstring summary = std::to_wstring(m_openDocuments.size());
+        summary += m_openDocuments.size() == 1 ? L" document, " : L" documents, ";
+        summary += FormatMegabytes(report.totalBytes);
+        summary += L" of ";
+        summary += FormatMegabytes(report.budgetBytes);
+        DocumentMemoryText().Text(winrt::hstring(summary));
 
-        StatusText().Text(L"Saved");
+        std::wstring details{};
+        for (OpenDocument const& open : m_openDocuments)
+        {
+            auto pooled = std::find_if(report.documents.begin(), report.documents.end(),
+                [&open](PdfPooledDocument const& document) { return document.id == open.id; });
+            if (pooled == report.documents.end()) continue;
+
+            if (!details.empty()) details += L"\n";
+            details += open.name.c_str();
+            details += L": ";
+            if (pooled->parked)
+            {
+                details += L"parked";
+                continue;
+            }
+            PdfMemoryUsage const& memory = pooled->memory;
+            details += FormatMegabytes(memory.Total());
+            details += L" (renders " + FormatMegabytes(memory.renderCacheBytes);
+            details += L", pages " + FormatMegabytes(memory.pageHandleBytes);
+            details += L", file " + FormatMegabytes(memory.documentBytes);
+            details += L", signatures " + FormatMegabytes(memory.retainedBitmapBytes) + L")";
+            if (pooled->reopenPath.empty()) details += L", kept open";
+        }
+        Controls::ToolTipService::SetToolTip(DocumentMemoryText(), box_value(winrt::hstring(details)));
     }
 
-    void MainWindow::ClearSignatureButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    void MainWindow::ShowPage(int32_t pageIndex)
     {
-        SignatureCanvas().Children().Clear();
-        StatusText().Text(L"Signature cleared");
-    }
+        if (m_pageCount <= 0) return;
 
-    void MainWindow::PrevPageButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
-    {
-        if (!m_pdf.IsLoaded() || m_pageCount <= 0) return;
-        if (m_currentPageIndex <= 0) return;
-        m_currentPageIndex--;
+        m_currentPageIndex = std::clamp(pageIndex, 0, m_pageCount - 1);
         UpdateNavigationUi();
-        RenderCurrentPageAsync();
+
+        if (m_continuousView)
+        {
+            PdfPageList().ScrollIntoView(PdfPageList().Items().GetAt(static_cast<uint32_t>(m_currentPageIndex)), Controls::ScrollIntoViewAlignment::Leading);
+        }
+        else
+        {
+            RenderCurrentPageAsync();
+        }
     }
 
-    void MainWindow::NextPageButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    void MainWindow::ResetPageLists()
     {
-        if (!m_pdf.IsLoaded() || m_pageCount <= 0) return;
-        if ((m_currentPageIndex + 1) >= m_pageCount) return;
-        m_currentPageIndex++;
-        UpdateNavigationUi();
-        RenderCurrentPageAsync();
+        CancelAllRequests(m_thumbnailRequests);
+        CancelAllRequests(m_pageImageRequests);
+        ThumbnailList().ItemsSource(nullptr);
+        PdfPageList().ItemsSource(nullptr);
+        if (m_pageCount <= 0) return;
+
+        // One boxed index per page; both lists virtualize, so only realized items cost an image.
+        std::vector<Windows::Foundation::IInspectable> items{};
+        items.reserve(static_cast<size_t>(m_pageCount));
+        for (int32_t i = 0; i < m_pageCount; ++i) items.push_back(box_value(i));
+
+        auto source = single_threaded_vector<Windows::Foundation::IInspectable>(std::move(items));
+        ThumbnailList().ItemsSource(source);
+        PdfPageList().ItemsSource(source);
     }
 
-    winrt::fire_and_forget MainWindow::PageNumberBox_KeyDown(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& args)
+    void MainWindow::RefreshPageImages(int32_t pageIndex)
     {
-        auto lifetime = get_strong();
+        auto refresh = [this, pageIndex](Controls::ListView const& list, bool thumbnail)
+        {
+            auto container = list.ContainerFromIndex(pageIndex).try_as<Controls::ListViewItem>();
+            if (!container) return;
+            if (auto image = container.ContentTemplateRoot().try_as<Controls::Image>())
+            {
+                LoadPageImageAsync(image, pageIndex, thumbnail);
+            }
+        };
+        refresh(ThumbnailList(), true);
+        refresh(PdfPageList(), false);
+    }
+
+    winrt::fire_and_forget MainWindow::LoadPageImageAsync(Controls::Image image, int32_t pageIndex, bool thumbnail)
+    {
+        auto lifetime = get_strong();
+
+        auto& requests = thumbnail ? m_thumbnailRequests : m_pageImageRequests;
+        CancelRequest(requests, pageIndex);
+        PdfCancellationToken cancel{};
+        requests[pageIndex] = cancel;
+
+        try
+        {
+            // Thumbnails are cheap and can wait behind the visible page; continuous-view pages cannot.
+            const PdfTaskPriority priority = thumbnail ? PdfTaskPriority::Background : PdfTaskPriority::Visible;
+            PageImage page = co_await m_pdfExecutor.Run(priority, [this, pageIndex, thumbnail, cancel]()
+            {
+                // Scrubbing recycles containers faster than pages render; skip the ones already gone.
+                PageImage result{};
+                if (cancel.IsCancelled()) return result;
+                if (!m_pdf->IsPageAvailable(pageIndex))
+                {
+                    result.awaitingData = true;
+                    return result;
+                }
+                result.bitmap = thumbnail
+                    ? m_pdf->RenderThumbnailToSoftwareBitmap(pageIndex)
+                    : m_pdf->RenderPageToSoftwareBitmap(pageIndex, ContinuousPageScale);
+                return result;
+            });
+            if (cancel.IsCancelled()) co_return;
+            if (page.awaitingData) m_pagesAwaitingData.insert(pageIndex); // refreshed when it arrives
+            auto bitmap = page.bitmap;
+            if (!bitmap) co_return;
+
+            SoftwareBitmapSource source;
+            {
+                TraceSpan span("ui.set_bitmap", pageIndex);
+                co_await source.SetBitmapAsync(bitmap);
+            }
+            if (cancel.IsCancelled()) co_return;
+
+            // The container may have been reused for another page in the meantime.
+            if (unbox_value_or<int32_t>(image.Tag(), -1) != pageIndex) co_return;
+            image.Source(source);
+        }
+        catch (...)
+        {
+            // Leave the placeholder; a failed thumbnail must not disturb the viewer.
+        }
+    }
+
+    void MainWindow::ContinuousViewToggle_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        m_continuousView = unbox_value_or<bool>(ContinuousViewToggle().IsChecked(), false);
+
+        PdfPageList().Visibility(m_continuousView ? Visibility::Visible : Visibility::Collapsed);
+        PdfScrollViewer().Visibility(m_continuousView ? Visibility::Collapsed : Visibility::Visible);
+        if (m_continuousView)
+        {
+            m_renderCancel.Cancel();
+            ClearZoomTiles();
+            UpdatePlacementHighlight();
+        }
+
+        ShowPage(m_currentPageIndex);
+    }
+
+    void MainWindow::ThumbnailList_ItemClick(Windows::Foundation::IInspectable const&, Controls::ItemClickEventArgs const& args)
+    {
+        ShowPage(unbox_value<int32_t>(args.ClickedItem()));
+    }
+
+    void MainWindow::ThumbnailList_ContainerContentChanging(Controls::ListViewBase const&, Controls::ContainerContentChangingEventArgs const& args)
+    {
+        auto image = args.ItemContainer().ContentTemplateRoot().try_as<Controls::Image>();
+        if (!image) return;
+
+        const int32_t pageIndex = unbox_value<int32_t>(args.Item());
+        image.Source(nullptr);
+        if (args.InRecycleQueue())
+        {
+            CancelRequest(m_thumbnailRequests, pageIndex);
+            image.Tag(nullptr);
+        }
+        else
+        {
+            image.Tag(box_value(pageIndex));
+            LoadPageImageAsync(image, pageIndex, true);
+        }
+        args.Handled(true);
+    }
+
+    void MainWindow::PdfPageList_ContainerContentChanging(Controls::ListViewBase const&, Controls::ContainerContentChangingEventArgs const& args)
+    {
+        auto image = args.ItemContainer().ContentTemplateRoot().try_as<Controls::Image>();
+        if (!image) return;
+
+        const int32_t pageIndex = unbox_value<int32_t>(args.Item());
+        image.Source(nullptr);
+        if (args.InRecycleQueue())
+        {
+            CancelRequest(m_pageImageRequests, pageIndex);
+            image.Tag(nullptr);
+            args.Handled(true);
+            return;
+        }
+
+        // Size the placeholder up front so the scroll extent is right before anything renders.
+        if (pageIndex < static_cast<int32_t>(m_pageSizes.size()))
+        {
+            PdfSize const& size = m_pageSizes[static_cast<size_t>(pageIndex)];
+            image.Width(size.width * (96.0 / 72.0));
+            image.Height(size.height * (96.0 / 72.0));
+        }
+        image.Tag(box_value(pageIndex));
+        LoadPageImageAsync(image, pageIndex, false);
+
+        // Page navigation follows the scroll position.
+        if (auto panel = PdfPageList().ItemsPanelRoot().try_as<Controls::ItemsStackPanel>())
+        {
+            const int32_t first = panel.FirstVisibleIndex();
+            if (first >= 0 && first != m_currentPageIndex)
+            {
+                m_currentPageIndex = first;
+                UpdateNavigationUi();
+            }
+        }
+        args.Handled(true);
+    }
+
+    winrt::Windows::Foundation::IAsyncAction MainWindow::RenderCurrentPageAsync()
+    {
+        if (m_pageCount <= 0) co_return;
+
+        // A newer request supersedes any render still running for a page the user has left,
+        // and prefetches must not run between this page's render slices.
+        m_renderCancel.Cancel();
+        m_renderCancel = PdfCancellationToken{};
+        PdfCancellationToken cancel = m_renderCancel;
+        m_pdfExecutor.DropPending(PdfTaskPriority::Prefetch);
+        ClearZoomTiles();
+        PlacementHighlight().Visibility(Visibility::Collapsed); // back once this page is on screen
+
+        StatusText().Text(L"Rendering...");
+
+        const int32_t pageIndex = m_currentPageIndex;
+
+        Windows::Graphics::Imaging::SoftwareBitmap pageBitmap{ nullptr };
+
+        // 1) Render via PDFium on the executor thread in short slices. Each slice is a
+        //    separate Visible task, so a newer page request is served between slices
+        //    and cancels this render.
+        try
+        {
+            auto continueRender = [this]()
+            {
+                RenderSlice slice{};
+                slice.status = m_pdf->ContinueProgressiveRender(RenderTimeSlice);
+                if (slice.status == PdfRenderStatus::Done) slice.bitmap = m_pdf->ProgressiveRenderSnapshot();
+                return slice;
+            };
+
+            const std::optional<PdfSize> pageSize = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, pageIndex, cancel]() -> std::optional<PdfSize>
+            {
+                if (!m_pdf->IsPageAvailable(pageIndex)) return std::nullopt;
+                m_pdf->BeginProgressiveRender(pageIndex, PageRenderScale, cancel);
+                return m_pdf->PageSizePoints(pageIndex);
+            });
+            if (cancel.IsCancelled()) co_return;
+            if (!pageSize)
+            {
+                // StreamRemainingPdfAsync renders it again once its bytes are in.
+                m_pagesAwaitingData.insert(pageIndex);
+                PdfPageImage().Source(nullptr);
+                PdfPatchLayer().Children().Clear();
+                StatusText().Text(winrt::hstring(L"Loading page " + std::to_wstring(pageIndex + 1) + L"..."));
+                co_return;
+            }
+            m_pageSizePoints = *pageSize;
+
+            auto lastPartial = std::chrono::steady_clock::now();
+            RenderSlice slice = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, continueRender);
+            while (slice.status == PdfRenderStatus::InProgress)
+            {
+                if (cancel.IsCancelled()) co_return;
+
+                if (std::chrono::steady_clock::now() - lastPartial >= PartialRenderInterval)
+                {
+                    // Heavy pages: show what has been drawn so far.
+                    auto snapshot = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]() { return m_pdf->ProgressiveRenderSnapshot(); });
+                    if (cancel.IsCancelled()) co_return;
+                    if (snapshot)
+                    {
+                        Microsoft::UI::Xaml::Media::Imaging::SoftwareBitmapSource partial;
+                        {
+                            TraceSpan span("ui.set_bitmap", pageIndex);
+                            co_await partial.SetBitmapAsync(snapshot);
+                        }
+                        if (cancel.IsCancelled()) co_return;
+                        PdfPageImage().Source(partial);
+                        PdfPatchLayer().Children().Clear();
+                    }
+                    lastPartial = std::chrono::steady_clock::now();
+                }
+
+                slice = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, continueRender);
+            }
+
+            if (slice.status == PdfRenderStatus::Cancelled || cancel.IsCancelled()) co_return;
+            if (slice.status != PdfRenderStatus::Done || !slice.bitmap)
+            {
+                StatusText().Text(L"PDF render failed");
+                co_return;
+            }
+
+            pageBitmap = slice.bitmap;
+        }
+        catch (std::exception const& ex)
+        {
+            std::wstring msg = L"PDF render failed: ";
+            msg += winrt::to_hstring(ex.what()).c_str();
+            StatusText().Text(winrt::hstring(msg));
+            co_return;
+        }
+        catch (...)
+        {
+            StatusText().Text(L"PDF render failed (unknown error)");
+            co_return;
+        }
+
+        // 2) Display in WinUI (this can fail with HRESULTs if the bitmap is incompatible)
+        try
+        {
+            Microsoft::UI::Xaml::Media::Imaging::SoftwareBitmapSource source;
+            {
+                TraceSpan span("ui.set_bitmap", pageIndex);
+                co_await source.SetBitmapAsync(pageBitmap);
+            }
+            if (cancel.IsCancelled()) co_return;
+            PdfPageImage().Source(source);
+            PdfPatchLayer().Children().Clear();
+            StatusText().Text(L"Ready");
+            UpdatePlacementHighlight();
+
+            // Already zoomed in: sharpen the visible part of the new page.
+            UpdateZoomTilesAsync();
+            SchedulePrefetch(pageIndex);
+            UpdateDocumentMemoryAsync();
+        }
+        catch (winrt::hresult_error const& e)
+        {
+            wchar_t hex[11]{};
+            swprintf_s(hex, L"%08X", static_cast<uint32_t>(e.code().value));
+
+            std::wstring msg = L"Display failed: 0x";
+            msg += hex;
+            msg += L" ";
+            msg += e.message().c_str();
+            StatusText().Text(winrt::hstring(msg));
+        }
+        catch (std::exception const& ex)
+        {
+            std::wstring msg = L"Display failed: ";
+            msg += winrt::to_hstring(ex.what()).c_str();
+            StatusText().Text(winrt::hstring(msg));
+        }
+        catch (...)
+        {
+            StatusText().Text(L"Display failed (unknown error)");
+        }
+    }
+
+    void MainWindow::SchedulePrefetch(int32_t centerPageIndex)
+    {
+        // Older prefetches target pages around a page the user has already left.
+        m_pdfExecutor.DropPending(PdfTaskPriority::Prefetch);
+
+        for (int32_t distance = 1; distance <= PrefetchRadius; ++distance)
+        {
+            for (int32_t pageIndex : { centerPageIndex + distance, centerPageIndex - distance })
+            {
+                if (pageIndex < 0 || pageIndex >= m_pageCount) continue;
+
+                // Fills the render cache; the next BeginProgressiveRender of this page is a hit.
+                m_pdfExecutor.Post(PdfTaskPriority::Prefetch, [this, pageIndex]()
+                {
+                    if (m_pdf->IsPageAvailable(pageIndex)) m_pdf->RenderPage(pageIndex, PageRenderScale);
+                });
+            }
+        }
+    }
+
+    void MainWindow::StartBackgroundScans()
+    {
+        m_backgroundCancel.Cancel();
+        m_backgroundCancel = PdfCancellationToken{};
+        m_pdfExecutor.Post(PdfTaskPriority::Background, [this, cancel = m_backgroundCancel]()
+        {
+            ScanNextFormFields(cancel);
+            IndexNextTextPage(cancel);
+        });
+    }
+
+    // Runs on the executor, FormScanPageBudget pages at a time until the scan is done.
+    void MainWindow::ScanNextFormFields(PdfCancellationToken cancel)
+    {
+        if (cancel.IsCancelled() || m_pdf->ContinueFormFieldScan(FormScanPageBudget)) return;
+        m_pdfExecutor.Post(PdfTaskPriority::Background, [this, cancel]() { ScanNextFormFields(cancel); });
+    }
+
+    // Runs on the executor: indexes one page, then queues itself for the next, so visible
+    // work is served in between and the order follows the page being viewed.
+    void MainWindow::IndexNextTextPage(PdfCancellationToken cancel)
+    {
+        if (cancel.IsCancelled()) return;
+
+        const int32_t pageCount = m_pdf->PageCount();
+        const int32_t focus = std::clamp(m_indexFocus.load(std::memory_order_relaxed), 0, (std::max)(pageCount - 1, 0));
+        int32_t pageIndex = -1;
+        for (int32_t distance = 0; distance < pageCount && pageIndex < 0; ++distance)
+        {
+            for (int32_t candidate : { focus + distance, focus - distance })
+            {
+                if (candidate >= 0 && candidate < pageCount && !m_textIndex.HasPage(candidate))
+                {
+                    pageIndex = candidate;
+                    break;
+                }
+            }
+        }
+        if (pageIndex < 0) return; // all pages indexed
+
+        try
+        {
+            m_textIndex.AddPage(pageIndex, m_pdf->ExtractPageText(pageIndex));
+        }
+        catch (...)
+        {
+            // A page whose text cannot be read counts as empty rather than being retried forever.
+            m_textIndex.AddPage(pageIndex, PdfPageText{});
+        }
+
+        m_pdfExecutor.Post(PdfTaskPriority::Background, [this, cancel]() { IndexNextTextPage(cancel); });
+    }
+
+    void MainWindow::ClearZoomTiles()
+    {
+        m_tileCancel.Cancel();
+        PdfTileLayer().Children().Clear();
+        m_zoomTiles.clear();
+        m_zoomTileScale = 0.0f;
+    }
+
+    void MainWindow::PdfScrollViewer_ViewChanged(Windows::Foundation::IInspectable const&, Controls::ScrollViewerViewChangedEventArgs const& args)
+    {
+        // Wait for pans and pinches to settle instead of rendering every frame.
+        if (args.IsIntermediate()) return;
+        UpdateZoomTilesAsync();
+    }
+
+    winrt::fire_and_forget MainWindow::UpdateZoomTilesAsync()
+    {
+        auto lifetime = get_strong();
+        if (m_pageCount <= 0 || m_pageSizePoints.width <= 0.0) co_return;
+
+        const double imageWidthDip = PdfPageImage().ActualWidth();
+        if (imageWidthDip <= 0.0) co_return;
+
+        // Device pixels the page currently spans on screen, expressed as a render scale.
+        const double rasterizationScale = PdfPageImage().XamlRoot() ? PdfPageImage().XamlRoot().RasterizationScale() : 1.0;
+        const double pageWidthPxAtScale1 = m_pageSizePoints.width * (96.0 / 72.0);
+        const double screenScale = imageWidthDip * PdfScrollViewer().ZoomFactor() * rasterizationScale / pageWidthPxAtScale1;
+        const float tileScale = (std::min)(static_cast<float>(std::ceil(screenScale * 2.0) / 2.0), MaxZoomTileScale);
+
+        // The base page render is sharp enough; it also serves as the low-resolution
+        // fallback under tiles that have not been rendered yet.
+        if (tileScale <= PageRenderScale)
+        {
+            ClearZoomTiles();
+            co_return;
+        }
+        if (tileScale != m_zoomTileScale)
+        {
+            ClearZoomTiles();
+            m_zoomTileScale = tileScale;
+        }
+
+        m_tileCancel.Cancel();
+        m_tileCancel = PdfCancellationToken{};
+        PdfCancellationToken cancel = m_tileCancel;
+        const int32_t pageIndex = m_currentPageIndex;
+
+        // Visible part of the page, in image DIPs and then in tile-scale pixels.
+        const double pxPerDip = pageWidthPxAtScale1 * tileScale / imageWidthDip;
+        const Windows::Foundation::Rect viewport = PdfScrollViewer().TransformToVisual(PdfPageImage()).TransformBounds(
+            Windows::Foundation::Rect{ 0.0f, 0.0f, static_cast<float>(PdfScrollViewer().ViewportWidth()), static_cast<float>(PdfScrollViewer().ViewportHeight()) });
+
+        PdfRect viewportPx{};
+        viewportPx.x = viewport.X * pxPerDip;
+        viewportPx.y = viewport.Y * pxPerDip;
+        viewportPx.width = viewport.Width * pxPerDip;
+        viewportPx.height = viewport.Height * pxPerDip;
+
+        try
+        {
+            const std::vector<PdfTile> tiles = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, pageIndex, tileScale, viewportPx]()
+            {
+                return m_pdf->TilesInViewport(pageIndex, tileScale, viewportPx);
+            });
+            if (cancel.IsCancelled()) co_return;
+
+            // Tiles that scrolled out of view are released; their pixels stay in the tile cache.
+            std::set<std::pair<int32_t, int32_t>> wanted{};
+            for (PdfTile const& tile : tiles) wanted.emplace(tile.column, tile.row);
+
+            for (auto it = m_zoomTiles.begin(); it != m_zoomTiles.end();)
+            {
+                if (wanted.count(it->first) == 0)
+                {
+                    uint32_t index = 0;
+                    if (PdfTileLayer().Children().IndexOf(it->second, index)) PdfTileLayer().Children().RemoveAt(index);
+                    it = m_zoomTiles.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            for (PdfTile const& tile : tiles)
+            {
+                if (m_zoomTiles.count({ tile.column, tile.row }) != 0) continue;
+
+                auto bitmap = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, pageIndex, tileScale, tile]()
+                {
+                    return m_pdf->RenderTileToSoftwareBitmap(pageIndex, tileScale, tile);
+                });
+                if (cancel.IsCancelled()) co_return;
+
+                SoftwareBitmapSource source;
+                {
+                    TraceSpan span("ui.set_bitmap", pageIndex);
+                    co_await source.SetBitmapAsync(bitmap);
+                }
+                if (cancel.IsCancelled()) co_return;
+
+                Controls::Image image;
+                image.Source(source);
+                image.Stretch(Media::Stretch::Fill);
+                image.Width(bitmap.PixelWidth() / pxPerDip);
+                image.Height(bitmap.PixelHeight() / pxPerDip);
+                Controls::Canvas::SetLeft(image, tile.column * PdfDocumentHandler::TileSizePx / pxPerDip);
+                Controls::Canvas::SetTop(image, tile.row * PdfDocumentHandler::TileSizePx / pxPerDip);
+
+                PdfTileLayer().Children().Append(image);
+                m_zoomTiles.emplace(std::make_pair(tile.column, tile.row), image);
+            }
+        }
+        catch (...)
+        {
+            // Tiles are an enhancement; the base page render stays visible.
+        }
+    }
+
+    winrt::fire_and_forget MainWindow::OpenPdfButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        StatusText().Text(L"Picking PDF...");
+
+        Windows::Storage::Pickers::FileOpenPicker picker;
+        picker.FileTypeFilter().Append(L".pdf");
+
+        HWND hwnd = GetWindowHwnd(*this);
+        InitializePickerWithWindow(picker, hwnd);
+
+        Windows::Storage::StorageFile file = co_await picker.PickSingleFileAsync();
+        if (!file)
+        {
+            StatusText().Text(L"Open canceled");
+            co_return;
+        }
+
+        co_await LoadPdfFromFileAsync(file);
+    }
+
+    winrt::fire_and_forget MainWindow::DocumentPicker_SelectionChanged(Windows::Foundation::IInspectable const&, Controls::SelectionChangedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        if (m_updatingDocumentPicker) co_return;
+
+        const int32_t selectedIndex = DocumentPicker().SelectedIndex();
+        if (selectedIndex < 0 || static_cast<size_t>(selectedIndex) >= m_openDocuments.size()) co_return;
+
+        const PdfDocumentId id = m_openDocuments[static_cast<size_t>(selectedIndex)].id;
+        if (id != m_documentId) co_await ShowDocumentAsync(id);
+    }
+
+    // Closes the document on screen and shows the next one of the session, if any.
+    winrt::fire_and_forget MainWindow::CloseDocumentButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        if (m_openDocuments.empty()) co_return;
+        if (!m_pendingStamps.empty())
+        {
+            StatusText().Text(L"Save or undo the placed signatures before closing the document");
+            co_return;
+        }
+
+        const PdfDocumentId closingId = m_documentId;
+        auto closing = std::find_if(m_openDocuments.begin(), m_openDocuments.end(),
+            [closingId](OpenDocument const& document) { return document.id == closingId; });
+        if (closing == m_openDocuments.end()) co_return;
+        const size_t position = static_cast<size_t>(closing - m_openDocuments.begin());
+        m_openDocuments.erase(closing);
+
+        if (!m_openDocuments.empty())
+        {
+            co_await ShowDocumentAsync(m_openDocuments[(std::min)(position, m_openDocuments.size() - 1)].id);
+        }
+        else
+        {
+            ResetDocumentUi();
+            PdfPageImage().Source(nullptr);
+            PdfPatchLayer().Children().Clear();
+            DocInfoText().Text(L"(no file loaded)");
+            SetEmptyStateVisible(true);
+            UpdateNavigationUi();
+            UpdateDocumentPicker();
+            StatusText().Text(L"Ready");
+        }
+
+        // With nothing else to show, the slot stays as the empty document the next open loads into.
+        const PdfDocumentId shownId = m_documentId;
+        co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, closingId, shownId]()
+        {
+            if (closingId != shownId)
+            {
+                m_documents.Remove(closingId);
+            }
+            else
+            {
+                m_pdf->Close();
+            }
+        });
+        UpdateDocumentMemoryAsync();
+    }
+
+    winrt::fire_and_forget MainWindow::NextSignatureFieldButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        if (m_pageCount <= 0) co_return;
+
+        // The background scan has usually finished; if not, finish it now. Only widget
+        // dictionaries are read, so even long forms take a fraction of a second.
+        std::vector<PdfFormField> fields{};
+        bool scanned = false;
+        try
+        {
+            auto result = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]()
+            {
+                const bool done = m_pdf->ContinueFormFieldScan((std::numeric_limits<int32_t>::max)());
+                std::vector<PdfFormField> signatures{};
+                for (PdfFormField const& field : m_pdf->FormFields())
+                {
+                    if (field.type == PdfFormFieldType::Signature) signatures.push_back(field);
+                }
+                return std::make_pair(done, std::move(signatures));
+            });
+            scanned = result.first;
+            fields = std::move(result.second);
+        }
+        catch (std::exception const& ex)
+        {
+            StatusText().Text(winrt::hstring(L"Form field scan failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+            co_return;
+        }
+
+        if (fields.empty())
+        {
+            SearchResultText().Text(scanned ? L"No signature fields" : L"Signature fields are listed once the document has loaded");
+            co_return;
+        }
+
+        // After the selected field, or the first one from the page being viewed; wraps around.
+        size_t selected = fields.size();
+        if (m_placementAnchor && m_placementAnchor->insideBounds)
+        {
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                PdfFormField const& field = fields[i];
+                if (field.pageIndex == m_placementAnchor->pageIndex
+                    && field.rect.x == m_placementAnchor->bounds.x
+                    && field.rect.y == m_placementAnchor->bounds.y)
+                {
+                    selected = (i + 1) % fields.size();
+                    break;
+                }
+            }
+        }
+        if (selected == fields.size())
+        {
+            auto it = std::find_if(fields.begin(), fields.end(), [this](PdfFormField const& field) { return field.pageIndex >= m_currentPageIndex; });
+            selected = it == fields.end() ? 0 : static_cast<size_t>(it - fields.begin());
+        }
+
+        PdfFormField const& field = fields[selected];
+        m_placementAnchor = PlacementAnchor{ field.pageIndex, field.rect, true };
+
+        std::wstring message = L"Signature field " + std::to_wstring(selected + 1) + L" of " + std::to_wstring(fields.size());
+        if (!field.name.empty()) message += L" \"" + std::wstring(field.name.begin(), field.name.end()) + L"\"";
+        message += field.filled ? L" (signed)" : L" (empty)";
+        message += L", page " + std::to_wstring(field.pageIndex + 1);
+        SearchResultText().Text(winrt::hstring(message));
+
+        if (field.pageIndex != m_currentPageIndex)
+        {
+            ShowPage(field.pageIndex);
+        }
+        else
+        {
+            UpdatePlacementHighlight();
+        }
+    }
+
+    winrt::fire_and_forget MainWindow::PlaceSignatureButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+
+        if (m_pageCount <= 0)
+        {
+            StatusText().Text(L"Load a PDF first");
+            co_return;
+        }
+        if (m_streaming)
+        {
+            StatusText().Text(L"The PDF is still loading");
+            co_return;
+        }
+
+        // Stamp the strokes as vector paths: no RenderTargetBitmap capture on the UI thread,
+        // and the result stays sharp at any zoom.
+        EndActiveStroke();
+        if (m_signatureInk.Empty())
+        {
+            StatusText().Text(L"Draw a signature first");
+            co_return;
+        }
+        PdfInkSignature signature = m_signatureInk.ToCroppedInkSignature(SignatureStrokeThickness, SignatureStrokeArgb);
+
+        // The signature is cropped to its ink; fit it in the default box without stretching.
+        const double fit = (std::min)(SignatureBoxWidthPts / signature.canvasSize.width, SignatureBoxHeightPts / signature.canvasSize.height);
+        const double width = signature.canvasSize.width * fit;
+        const double height = signature.canvasSize.height * fit;
+        const int32_t pageIndex = m_currentPageIndex;
+
+        // Inside the selected signature field, next to the selected search match (e.g.
+        // "Signature:"), or else 1 inch from the bottom-left corner. PDF coordinates:
+        // origin bottom-left.
+        PdfRect rectInPdfPoints{ 72.0, 72.0, width, height };
+        const bool anchored = m_placementAnchor && m_placementAnchor->pageIndex == pageIndex;
+        if (anchored && m_placementAnchor->insideBounds)
+        {
+            rectInPdfPoints = FitInside(m_placementAnchor->bounds, signature.canvasSize.width, signature.canvasSize.height);
+        }
+        else if (anchored && pageIndex < static_cast<int32_t>(m_pageSizes.size()))
+        {
+            rectInPdfPoints = SignatureRectNear(m_placementAnchor->bounds, m_pageSizes[static_cast<size_t>(pageIndex)], width, height);
+        }
+
+        StatusText().Text(L"Stamping signature...");
+        try
+        {
+            co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, pageIndex, signature = std::move(signature), rectInPdfPoints]()
+            {
+                m_pdf->StampSignatureStrokes(pageIndex, signature, rectInPdfPoints);
+            });
+
+            co_await ShowStampChangesAsync(pageIndex);
+            StatusText().Text(L"Signature placed: drag it to move it, Ctrl+Z to undo");
+        }
+        catch (std::exception const& ex)
+        {
+            StatusText().Text(winrt::hstring(L"Stamping failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+        }
+    }
+
+    winrt::fire_and_forget MainWindow::UndoStampButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        if (m_pageCount <= 0 || m_draggedStamp) co_return;
+
+        try
+        {
+            const int32_t pageIndex = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]() { return m_pdf->UndoStamp(); });
+            if (pageIndex < 0) co_return;
+            co_await ShowStampChangesAsync(pageIndex);
+            StatusText().Text(L"Undone");
+        }
+        catch (std::exception const& ex)
+        {
+            StatusText().Text(winrt::hstring(L"Undo failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+        }
+    }
+
+    winrt::fire_and_forget MainWindow::RedoStampButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        if (m_pageCount <= 0 || m_draggedStamp) co_return;
+
+        try
+        {
+            const int32_t pageIndex = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]() { return m_pdf->RedoStamp(); });
+            if (pageIndex < 0) co_return;
+            co_await ShowStampChangesAsync(pageIndex);
+            StatusText().Text(L"Redone");
+        }
+        catch (std::exception const& ex)
+        {
+            StatusText().Text(winrt::hstring(L"Redo failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+        }
+    }
+
+    // After a journal step on pageIndex: mirror the journal, then redraw that page (going
+    // to it if needed). Only the composite changes; the page's cached raster is reused, and
+    // on the page being shown only the rects the step touched are redrawn.
+    winrt::Windows::Foundation::IAsyncAction MainWindow::ShowStampChangesAsync(int32_t pageIndex)
+    {
+        StampJournalState state = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this]()
+        {
+            return StampJournalState{ m_pdf->PendingStamps(), m_pdf->CanUndoStamp(), m_pdf->CanRedoStamp() };
+        });
+        std::vector<PdfRect> damaged = ChangedStampRects(m_pendingStamps, state.pending, pageIndex);
+        m_pendingStamps = std::move(state.pending);
+        m_canUndoStamp = state.canUndo;
+        m_canRedoStamp = state.canRedo;
+        UpdateNavigationUi();
+
+        RefreshPageImages(pageIndex);
+        if (pageIndex != m_currentPageIndex)
+        {
+            ShowPage(pageIndex);
+        }
+        else if (!m_continuousView)
+        {
+            co_await PatchCurrentPageAsync(std::move(damaged));
+        }
+    }
+
+    // Redraws damagedPts (page points) of the page on screen without replacing its image:
+    // each rect is rendered at PageRenderScale on its own and laid over PdfPageImage on
+    // PdfPatchLayer, so only those pixels are rasterized and uploaded. Falls back to a
+    // full render when there is no image to patch or too many patches have piled up.
+    winrt::Windows::Foundation::IAsyncAction MainWindow::PatchCurrentPageAsync(std::vector<PdfRect> damagedPts)
+    {
+        if (damagedPts.empty()) co_return;
+
+        const bool patchable = PdfPageImage().Source() != nullptr
+            && m_pageSizePoints.width > 0.0
+            && PdfPageImage().ActualWidth() > 0.0
+            && PdfPatchLayer().Children().Size() + damagedPts.size() <= MaxPagePatches;
+        if (!patchable)
+        {
+            co_await RenderCurrentPageAsync();
+            co_return;
+        }
+
+        // A page render still under way includes the change when it lands.
+        PdfCancellationToken cancel = m_renderCancel;
+        const int32_t pageIndex = m_currentPageIndex;
+        const double pxPerPoint = PageRenderScale * (96.0 / 72.0);
+        bool patched = true;
+
+        for (PdfRect const& rect : damagedPts)
+        {
+            try
+            {
+                auto [regionPx, bitmap] = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, pageIndex, rect]()
+                {
+                    const PdfRect px = m_pdf->PageRectToPixels(pageIndex, PageRenderScale, rect);
+                    if (px.width <= 0.0 || px.height <= 0.0) return std::make_pair(px, Windows::Graphics::Imaging::SoftwareBitmap{ nullptr });
+                    return std::make_pair(px, m_pdf->RenderPageRegionToSoftwareBitmap(pageIndex, PageRenderScale, px));
+                });
+                if (cancel.IsCancelled() || pageIndex != m_currentPageIndex) co_return;
+                if (!bitmap) continue;
+
+                SoftwareBitmapSource source;
+                {
+                    TraceSpan span("ui.set_bitmap", pageIndex);
+                    co_await source.SetBitmapAsync(bitmap);
+                }
+                if (cancel.IsCancelled() || pageIndex != m_currentPageIndex) co_return;
+
+                // Back to page points from the whole pixels the patch covers.
+                Controls::Image image;
+                image.Source(source);
+                image.Stretch(Media::Stretch::Fill);
+                const PdfRect covered{
+                    regionPx.x / pxPerPoint,
+                    m_pageSizePoints.height - (regionPx.y + regionPx.height) / pxPerPoint,
+                    regionPx.width / pxPerPoint,
+                    regionPx.height / pxPerPoint };
+                if (!PlaceOverPage(image, covered, 0.0))
+                {
+                    patched = false;
+                    break;
+                }
+                PdfPatchLayer().Children().Append(image);
+            }
+            catch (...)
+            {
+                patched = false;
+                break;
+            }
+        }
+
+        if (!patched)
+        {
+            co_await RenderCurrentPageAsync();
+            co_return;
+        }
+
+        // Zoom tiles over the damage were drawn before it; drop them and fetch them again.
+        if (m_zoomTileScale > 0.0f)
+        {
+            const double tilePts = PdfDocumentHandler::TileSizePx / (m_zoomTileScale * (96.0 / 72.0));
+            for (auto it = m_zoomTiles.begin(); it != m_zoomTiles.end();)
+            {
+                const double left = it->first.first * tilePts;
+                const double top = it->first.second * tilePts;
+                const bool stale = std::any_of(damagedPts.begin(), damagedPts.end(), [&](PdfRect const& rect)
+                {
+                    const double rectTop = m_pageSizePoints.height - rect.y - rect.height;
+                    return rect.x < left + tilePts && left < rect.x + rect.width
+                        && rectTop < top + tilePts && top < rectTop + rect.height;
+                });
+                if (stale)
+                {
+                    uint32_t index = 0;
+                    if (PdfTileLayer().Children().IndexOf(it->second, index)) PdfTileLayer().Children().RemoveAt(index);
+                    it = m_zoomTiles.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            UpdateZoomTilesAsync();
+        }
+    }
+
+    winrt::fire_and_forget MainWindow::SaveSignedPdfButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+
+        if (m_pageCount <= 0)
+        {
+            StatusText().Text(L"Load a PDF first");
+            co_return;
+        }
+        if (m_streaming)
+        {
+            StatusText().Text(L"The PDF is still loading");
+            co_return;
+        }
+
+        StatusText().Text(L"Picking save location...");
+
+        Windows::Storage::Pickers::FileSavePicker picker;
+        picker.SuggestedFileName(L"signed");
+        picker.FileTypeChoices().Insert(L"PDF Document", single_threaded_vector<hstring>({ L".pdf" }));
+
+        HWND hwnd = GetWindowHwnd(*this);
+        InitializePickerWithWindow(picker, hwnd);
+
+        Windows::Storage::StorageFile outFile = co_await picker.PickSaveFileAsync();
+        if (!outFile)
+        {
+            StatusText().Text(L"Save canceled");
+            co_return;
+        }
+
+        StatusText().Text(L"Saving...");
+
+        // Incremental: existing signatures in the document stay valid, and the original
+        // bytes are not written again when the output starts from the original file.
+        PdfSaveStats stats{};
+        try
+        {
+            stats = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, outputPath = std::wstring(outFile.Path())]()
+            {
+                return m_pdf->SaveAs(outputPath, PdfSaveMode::Incremental);
+            });
+        }
+        catch (std::exception const& ex)
+        {
+            StatusText().Text(winrt::hstring(L"Save failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+            co_return;
+        }
+
+        // Saving committed the placed signatures into their pages; they are final now.
+        m_pendingStamps.clear();
+        m_canUndoStamp = false;
+        m_canRedoStamp = false;
+        UpdateNavigationUi();
+
+        wchar_t summary[96]{};
+        swprintf_s(summary, L"Saved (%.1f KB written in %.0f ms)", stats.bytesWritten / 1024.0, stats.elapsedMs);
+        StatusText().Text(summary);
+    }
+
+    // Applies to stamps committed from now on, i.e. at the next save.
+    winrt::fire_and_forget MainWindow::StampAsAnnotationToggle_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+        const PdfStampMode mode = unbox_value_or<bool>(StampAsAnnotationToggle().IsChecked(), false)
+            ? PdfStampMode::Annotation
+            : PdfStampMode::PageContent;
+        try
+        {
+            co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, mode]() { m_pdf->SetStampMode(mode); });
+            StatusText().Text(mode == PdfStampMode::Annotation
+                ? L"Signatures will be saved as stamp annotations"
+                : L"Signatures will be saved into the page content");
+        }
+        catch (std::exception const& ex)
+        {
+            StampAsAnnotationToggle().IsChecked(mode != PdfStampMode::Annotation);
+            StatusText().Text(winrt::hstring(L"Could not change the stamp mode: " + std::wstring(winrt::to_hstring(ex.what()))));
+        }
+    }
+
+    void MainWindow::RecordTraceToggle_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        const bool record = unbox_value_or<bool>(RecordTraceToggle().IsChecked(), false);
+        if (record)
+        {
+            // Each recording starts from a clean buffer so the export covers just this session.
+            ClearTrace();
+            SetTraceEnabled(true);
+            StatusText().Text(L"Recording trace");
+            return;
+        }
+
+        SetTraceEnabled(false);
+        wchar_t summary[64]{};
+        swprintf_s(summary, L"Trace stopped (%zu spans)", TraceSnapshot().size());
+        StatusText().Text(summary);
+    }
+
+    winrt::fire_and_forget MainWindow::ExportTraceButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        auto lifetime = get_strong();
+
+        const std::vector<TraceEvent> events = TraceSnapshot();
+        if (events.empty())
+        {
+            StatusText().Text(L"Nothing traced yet: turn on Record trace first");
+            co_return;
+        }
+
+        Windows::Storage::Pickers::FileSavePicker picker;
+        picker.SuggestedFileName(L"put-a-signature-trace");
+        picker.FileTypeChoices().Insert(L"Chrome trace", single_threaded_vector<hstring>({ L".json" }));
+
+        HWND hwnd = GetWindowHwnd(*this);
+        InitializePickerWithWindow(picker, hwnd);
+
+        Windows::Storage::StorageFile outFile = co_await picker.PickSaveFileAsync();
+        if (!outFile)
+        {
+            StatusText().Text(L"Export canceled");
+            co_return;
+        }
+
+        try
+        {
+            co_await Windows::Storage::FileIO::WriteTextAsync(outFile, winrt::to_hstring(ExportChromeTrace()));
+        }
+        catch (winrt::hresult_error const& e)
+        {
+            StatusText().Text(L"Trace export failed: " + e.message());
+            co_return;
+        }
+
+        auto slowest = std::max_element(events.begin(), events.end(), [](TraceEvent const& a, TraceEvent const& b) { return a.durationNs < b.durationNs; });
+        wchar_t summary[128]{};
+        swprintf_s(summary, L"Trace saved (%zu spans, slowest: %hs %.0f ms)", events.size(), slowest->name, slowest->durationNs / 1e6);
+        StatusText().Text(summary);
+    }
+
+    void MainWindow::ClearSignatureButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        EndActiveStroke();
+        m_signatureInk.Clear();
+        SignatureCanvas().Children().Clear();
+        StatusText().Text(L"Signature cleared");
+    }
+
+    void MainWindow::PrevPageButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        if (m_pageCount <= 0) return;
+        if (m_currentPageIndex <= 0) return;
+        ShowPage(m_currentPageIndex - 1);
+    }
+
+    void MainWindow::NextPageButton_Click(Windows::Foundation::IInspectable const&, RoutedEventArgs const&)
+    {
+        if (m_pageCount <= 0) return;
+        if ((m_currentPageIndex + 1) >= m_pageCount) return;
+        ShowPage(m_currentPageIndex + 1);
+    }
+
+    winrt::fire_and_forget MainWindow::PageNumberBox_KeyDown(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& args)
+    {
+        auto lifetime = get_strong();
         if (args.Key() != Windows::System::VirtualKey::Enter) co_return;
-        if (!m_pdf.IsLoaded() || m_pageCount <= 0) co_return;
+        if (m_pageCount <= 0) co_return;
 
         try
         {
@@ -368,9 +1861,7 @@ namespace winrt::Put_A_Signature::implementation
             if (requested < 1) requested = 1;
             if (requested > m_pageCount) requested = m_pageCount;
 
-            m_currentPageIndex = requested - 1;
-            UpdateNavigationUi();
-            co_await RenderCurrentPageAsync();
+            ShowPage(requested - 1);
         }
         catch (...)
         {
@@ -379,6 +1870,241 @@ namespace winrt::Put_A_Signature::implementation
         }
     }
 
+    winrt::fire_and_forget MainWindow::SearchBox_KeyDown(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& args)
+    {
+        auto lifetime = get_strong();
+        if (args.Key() != Windows::System::VirtualKey::Enter) co_return;
+        args.Handled(true);
+        if (m_pageCount <= 0) co_return;
+
+        // Enter: next match, Shift+Enter: previous one.
+        const bool backwards = (Microsoft::UI::Input::InputKeyboardSource::GetKeyStateForCurrentThread(Windows::System::VirtualKey::Shift)
+            & Windows::UI::Core::CoreVirtualKeyStates::Down) == Windows::UI::Core::CoreVirtualKeyStates::Down;
+        const std::wstring query{ SearchBox().Text() };
+
+        // Ask the index every time: it may have grown since the last search, and a query
+        // takes milliseconds.
+        const std::u16string text(query.begin(), query.end());
+        auto found = co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, text]()
+        {
+            return std::make_pair(m_textIndex.Find(text, MaxSearchMatches), m_textIndex.IndexedPageCount());
+        });
+
+        const bool sameQuery = query == m_searchQuery && m_searchAnchor.has_value();
+        m_searchQuery = query;
+        m_searchMatches = std::move(found.first);
+        const size_t indexedPages = found.second;
+
+        if (m_searchMatches.empty())
+        {
+            m_searchAnchor.reset();
+            m_placementAnchor.reset();
+            UpdatePlacementHighlight();
+
+            std::wstring message = query.empty() ? std::wstring{} : L"No matches";
+            if (!query.empty() && indexedPages < static_cast<size_t>(m_pageCount))
+            {
+                message += L" yet (" + std::to_wstring(indexedPages) + L" of " + std::to_wstring(m_pageCount) + L" pages indexed)";
+            }
+            SearchResultText().Text(winrt::hstring(message));
+            co_return;
+        }
+
+        // Step from the selected match, or start at the page being viewed.
+        auto before = [](PdfTextMatch const& a, PdfTextMatch const& b)
+        {
+            return a.pageIndex != b.pageIndex ? a.pageIndex < b.pageIndex : a.charIndex < b.charIndex;
+        };
+        auto const first = m_searchMatches.begin();
+        auto const last = m_searchMatches.end();
+        size_t selected = 0;
+        if (sameQuery && backwards)
+        {
+            const auto it = std::lower_bound(first, last, *m_searchAnchor, before);
+            selected = it == first ? m_searchMatches.size() - 1 : static_cast<size_t>(it - first) - 1;
+        }
+        else if (sameQuery)
+        {
+            const auto it = std::upper_bound(first, last, *m_searchAnchor, before);
+            selected = it == last ? 0 : static_cast<size_t>(it - first);
+        }
+        else
+        {
+            PdfTextMatch here{};
+            here.pageIndex = m_currentPageIndex;
+            const auto it = std::lower_bound(first, last, here, before);
+            selected = it == last ? 0 : static_cast<size_t>(it - first);
+        }
+
+        ShowSearchMatch(selected, indexedPages);
+    }
+
+    void MainWindow::ShowSearchMatch(size_t matchIndex, size_t indexedPages)
+    {
+        PdfTextMatch const& match = m_searchMatches[matchIndex];
+        m_searchAnchor = match;
+
+        // A match without a box (text with no glyph positions) gives nothing to place next to.
+        if (match.bounds.width > 0.0 || match.bounds.height > 0.0)
+        {
+            m_placementAnchor = PlacementAnchor{ match.pageIndex, match.bounds, false };
+        }
+        else
+        {
+            m_placementAnchor.reset();
+        }
+
+        std::wstring message = std::to_wstring(matchIndex + 1) + L" of " + std::to_wstring(m_searchMatches.size());
+        if (m_searchMatches.size() >= MaxSearchMatches) message += L"+";
+        message += L", page " + std::to_wstring(match.pageIndex + 1);
+        if (indexedPages < static_cast<size_t>(m_pageCount))
+        {
+            message += L" (" + std::to_wstring(indexedPages) + L" of " + std::to_wstring(m_pageCount) + L" pages indexed)";
+        }
+        SearchResultText().Text(winrt::hstring(message));
+
+        if (match.pageIndex != m_currentPageIndex)
+        {
+            ShowPage(match.pageIndex); // highlights once the page is on screen
+        }
+        else
+        {
+            UpdatePlacementHighlight();
+        }
+    }
+
+    // Outlines the placement anchor on the single-page view.
+    void MainWindow::UpdatePlacementHighlight()
+    {
+        auto highlight = PlacementHighlight();
+        const bool visible = m_placementAnchor
+            && m_placementAnchor->pageIndex == m_currentPageIndex
+            && PlaceOverPage(highlight, m_placementAnchor->bounds, 2.0);
+        highlight.Visibility(visible ? Visibility::Visible : Visibility::Collapsed);
+    }
+
+    // Puts an element of the canvas over PdfPageImage around `bounds` (page points).
+    // False while the single-page view has no page to place it on.
+    bool MainWindow::PlaceOverPage(FrameworkElement const& element, PdfRect const& bounds, double padding)
+    {
+        const double imageWidthDip = PdfPageImage().ActualWidth();
+        if (m_continuousView || m_pageSizePoints.width <= 0.0 || imageWidthDip <= 0.0) return false;
+
+        // Page points (bottom-left origin) to image DIPs (top-left origin).
+        const double dipPerPoint = imageWidthDip / m_pageSizePoints.width;
+        Controls::Canvas::SetLeft(element, bounds.x * dipPerPoint - padding);
+        Controls::Canvas::SetTop(element, (m_pageSizePoints.height - bounds.y - bounds.height) * dipPerPoint - padding);
+        element.Width(bounds.width * dipPerPoint + 2.0 * padding);
+        element.Height(bounds.height * dipPerPoint + 2.0 * padding);
+        return true;
+    }
+
+    void MainWindow::PdfPageImage_PointerPressed(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
+    {
+        const double imageWidthDip = PdfPageImage().ActualWidth();
+        if (m_continuousView || m_draggedStamp || m_pageSizePoints.width <= 0.0 || imageWidthDip <= 0.0) return;
+
+        // Topmost pending stamp under the pointer; committed ones are part of the page.
+        auto pt = args.GetCurrentPoint(PdfPageImage());
+        const double pointsPerDip = m_pageSizePoints.width / imageWidthDip;
+        const double x = pt.Position().X * pointsPerDip;
+        const double y = m_pageSizePoints.height - pt.Position().Y * pointsPerDip;
+        auto hit = std::find_if(m_pendingStamps.rbegin(), m_pendingStamps.rend(), [this, x, y](PdfStamp const& stamp)
+        {
+            return stamp.pageIndex == m_currentPageIndex
+                && x >= stamp.rect.x && x <= stamp.rect.x + stamp.rect.width
+                && y >= stamp.rect.y && y <= stamp.rect.y + stamp.rect.height;
+        });
+        if (hit == m_pendingStamps.rend()) return;
+
+        m_draggedStamp = *hit;
+        m_dragStart = pt.Position();
+        m_dragPointerId = pt.PointerId();
+        PdfPageImage().CapturePointer(args.Pointer());
+
+        // Only the outline follows the pointer; the stamp moves (one journal step) on release.
+        PlaceOverPage(StampDragOutline(), hit->rect, 0.0);
+        StampDragOutline().Visibility(Visibility::Visible);
+        args.Handled(true);
+    }
+
+    void MainWindow::PdfPageImage_PointerMoved(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
+    {
+        if (!m_draggedStamp) return;
+
+        auto pt = args.GetCurrentPoint(PdfPageImage());
+        if (pt.PointerId() != m_dragPointerId) return;
+
+        if (auto rect = DraggedStampRect(pt.Position()))
+        {
+            PlaceOverPage(StampDragOutline(), *rect, 0.0);
+        }
+        args.Handled(true);
+    }
+
+    winrt::fire_and_forget MainWindow::PdfPageImage_PointerReleased(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
+    {
+        auto lifetime = get_strong();
+        if (!m_draggedStamp) co_return;
+
+        auto pt = args.GetCurrentPoint(PdfPageImage());
+        if (pt.PointerId() != m_dragPointerId) co_return;
+
+        const std::optional<PdfRect> rect = DraggedStampRect(pt.Position());
+        const PdfStamp stamp = *m_draggedStamp;
+        m_draggedStamp.reset();
+        PdfPageImage().ReleasePointerCapture(args.Pointer());
+        args.Handled(true);
+
+        if (rect && (rect->x != stamp.rect.x || rect->y != stamp.rect.y))
+        {
+            try
+            {
+                co_await m_pdfExecutor.Run(PdfTaskPriority::Visible, [this, id = stamp.id, moved = *rect]()
+                {
+                    m_pdf->MoveStamp(id, moved);
+                });
+                co_await ShowStampChangesAsync(stamp.pageIndex);
+                StatusText().Text(L"Signature moved");
+            }
+            catch (std::exception const& ex)
+            {
+                StatusText().Text(winrt::hstring(L"Move failed: " + std::wstring(winrt::to_hstring(ex.what()))));
+            }
+        }
+        StampDragOutline().Visibility(Visibility::Collapsed);
+    }
+
+    void MainWindow::PdfPageImage_PointerCanceled(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
+    {
+        if (!m_draggedStamp) return;
+
+        m_draggedStamp.reset();
+        PdfPageImage().ReleasePointerCapture(args.Pointer());
+        StampDragOutline().Visibility(Visibility::Collapsed);
+    }
+
+    // Where the dragged stamp lands if dropped at `position` (on PdfPageImage), kept on the page.
+    std::optional<PdfRect> MainWindow::DraggedStampRect(Windows::Foundation::Point position)
+    {
+        const double imageWidthDip = PdfPageImage().ActualWidth();
+        if (!m_draggedStamp || imageWidthDip <= 0.0) return std::nullopt;
+
+        const double pointsPerDip = m_pageSizePoints.width / imageWidthDip;
+        PdfRect rect = m_draggedStamp->rect;
+        rect.x = std::clamp(rect.x + (position.X - m_dragStart.X) * pointsPerDip, 0.0, (std::max)(0.0, m_pageSizePoints.width - rect.width));
+        rect.y = std::clamp(rect.y - (position.Y - m_dragStart.Y) * pointsPerDip, 0.0, (std::max)(0.0, m_pageSizePoints.height - rect.height));
+        return rect;
+    }
+
+    void MainWindow::PdfPageImage_SizeChanged(Windows::Foundation::IInspectable const&, SizeChangedEventArgs const&)
+    {
+        UpdatePlacementHighlight();
+
+        // Patches were laid out for the old size; a fresh render replaces them.
+        if (PdfPatchLayer().Children().Size() > 0) RenderCurrentPageAsync();
+    }
+
     void MainWindow::PdfDropZone_DragOver(Windows::Foundation::IInspectable const&, DragEventArgs const& e)
     {
         auto def = e.GetDeferral();
@@ -432,21 +2158,25 @@ namespace winrt::Put_A_Signature::implementation
     void MainWindow::SignatureCanvas_PointerPressed(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
     {
         // Start a new stroke.
+        EndActiveStroke();
         auto pt = args.GetCurrentPoint(SignatureCanvas());
         m_activePointerId = pt.PointerId();
         m_isDrawing = true;
 
         SignatureCanvas().CapturePointer(args.Pointer());
 
+        const auto position = pt.Position();
+        m_signatureInk.BeginStroke({ position.X, position.Y });
+
         Microsoft::UI::Xaml::Shapes::Polyline line;
-        line.StrokeThickness(3.0);
+        line.StrokeThickness(SignatureStrokeThickness);
         line.StrokeLineJoin(Microsoft::UI::Xaml::Media::PenLineJoin::Round);
         line.StrokeStartLineCap(Microsoft::UI::Xaml::Media::PenLineCap::Round);
         line.StrokeEndLineCap(Microsoft::UI::Xaml::Media::PenLineCap::Round);
         line.Stroke(Microsoft::UI::Xaml::Media::SolidColorBrush(Microsoft::UI::Colors::Black()));
 
         auto points = line.Points();
-        points.Append(pt.Position());
+        points.Append(position);
 
         SignatureCanvas().Children().Append(line);
         m_activeStroke = line;
@@ -461,8 +2191,12 @@ namespace winrt::Put_A_Signature::implementation
         auto pt = args.GetCurrentPoint(SignatureCanvas());
         if (pt.PointerId() != m_activePointerId) return;
 
-        auto points = m_activeStroke.Points();
-        points.Append(pt.Position());
+        // Only samples the model keeps reach the Polyline (each append costs a layout pass).
+        const auto position = pt.Position();
+        if (m_signatureInk.AddPoint({ position.X, position.Y }))
+        {
+            m_activeStroke.Points().Append(position);
+        }
 
         args.Handled(true);
     }
@@ -472,9 +2206,7 @@ namespace winrt::Put_A_Signature::implementation
         auto pt = args.GetCurrentPoint(SignatureCanvas());
         if (pt.PointerId() == m_activePointerId)
         {
-            m_isDrawing = false;
-            m_activePointerId = 0;
-            m_activeStroke = nullptr;
+            EndActiveStroke();
             SignatureCanvas().ReleasePointerCapture(args.Pointer());
         }
         args.Handled(true);
@@ -482,10 +2214,28 @@ namespace winrt::Put_A_Signature::implementation
 
     void MainWindow::SignatureCanvas_PointerCanceled(Windows::Foundation::IInspectable const&, Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args)
     {
+        EndActiveStroke();
+        SignatureCanvas().ReleasePointerCapture(args.Pointer());
+        args.Handled(true);
+    }
+
+    void MainWindow::EndActiveStroke()
+    {
+        if (m_activeStroke && m_signatureInk.IsDrawing())
+        {
+            // Swap the live trace for the simplified stroke the model keeps.
+            m_signatureInk.EndStroke();
+
+            std::vector<Windows::Foundation::Point> simplified{};
+            for (auto const& point : m_signatureInk.Stroke(m_signatureInk.StrokeCount() - 1))
+            {
+                simplified.push_back({ point.x, point.y });
+            }
+            m_activeStroke.Points().ReplaceAll(simplified);
+        }
+
         m_isDrawing = false;
         m_activePointerId = 0;
         m_activeStroke = nullptr;
-        SignatureCanvas().ReleasePointerCapture(args.Pointer());
-        args.Handled(true);
     }
 }
@@ -3,6 +3,19 @@
 #include "MainWindow.g.h"
 
 #include "PdfDocumentHandler.h"
+#include "PdfDocumentPool.h"
+#include "PdfExecutor.h"
+#include "SignatureInk.h"
+#include "TextIndex.h"
+
+#include <atomic>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace winrt::Put_A_Signature::implementation
 {
@@ -11,13 +24,22 @@ namespace winrt::Put_A_Signature::implementation
         MainWindow();
 
         winrt::fire_and_forget OpenPdfButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        winrt::fire_and_forget NextSignatureFieldButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         winrt::fire_and_forget PlaceSignatureButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        winrt::fire_and_forget UndoStampButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        winrt::fire_and_forget RedoStampButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         winrt::fire_and_forget SaveSignedPdfButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         void ClearSignatureButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
 
         void PrevPageButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         void NextPageButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         winrt::fire_and_forget PageNumberBox_KeyDown(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& args);
+        winrt::fire_and_forget SearchBox_KeyDown(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& args);
+        void PdfPageImage_SizeChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::SizeChangedEventArgs const& args);
+        void PdfPageImage_PointerPressed(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
+        void PdfPageImage_PointerMoved(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
+        winrt::fire_and_forget PdfPageImage_PointerReleased(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
+        void PdfPageImage_PointerCanceled(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
 
         void PdfDropZone_DragOver(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::DragEventArgs const& e);
         winrt::fire_and_forget PdfDropZone_Drop(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::DragEventArgs const& e);
@@ -27,19 +49,129 @@ namespace winrt::Put_A_Signature::implementation
         void SignatureCanvas_PointerReleased(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
         void SignatureCanvas_PointerCanceled(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Input::PointerRoutedEventArgs const& args);
 
+        void ContinuousViewToggle_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void ThumbnailList_ItemClick(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::ItemClickEventArgs const& args);
+        void ThumbnailList_ContainerContentChanging(winrt::Microsoft::UI::Xaml::Controls::ListViewBase const& sender, winrt::Microsoft::UI::Xaml::Controls::ContainerContentChangingEventArgs const& args);
+        void PdfPageList_ContainerContentChanging(winrt::Microsoft::UI::Xaml::Controls::ListViewBase const& sender, winrt::Microsoft::UI::Xaml::Controls::ContainerContentChangingEventArgs const& args);
+
+        void PdfScrollViewer_ViewChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::ScrollViewerViewChangedEventArgs const& args);
+
+        winrt::fire_and_forget DocumentPicker_SelectionChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::SelectionChangedEventArgs const& args);
+        winrt::fire_and_forget CloseDocumentButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        winrt::fire_and_forget StampAsAnnotationToggle_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void RecordTraceToggle_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        winrt::fire_and_forget ExportTraceButton_Click(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+
     private:
         winrt::Windows::Foundation::IAsyncAction LoadPdfFromFileAsync(winrt::Windows::Storage::StorageFile const& file);
+        winrt::Windows::Foundation::IAsyncAction ShowDocumentAsync(PdfDocumentId id);
+        void ResetDocumentUi();
+        void UpdateDocumentPicker();
+        winrt::fire_and_forget UpdateDocumentMemoryAsync();
+        winrt::fire_and_forget StreamRemainingPdfAsync(winrt::Windows::Storage::Streams::IRandomAccessStream stream, FileByteRange next, PdfCancellationToken cancel);
         winrt::Windows::Foundation::IAsyncAction RenderCurrentPageAsync();
+        void SchedulePrefetch(int32_t centerPageIndex);
+        winrt::fire_and_forget UpdateZoomTilesAsync();
+        void ClearZoomTiles();
+        void ShowPage(int32_t pageIndex);
+        void ResetPageLists();
+        void RefreshPageImages(int32_t pageIndex);
+        winrt::fire_and_forget LoadPageImageAsync(winrt::Microsoft::UI::Xaml::Controls::Image image, int32_t pageIndex, bool thumbnail);
         void UpdateNavigationUi();
+        void StartBackgroundScans();
+        void IndexNextTextPage(PdfCancellationToken cancel);
+        void ScanNextFormFields(PdfCancellationToken cancel);
+        void ShowSearchMatch(size_t matchIndex, size_t indexedPages);
+        void UpdatePlacementHighlight();
+        bool PlaceOverPage(winrt::Microsoft::UI::Xaml::FrameworkElement const& element, PdfRect const& bounds, double padding);
+        winrt::Windows::Foundation::IAsyncAction ShowStampChangesAsync(int32_t pageIndex);
+        winrt::Windows::Foundation::IAsyncAction PatchCurrentPageAsync(std::vector<PdfRect> damagedPts);
+        std::optional<PdfRect> DraggedStampRect(winrt::Windows::Foundation::Point position);
         void SetEmptyStateVisible(bool visible);
 
-        PdfDocumentHandler m_pdf{};
+        // The session's documents. m_documents, and m_pdf (the handler of the document on
+        // screen, m_documentId), are only touched on m_pdfExecutor's thread. The executor
+        // is declared after them so it is destroyed (and its thread joined) first.
+        PdfDocumentPool m_documents{};
+        PdfDocumentId m_documentId{ m_documents.Add() };
+        PdfDocumentHandler* m_pdf{ &m_documents.Use(m_documentId) };
+        PdfExecutor m_pdfExecutor{};
+
+        // The UI's list of loaded documents, in the order they were opened, with the page
+        // each was left on.
+        struct OpenDocument
+        {
+            PdfDocumentId id{};
+            winrt::hstring name{};
+            int32_t pageIndex{};
+        };
+        std::vector<OpenDocument> m_openDocuments{};
+        bool m_updatingDocumentPicker{ false };
+
+        PdfCancellationToken m_renderCancel{};
+
+        // Progressive load of a document read through StorageFile: cancelled when another
+        // document is opened. Pages that could not be shown yet because their bytes had not
+        // arrived are re-requested as they land. Saving and stamping wait until every byte
+        // is in (m_streaming clears).
+        PdfCancellationToken m_loadCancel{};
+        std::set<int32_t> m_pagesAwaitingData{};
+        bool m_streaming{ false };
         int32_t m_currentPageIndex{ 0 };
         int32_t m_pageCount{ 0 };
+        PdfSize m_pageSizePoints{};
 
+        // Continuous view and thumbnail strip. Items are boxed page indices; images are
+        // requested only for realized containers and cancelled when a container is recycled.
+        bool m_continuousView{ false };
+        std::vector<PdfSize> m_pageSizes{};
+        std::unordered_map<int32_t, PdfCancellationToken> m_thumbnailRequests{};
+        std::unordered_map<int32_t, PdfCancellationToken> m_pageImageRequests{};
+
+        // Zoom tiles currently on PdfTileLayer, keyed by (column, row) at m_zoomTileScale.
+        std::map<std::pair<int32_t, int32_t>, winrt::Microsoft::UI::Xaml::Controls::Image> m_zoomTiles{};
+        float m_zoomTileScale{ 0.0f };
+        PdfCancellationToken m_tileCancel{};
+
+        // Background work per document on the executor (text index, form field scan);
+        // cancelled when another document is opened or shown.
+        PdfCancellationToken m_backgroundCancel{};
+
+        // Full-text search. m_textIndex is filled page by page by Background tasks on the
+        // executor (nearest unindexed page to m_indexFocus first) and, like m_pdf, only
+        // touched there.
+        TextIndex m_textIndex{};
+        std::atomic<int32_t> m_indexFocus{ 0 };
+        std::wstring m_searchQuery{};
+        std::vector<PdfTextMatch> m_searchMatches{};
+        std::optional<PdfTextMatch> m_searchAnchor{};
+
+        // Where Place Signature puts the signature: beside the selected search match, or
+        // inside the selected signature field. Outlined on the single-page view.
+        struct PlacementAnchor
+        {
+            int32_t pageIndex{};
+            PdfRect bounds{};
+            bool insideBounds{ false }; // a field to fill rather than text to sign next to
+        };
+        std::optional<PlacementAnchor> m_placementAnchor{};
+
+        // Copy of the handler's pending stamps (every page) for hit-testing drags, and the
+        // drag in progress: which stamp, and where the pointer went down on the page image.
+        std::vector<PdfStamp> m_pendingStamps{};
+        bool m_canUndoStamp{ false };
+        bool m_canRedoStamp{ false };
+        std::optional<PdfStamp> m_draggedStamp{};
+        winrt::Windows::Foundation::Point m_dragStart{};
+        uint32_t m_dragPointerId{ 0 };
+
+        // The signature as drawn; the canvas only shows its (simplified) strokes.
+        SignatureInk m_signatureInk{};
         bool m_isDrawing{ false };
         uint32_t m_activePointerId{ 0 };
         winrt::Microsoft::UI::Xaml::Shapes::Polyline m_activeStroke{ nullptr };
+
+        void EndActiveStroke();
     };
 }
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The OS pages bytes in on first touch,
+// so a reader that only looks at part of the file never reads the rest from disk.
+// Move-only; the mapping and file handle are released on destruction.
+class MappedFile
+{
+public:
+    MappedFile() noexcept = default;
+    explicit MappedFile(std::wstring const& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    bool IsOpen() const noexcept { return m_data != nullptr; }
+    uint8_t const* Data() const noexcept { return m_data; }
+    uint64_t Size() const noexcept { return m_size; }
+
+    void Close() noexcept;
+
+private:
+#if defined(_WIN32)
+    void* m_file{ nullptr };    // HANDLE
+    void* m_mapping{ nullptr }; // HANDLE
+#else
+    int m_fd{ -1 };
+#endif
+    uint8_t const* m_data{ nullptr };
+    uint64_t m_size{};
+};
@@ -1,388 +1,2586 @@
 #include "pch.h"
 #include "PdfDocumentHandler.h"
+#include "BufferedFileWriter.h"
+#include "MappedFile.h"
+#include "PixelKernels.h"
+#include "SignatureBitmap.h"
+#include "SignatureInk.h"
+#include "TraceLog.h"
 
 #include <mutex>
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
 #include <limits>
-
+#include <functional>
+#include <cmath>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <filesystem>
+#include <iterator>
+#include <deque>
+#include <map>
+#include <optional>
+
+#if PUT_A_SIGNATURE_HAS_WINRT
 #include <windows.h>
+#include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Security.Cryptography.h>
 
 using namespace winrt;
 using namespace winrt::Windows::Graphics::Imaging;
 using namespace winrt::Windows::Security::Cryptography;
+#endif
+
+#if __has_include("fpdfview.h") && __has_include("fpdf_edit.h") && __has_include("fpdf_save.h") && __has_include("fpdf_progressive.h") && __has_include("fpdf_thumbnail.h") && __has_include("fpdf_ppo.h") && __has_include("fpdf_dataavail.h") && __has_include("fpdf_text.h") && __has_include("fpdf_annot.h") && __has_include("fpdf_formfill.h")
+  #include "fpdfview.h"
+  #include "fpdf_edit.h"
+  #include "fpdf_save.h"
+  #include "fpdf_progressive.h"
+  #include "fpdf_thumbnail.h"
+  #include "fpdf_ppo.h"
+  #include "fpdf_dataavail.h"
+  #include "fpdf_text.h"
+  #include "fpdf_annot.h"
+  #include "fpdf_formfill.h"
+  #define PUT_A_SIGNATURE_HAS_PDFIUM 1
+#else
+  #define PUT_A_SIGNATURE_HAS_PDFIUM 0
+#endif
+
+namespace
+{
+    void ThrowIf(bool condition, char const* message)
+    {
+        if (condition) throw std::runtime_error(message);
+    }
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+    // Minimal COM interface to access BitmapBuffer bytes.
+    struct __declspec(uuid("5B0D3235-4DBA-4D44-8659-BC8A2776DCC1")) IMemoryBufferByteAccess : IUnknown
+    {
+        virtual HRESULT __stdcall GetBuffer(uint8_t** value, uint32_t* capacity) = 0;
+    };
+
+    // Exposes a SoftwareBitmap's pixels as a PixelView for as long as this object lives.
+    struct LockedSoftwareBitmap
+    {
+        BitmapBuffer buffer{ nullptr };
+        winrt::Windows::Foundation::IMemoryBufferReference reference{ nullptr };
+        PixelView view{};
+
+        LockedSoftwareBitmap(SoftwareBitmap const& bmp, BitmapBufferAccessMode mode)
+        {
+            ThrowIf(bmp.BitmapPixelFormat() != BitmapPixelFormat::Bgra8, "Expected BGRA8 SoftwareBitmap");
+
+            buffer = bmp.LockBuffer(mode);
+            auto desc = buffer.GetPlaneDescription(0);
+
+            reference = buffer.CreateReference();
+            uint8_t* data = nullptr;
+            uint32_t capacity = 0;
+            check_hresult(reference.as<IMemoryBufferByteAccess>()->GetBuffer(&data, &capacity));
+
+            view = PixelView{ data + desc.StartIndex, desc.Width, desc.Height, desc.Stride };
+        }
+
+        ~LockedSoftwareBitmap()
+        {
+            try
+            {
+                reference.Close();
+                buffer.Close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        LockedSoftwareBitmap(LockedSoftwareBitmap const&) = delete;
+        LockedSoftwareBitmap& operator=(LockedSoftwareBitmap const&) = delete;
+    };
+
+    // Copy BGRA pixels into a new SoftwareBitmap (premultiplied alpha). This is the one
+    // copy the display path cannot avoid: SoftwareBitmap cannot wrap external memory.
+    SoftwareBitmap SoftwareBitmapFromPixels(ConstPixelView pixels)
+    {
+        TraceSpan span("pixels.copy");
+        SoftwareBitmap sb(BitmapPixelFormat::Bgra8, pixels.width, pixels.height, BitmapAlphaMode::Premultiplied);
+
+        try
+        {
+            LockedSoftwareBitmap locked(sb, BitmapBufferAccessMode::Write);
+            CopyPixels(locked.view, pixels);
+            return sb;
+        }
+        catch (winrt::hresult_error const&)
+        {
+            // IMemoryBufferByteAccess can fail depending on toolchain/runtime; fall back to a buffer copy.
+        }
+
+        PixelBuffer packed{};
+        if (static_cast<size_t>(pixels.stride) != static_cast<size_t>(pixels.width) * PixelBuffer::BytesPerPixel)
+        {
+            packed = PixelBuffer(pixels.width, pixels.height);
+            CopyPixels(packed.View(), pixels);
+            pixels = packed.View();
+        }
+
+        auto ibuf = CryptographicBuffer::CreateFromByteArray(
+            winrt::array_view<uint8_t const>(pixels.data, pixels.data + pixels.SizeBytes()));
+
+        return SoftwareBitmap::CreateCopyFromBuffer(
+            ibuf,
+            BitmapPixelFormat::Bgra8,
+            pixels.width,
+            pixels.height,
+            BitmapAlphaMode::Premultiplied);
+    }
+#endif
+
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    // Page size in device pixels at the given scale (page points -> 96 DPI pixels).
+    void PagePixelSize(FPDF_PAGE page, float scale, int& widthPx, int& heightPx)
+    {
+        const double pageWidthPts = FPDF_GetPageWidth(page);
+        const double pageHeightPts = FPDF_GetPageHeight(page);
+
+        widthPx = static_cast<int>(pageWidthPts * (96.0 / 72.0) * scale);
+        heightPx = static_cast<int>(pageHeightPts * (96.0 / 72.0) * scale);
+        ThrowIf(widthPx <= 0 || heightPx <= 0, "Invalid page size");
+    }
+
+    // The pixels [left, right) x [top, bottom) touch, clipped to a widthPx x heightPx render.
+    PixelRect PixelRectOut(double left, double top, double right, double bottom, int32_t widthPx, int32_t heightPx)
+    {
+        const int32_t x0 = (std::max)(0, static_cast<int32_t>(std::floor(left)));
+        const int32_t y0 = (std::max)(0, static_cast<int32_t>(std::floor(top)));
+        const int32_t x1 = (std::min)(widthPx, static_cast<int32_t>(std::ceil(right)));
+        const int32_t y1 = (std::min)(heightPx, static_cast<int32_t>(std::ceil(bottom)));
+        return PixelRect{ x0, y0, (std::max)(0, x1 - x0), (std::max)(0, y1 - y0) };
+    }
+
+    // Pixels a rect in page points (bottom-left origin) covers in a render at pxPerPoint.
+    PixelRect PixelRectOfPoints(PdfRect const& rect, double pageHeightPts, double pxPerPoint, int32_t widthPx, int32_t heightPx)
+    {
+        return PixelRectOut(
+            rect.x * pxPerPoint,
+            (pageHeightPts - rect.y - rect.height) * pxPerPoint,
+            (rect.x + rect.width) * pxPerPoint,
+            (pageHeightPts - rect.y) * pxPerPoint,
+            widthPx, heightPx);
+    }
+
+    // Wrap caller-owned BGRA memory in a PDFium bitmap without copying.
+    // FPDFBitmap_Destroy() on the result leaves the memory alone.
+    FPDF_BITMAP WrapPixels(PixelView pixels)
+    {
+        FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(pixels.width, pixels.height, FPDFBitmap_BGRA, pixels.data, pixels.stride);
+        ThrowIf(!bitmap, "Failed to create bitmap");
+        return bitmap;
+    }
+
+    // Re-rasterizes `region` (pixels of the page rendered at pxPerPoint) into `pixels`,
+    // which hold that render from page pixel (originX, originY) on. The region is cleared
+    // to white and the page drawn through a clipped matrix render, so PDFium only
+    // rasterizes what falls inside it and nothing else in `pixels` changes.
+    void RenderRegion(FPDF_PAGE page, PixelView pixels, double pxPerPoint, int32_t originX, int32_t originY, PixelRect const& region, int32_t renderFlags)
+    {
+        const int32_t left = region.x - originX;
+        const int32_t top = region.y - originY;
+        FillPixels(pixels.SubView(left, top, region.width, region.height), 0xFFFFFFFF);
+
+        // PDFium applies the page's display matrix (points, y down) first; ours scales to
+        // device pixels and shifts the origin to (0, 0).
+        FPDF_BITMAP bitmap = WrapPixels(pixels);
+        const float scale = static_cast<float>(pxPerPoint);
+        const FS_MATRIX matrix{ scale, 0.0f, 0.0f, scale, -static_cast<float>(originX), -static_cast<float>(originY) };
+        const FS_RECTF clip{
+            static_cast<float>(left), static_cast<float>(top),
+            static_cast<float>(left + region.width), static_cast<float>(top + region.height) };
+        FPDF_RenderPageBitmapWithMatrix(bitmap, page, &matrix, &clip, renderFlags);
+        FPDFBitmap_Destroy(bitmap);
+    }
+
+    // Copy a PDFium-owned bitmap of any supported format into BGRA pixels.
+    // Returns nullptr for formats we do not convert.
+    std::shared_ptr<PixelBuffer> PixelsFromBitmap(FPDF_BITMAP bitmap)
+    {
+        const int width = FPDFBitmap_GetWidth(bitmap);
+        const int height = FPDFBitmap_GetHeight(bitmap);
+        const int stride = FPDFBitmap_GetStride(bitmap);
+        const int format = FPDFBitmap_GetFormat(bitmap);
+        auto const* source = static_cast<uint8_t const*>(FPDFBitmap_GetBuffer(bitmap));
+        if (!source || width <= 0 || height <= 0) return nullptr;
+
+        int sourceBytesPerPixel = 0;
+        switch (format)
+        {
+        case FPDFBitmap_Gray: sourceBytesPerPixel = 1; break;
+        case FPDFBitmap_BGR: sourceBytesPerPixel = 3; break;
+        case FPDFBitmap_BGRx:
+        case FPDFBitmap_BGRA: sourceBytesPerPixel = 4; break;
+        default: return nullptr;
+        }
+
+        auto pixels = std::make_shared<PixelBuffer>(width, height);
+        PixelView dst = pixels->View();
+        for (int y = 0; y < height; ++y)
+        {
+            uint8_t const* in = source + static_cast<ptrdiff_t>(y) * stride;
+            uint8_t* out = dst.Row(y);
+            for (int x = 0; x < width; ++x, in += sourceBytesPerPixel, out += PixelBuffer::BytesPerPixel)
+            {
+                if (sourceBytesPerPixel == 1)
+                {
+                    out[0] = out[1] = out[2] = in[0];
+                }
+                else
+                {
+                    out[0] = in[0];
+                    out[1] = in[1];
+                    out[2] = in[2];
+                }
+                out[3] = (format == FPDFBitmap_BGRA) ? in[3] : 0xFF;
+            }
+        }
+        return pixels;
+    }
+
+    // FPDF_FILEACCESS reader over a MappedFile: PDFium copies out just the block it asked for.
+    int ReadMappedBlock(void* param, unsigned long position, unsigned char* buffer, unsigned long size)
+    {
+        auto const* file = static_cast<MappedFile const*>(param);
+        if (static_cast<uint64_t>(position) + size > file->Size()) return 0;
+
+        std::memcpy(buffer, file->Data() + position, size);
+        return 1;
+    }
+
+    // FX_FILEAVAIL over an IncomingFile: PDFium asks before reading anything.
+    struct IncomingAvail : FX_FILEAVAIL
+    {
+        IncomingFile const* file{};
+    };
+
+    // FX_DOWNLOADHINTS collecting the ranges PDFium wants next.
+    struct IncomingHints : FX_DOWNLOADHINTS
+    {
+        std::deque<FileByteRange>* wanted{};
+    };
+
+    FPDF_BOOL IsIncomingDataAvail(FX_FILEAVAIL* pThis, size_t offset, size_t size)
+    {
+        return static_cast<IncomingAvail*>(pThis)->file->Has(offset, size) ? 1 : 0;
+    }
+
+    // FPDF_FILEACCESS reader over an IncomingFile. PDFium only reads what it was told is
+    // available, but refuse anything else rather than hand it uninitialized memory.
+    int ReadIncomingBlock(void* param, unsigned long position, unsigned char* buffer, unsigned long size)
+    {
+        auto const* file = static_cast<IncomingFile const*>(param);
+        if (!file->Has(position, size)) return 0;
+
+        std::memcpy(buffer, file->Data() + position, size);
+        return 1;
+    }
+
+    void AddIncomingHint(FX_DOWNLOADHINTS* pThis, size_t offset, size_t size)
+    {
+        auto* self = static_cast<IncomingHints*>(pThis);
+        self->wanted->push_back(FileByteRange{ offset, size });
+    }
+
+    // Reads one of PDFium's UTF-16LE string getters: get(buffer, bufferBytes) returns the
+    // length in bytes including the terminator, and fills the buffer if it is big enough.
+    template <typename TGet>
+    std::u16string ReadUtf16(TGet const& get)
+    {
+        const unsigned long bytes = get(nullptr, 0);
+        if (bytes <= sizeof(FPDF_WCHAR)) return {};
+
+        std::vector<FPDF_WCHAR> units(bytes / sizeof(FPDF_WCHAR));
+        if (get(units.data(), bytes) != bytes) return {};
+        return std::u16string(units.begin(), units.end() - 1);
+    }
+
+    PdfFormFieldType FormFieldType(int type) noexcept
+    {
+        switch (type)
+        {
+        case FPDF_FORMFIELD_PUSHBUTTON: return PdfFormFieldType::PushButton;
+        case FPDF_FORMFIELD_CHECKBOX: return PdfFormFieldType::CheckBox;
+        case FPDF_FORMFIELD_RADIOBUTTON: return PdfFormFieldType::RadioButton;
+        case FPDF_FORMFIELD_COMBOBOX: return PdfFormFieldType::ComboBox;
+        case FPDF_FORMFIELD_LISTBOX: return PdfFormFieldType::ListBox;
+        case FPDF_FORMFIELD_TEXTFIELD: return PdfFormFieldType::Text;
+        case FPDF_FORMFIELD_SIGNATURE: return PdfFormFieldType::Signature;
+        default: return PdfFormFieldType::Unknown;
+        }
+    }
+
+    // Appends the page's widget annotations to `fields`. Only annotation dictionaries
+    // are read; nothing is rendered.
+    void ScanPageFormFields(FPDF_FORMHANDLE form, FPDF_PAGE page, int32_t pageIndex, std::vector<PdfFormField>& fields)
+    {
+        const int count = FPDFPage_GetAnnotCount(page);
+        for (int i = 0; i < count; ++i)
+        {
+            FPDF_ANNOTATION annot = FPDFPage_GetAnnot(page, i);
+            if (!annot) continue;
+            if (FPDFAnnot_GetSubtype(annot) != FPDF_ANNOT_WIDGET)
+            {
+                FPDFPage_CloseAnnot(annot);
+                continue;
+            }
+
+            PdfFormField field{};
+            field.pageIndex = pageIndex;
+            field.type = FormFieldType(FPDFAnnot_GetFormFieldType(form, annot));
+            field.name = ReadUtf16([form, annot](FPDF_WCHAR* buffer, unsigned long bytes)
+            {
+                return FPDFAnnot_GetFormFieldName(form, annot, buffer, bytes);
+            });
+
+            FS_RECTF rect{};
+            if (FPDFAnnot_GetRect(annot, &rect))
+            {
+                const double left = (std::min)(rect.left, rect.right);
+                const double bottom = (std::min)(rect.bottom, rect.top);
+                field.rect = PdfRect{ left, bottom, std::fabs(rect.right - rect.left), std::fabs(rect.top - rect.bottom) };
+            }
+
+            switch (field.type)
+            {
+            case PdfFormFieldType::Signature:
+                // A signed field's /V is its signature dictionary, which the value getter
+                // does not return. Only seen when the widget is the field itself (the usual
+                // layout for signature fields); a value on a separate parent is missed.
+                field.filled = FPDFAnnot_HasKey(annot, "V") != 0;
+                break;
+            case PdfFormFieldType::CheckBox:
+            case PdfFormFieldType::RadioButton:
+                field.filled = FPDFAnnot_IsChecked(form, annot) != 0;
+                break;
+            case PdfFormFieldType::ComboBox:
+            case PdfFormFieldType::ListBox:
+            case PdfFormFieldType::Text:
+                field.filled = !ReadUtf16([form, annot](FPDF_WCHAR* buffer, unsigned long bytes)
+                {
+                    return FPDFAnnot_GetFormFieldValue(form, annot, buffer, bytes);
+                }).empty();
+                break;
+            default:
+                break;
+            }
+
+            fields.push_back(std::move(field));
+            FPDFPage_CloseAnnot(annot);
+        }
+    }
+
+    // 64-bit FNV-1a, used to recognise signature content that is already embedded.
+    struct ContentHash
+    {
+        uint64_t value{ 14695981039346656037ull };
+
+        void Mix(void const* data, size_t count) noexcept
+        {
+            auto const* bytes = static_cast<uint8_t const*>(data);
+            for (size_t i = 0; i < count; ++i)
+            {
+                value = (value ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        template <typename T>
+        void Mix(T const& pod) noexcept { Mix(&pod, sizeof(pod)); }
+    };
+
+    // Hash of the visible pixels (stride padding excluded), the size and the alpha mode.
+    uint64_t HashPixels(ConstPixelView pixels, PdfAlphaMode alpha) noexcept
+    {
+        ContentHash hash{};
+        hash.Mix(uint8_t{ 'I' });
+        hash.Mix(alpha);
+        hash.Mix(pixels.width);
+        hash.Mix(pixels.height);
+        const size_t rowBytes = static_cast<size_t>(pixels.width) * PixelBuffer::BytesPerPixel;
+        for (int32_t y = 0; y < pixels.height; ++y)
+        {
+            hash.Mix(pixels.Row(y), rowBytes);
+        }
+        return hash.value;
+    }
+
+    uint64_t HashInk(PdfInkSignature const& ink) noexcept
+    {
+        ContentHash hash{};
+        hash.Mix(uint8_t{ 'V' });
+        hash.Mix(ink.canvasSize.width);
+        hash.Mix(ink.canvasSize.height);
+        hash.Mix(ink.strokeWidth);
+        hash.Mix(ink.colorArgb);
+        for (auto const& stroke : ink.strokes)
+        {
+            hash.Mix(stroke.size());
+            hash.Mix(stroke.data(), stroke.size() * sizeof(PdfPoint));
+        }
+        return hash.value;
+    }
+
+    // Signature content embedded once in a document: a form XObject whose bounding box
+    // is width x height. Every placement is a form object referencing it. The one-page
+    // document it was drawn on is only kept while journaled stamps use the image, to
+    // rasterize their previews; CommitStamps closes it and registering the same content
+    // again draws it anew.
+    struct SignatureImage
+    {
+        FPDF_XOBJECT xobject{ nullptr };
+        FPDF_DOCUMENT scratch{ nullptr };
+        double width{};
+        double height{};
+        size_t contentBytes{}; // estimate of the content's streams, held by `doc` and by `scratch`
+        PixelBuffer preview{}; // premultiplied, at the size last asked for
+    };
+
+    // PDFium does not report the size of the streams it encodes. A raster signature is
+    // counted at its compacted, uncompressed size (an upper bound on the deflated image
+    // and soft mask), vector ink at about one curve segment of content text per point.
+    constexpr size_t EstimatedInkBytesPerPoint = 48;
+
+    size_t EstimatedInkBytes(PdfInkSignature const& ink) noexcept
+    {
+        size_t points = 0;
+        for (auto const& stroke : ink.strokes) points += stroke.size();
+        return points * EstimatedInkBytesPerPoint;
+    }
+
+    // A new one-page width x height document with the content `build(scratchDoc,
+    // scratchPage)` returns (a new page object, or nullptr on failure) on its page.
+    template <typename TBuild>
+    FPDF_DOCUMENT DrawSignature(double width, double height, TBuild const& build)
+    {
+        FPDF_DOCUMENT scratch = FPDF_CreateNewDocument();
+        ThrowIf(!scratch, "FPDF_CreateNewDocument failed");
+
+        FPDF_PAGE page = FPDFPage_New(scratch, 0, width, height);
+        FPDF_PAGEOBJECT content = page ? build(scratch, page) : nullptr;
+        bool drawn = false;
+        if (content)
+        {
+            FPDFPage_InsertObject(page, content);
+            drawn = FPDFPage_GenerateContent(page);
+        }
+
+        if (page) FPDF_ClosePage(page);
+        if (!drawn)
+        {
+            FPDF_CloseDocument(scratch);
+            throw std::runtime_error("Failed to draw signature");
+        }
+        return scratch;
+    }
+
+    // Builds the form XObject in `doc`. PDFium's public API has no way to reference one
+    // page object from several pages, so the content is drawn on a scratch page (see
+    // DrawSignature) and that page is imported as a reusable XObject.
+    template <typename TBuild>
+    SignatureImage EmbedSignature(FPDF_DOCUMENT doc, double width, double height, TBuild const& build)
+    {
+        SignatureImage image{ nullptr, DrawSignature(width, height, build), width, height };
+        image.xobject = FPDF_NewXObjectFromPage(doc, image.scratch, 0);
+        if (!image.xobject)
+        {
+            FPDF_CloseDocument(image.scratch);
+            throw std::runtime_error("Failed to embed signature");
+        }
+        return image;
+    }
+
+    // The signature rasterized to widthPx x heightPx with a transparent background, for
+    // compositing a pending stamp. Rendered from the scratch page at exactly the stamp's
+    // on-screen size, so vector ink stays sharp at any zoom.
+    ConstPixelView SignaturePreview(SignatureImage& image, int32_t widthPx, int32_t heightPx)
+    {
+        PixelBuffer& preview = image.preview;
+        if (!preview.Empty() && preview.Width() == widthPx && preview.Height() == heightPx)
+        {
+            return preview.View();
+        }
+
+        PixelBuffer pixels(widthPx, heightPx);
+        FillPixels(pixels.View(), 0x00000000);
+        FPDF_BITMAP bitmap = WrapPixels(pixels.View());
+        FPDF_PAGE page = image.scratch ? FPDF_LoadPage(image.scratch, 0) : nullptr;
+        if (page)
+        {
+            FPDF_RenderPageBitmap(bitmap, page, 0, 0, widthPx, heightPx, 0, 0);
+            FPDF_ClosePage(page);
+        }
+        FPDFBitmap_Destroy(bitmap);
+        ThrowIf(!page, "Failed to load signature preview");
+
+        // PDFium leaves straight alpha; CompositeOver wants premultiplied.
+        PremultiplyAlpha(pixels.View(), pixels.View());
+        preview = std::move(pixels);
+        return preview.View();
+    }
+
+    // Image object for a compacted signature on a scratch page the size of the original
+    // bitmap (1 pixel = 1 point), placed where the crop came from so cropping does not
+    // move the ink.
+    FPDF_PAGEOBJECT NewImageObject(FPDF_DOCUMENT scratch, FPDF_PAGE page, CompactSignatureBitmap const& image, int32_t sourceHeight)
+    {
+        FPDF_PAGEOBJECT imageObj = FPDFPageObj_NewImageObj(scratch);
+        if (!imageObj) return nullptr;
+
+        // PDFium only reads a bitmap used as an image source, so casting away const is safe.
+        // SetBitmap encodes the pixels before returning; nothing is retained afterwards.
+        const int format = image.format == CompactSignatureBitmap::Format::Gray8 ? FPDFBitmap_Gray : FPDFBitmap_BGRA;
+        FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(image.width, image.height, format, const_cast<uint8_t*>(image.data.data()), image.stride);
+        const bool drawn = bitmap
+            && FPDFImageObj_SetBitmap(&page, 1, imageObj, bitmap)
+            && FPDFImageObj_SetMatrix(imageObj,
+                static_cast<float>(image.width), 0.0f,
+                0.0f, static_cast<float>(image.height),
+                static_cast<float>(image.crop.x), static_cast<float>(sourceHeight - image.crop.y - image.height));
+        if (bitmap) FPDFBitmap_Destroy(bitmap);
+
+        if (!drawn)
+        {
+            FPDFPageObj_Destroy(imageObj);
+            return nullptr;
+        }
+        return imageObj;
+    }
+
+    // One stroked path holding every stroke as a subpath. Strokes are smoothed into
+    // Catmull-Rom curves (SmoothStroke) so the ink looks like the canvas polylines at
+    // any zoom, and flipped from the canvas' top-left origin to PDF's.
+    FPDF_PAGEOBJECT NewInkPathObject(PdfInkSignature const& ink)
+    {
+        const double height = ink.canvasSize.height;
+        auto flip = [height](PdfPoint p) { return PdfPoint{ p.x, height - p.y }; };
+
+        FPDF_PAGEOBJECT path = nullptr;
+        std::vector<PdfPoint> flipped{};
+        std::vector<InkCurve> curves{};
+        bool ok = true;
+        for (auto const& stroke : ink.strokes)
+        {
+            if (stroke.empty()) continue;
+
+            flipped.clear();
+            std::transform(stroke.begin(), stroke.end(), std::back_inserter(flipped), flip);
+
+            const PdfPoint start = flipped.front();
+            if (!path)
+            {
+                path = FPDFPageObj_CreateNewPath(static_cast<float>(start.x), static_cast<float>(start.y));
+                if (!path) return nullptr;
+            }
+            else
+            {
+                ok = ok && FPDFPath_MoveTo(path, static_cast<float>(start.x), static_cast<float>(start.y));
+            }
+
+            // A tap is a zero-length segment; round caps draw it as a dot.
+            if (flipped.size() == 1)
+            {
+                ok = ok && FPDFPath_LineTo(path, static_cast<float>(start.x), static_cast<float>(start.y));
+                continue;
+            }
+
+            curves.clear();
+            SmoothStroke(flipped.data(), flipped.size(), curves);
+            for (InkCurve const& curve : curves)
+            {
+                ok = ok && FPDFPath_BezierTo(path,
+                    static_cast<float>(curve.control1.x), static_cast<float>(curve.control1.y),
+                    static_cast<float>(curve.control2.x), static_cast<float>(curve.control2.y),
+                    static_cast<float>(curve.end.x), static_cast<float>(curve.end.y));
+            }
+        }
+        if (!path) return nullptr;
+
+        const uint32_t argb = ink.colorArgb;
+        ok = ok
+            && FPDFPageObj_SetStrokeColor(path, (argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, (argb >> 24) & 0xFF)
+            && FPDFPageObj_SetStrokeWidth(path, static_cast<float>(ink.strokeWidth))
+            && FPDFPageObj_SetLineCap(path, FPDF_LINECAP_ROUND)
+            && FPDFPageObj_SetLineJoin(path, FPDF_LINEJOIN_ROUND)
+            && FPDFPath_SetDrawMode(path, FPDF_FILLMODE_NONE, 1);
+        if (!ok)
+        {
+            FPDFPageObj_Destroy(path);
+            return nullptr;
+        }
+        return path;
+    }
+
+    // Bounded LRU of open page handles. FPDF_LoadPage parses the page's resources and
+    // content stream, so keeping recently used pages open lets repeated renders of the
+    // same page (zoom tiles, thumbnails, re-render after a stamp) skip that work.
+    //
+    // A pinned handle is in use and is never closed; the cache may exceed its capacity
+    // while pages are pinned. A progressive render pins its page exclusively because
+    // PDFium keeps the render context on the page: anyone else asking for that page
+    // meanwhile gets a private handle that is closed when they unpin it.
+    class PageHandleCache
+    {
+    public:
+        explicit PageHandleCache(size_t capacity) noexcept
+            : m_capacity(capacity)
+        {
+        }
+
+        ~PageHandleCache() { Clear(); }
+
+        PageHandleCache(PageHandleCache const&) = delete;
+        PageHandleCache& operator=(PageHandleCache const&) = delete;
+
+        FPDF_PAGE Pin(FPDF_DOCUMENT doc, int32_t pageIndex, bool exclusive)
+        {
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            {
+                if (it->pageIndex != pageIndex || it->discarded) continue;
+                if (it->exclusive || (exclusive && it->pins > 0))
+                {
+                    // A private handle would be missing the edits.
+                    ThrowIf(it->edits > 0, "Page has unsaved edits and is busy");
+                    break;
+                }
+
+                ++it->pins;
+                it->exclusive = exclusive;
+                m_entries.splice(m_entries.begin(), m_entries, it);
+                return m_entries.front().page;
+            }
+
+            TraceSpan loadSpan("pdf.page_load", pageIndex);
+            FPDF_PAGE page = FPDF_LoadPage(doc, pageIndex);
+            loadSpan.End();
+            ThrowIf(!page, "Failed to load page");
+
+            // A page that is busy elsewhere gets a private handle, never shared or kept.
+            const bool busy = std::any_of(m_entries.begin(), m_entries.end(), [pageIndex](Entry const& entry)
+            {
+                return entry.pageIndex == pageIndex && !entry.discarded;
+            });
+            m_entries.push_front(Entry{ pageIndex, page, 1, exclusive, busy });
+            Trim();
+            return page;
+        }
+
+        void Unpin(FPDF_PAGE page) noexcept
+        {
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            {
+                if (it->page != page) continue;
+
+                --it->pins;
+                if (it->pins == 0)
+                {
+                    it->exclusive = false;
+                    if (it->discarded)
+                    {
+                        FPDF_ClosePage(it->page);
+                        m_entries.erase(it);
+                    }
+                }
+                break;
+            }
+            Trim();
+        }
+
+        // Objects were added to a pinned handle and its content stream not regenerated
+        // yet: keep the handle (and every later Pin of the page gets it) until
+        // MarkRegenerated. False for a private handle, which would be closed on unpin.
+        bool MarkEdited(FPDF_PAGE page, uint32_t edits) noexcept
+        {
+            for (Entry& entry : m_entries)
+            {
+                if (entry.page != page) continue;
+                if (entry.discarded) return false;
+                entry.edits += edits;
+                return true;
+            }
+            return false;
+        }
+
+        // Returns how many edits the regeneration covered.
+        uint32_t MarkRegenerated(FPDF_PAGE page) noexcept
+        {
+            for (Entry& entry : m_entries)
+            {
+                if (entry.page == page) return std::exchange(entry.edits, 0u);
+            }
+            return 0;
+        }
+
+        // Pages with edits not yet regenerated, in page order.
+        std::vector<int32_t> EditedPages() const
+        {
+            std::vector<int32_t> edited{};
+            for (Entry const& entry : m_entries)
+            {
+                if (entry.edits > 0) edited.push_back(entry.pageIndex);
+            }
+            std::sort(edited.begin(), edited.end());
+            return edited;
+        }
+
+        size_t EditedPageCount() const noexcept
+        {
+            return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(), [](Entry const& entry) { return entry.edits > 0; }));
+        }
+
+        // The handle no longer matches the document (e.g. content generation failed):
+        // close it now, or as soon as its last user unpins it. Unsaved edits are lost.
+        void Discard(int32_t pageIndex) noexcept
+        {
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->pageIndex != pageIndex)
+                {
+                    ++it;
+                }
+                else if (it->pins > 0)
+                {
+                    it->discarded = true;
+                    it->edits = 0;
+                    ++it;
+                }
+                else
+                {
+                    FPDF_ClosePage(it->page);
+                    it = m_entries.erase(it);
+                }
+            }
+        }
+
+        // Closes every handle. Must run before FPDF_CloseDocument.
+        void Clear() noexcept
+        {
+            for (Entry& entry : m_entries)
+            {
+                FPDF_ClosePage(entry.page);
+            }
+            m_entries.clear();
+        }
+
+        void SetCapacity(size_t capacity) noexcept
+        {
+            m_capacity = capacity;
+            Trim();
+        }
+
+        size_t Size() const noexcept { return m_entries.size(); }
+
+        // Closes every handle that is neither pinned nor edited, whatever the capacity.
+        void CloseIdle() noexcept
+        {
+            const size_t capacity = m_capacity;
+            m_capacity = 0;
+            Trim();
+            m_capacity = capacity;
+        }
+
+    private:
+        struct Entry
+        {
+            int32_t pageIndex{};
+            FPDF_PAGE page{ nullptr };
+            int32_t pins{};
+            bool exclusive{ false };
+            bool discarded{ false };
+            uint32_t edits{}; // insertions since the content stream was last regenerated
+        };
+
+        // Edited handles are never evicted: closing one would drop its edits.
+        void Trim() noexcept
+        {
+            size_t kept = 0;
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->pins > 0 || it->discarded || it->edits > 0 || ++kept <= m_capacity)
+                {
+                    ++it;
+                    continue;
+                }
+                FPDF_ClosePage(it->page);
+                it = m_entries.erase(it);
+            }
+        }
+
+        std::list<Entry> m_entries{}; // most recently used first
+        size_t m_capacity{};
+    };
+
+    // Holds a page handle pinned in a PageHandleCache for the guard's lifetime.
+    class PinnedPage
+    {
+    public:
+        PinnedPage() noexcept = default;
+
+        PinnedPage(PageHandleCache& cache, FPDF_DOCUMENT doc, int32_t pageIndex, bool exclusive = false)
+            : m_cache(&cache), m_page(cache.Pin(doc, pageIndex, exclusive))
+        {
+        }
+
+        ~PinnedPage() { Reset(); }
+
+        PinnedPage(PinnedPage&& other) noexcept
+            : m_cache(std::exchange(other.m_cache, nullptr)), m_page(std::exchange(other.m_page, nullptr))
+        {
+        }
+
+        PinnedPage& operator=(PinnedPage&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_cache = std::exchange(other.m_cache, nullptr);
+                m_page = std::exchange(other.m_page, nullptr);
+            }
+            return *this;
+        }
+
+        FPDF_PAGE Get() const noexcept { return m_page; }
+        explicit operator bool() const noexcept { return m_page != nullptr; }
+
+        void Reset() noexcept
+        {
+            if (m_cache && m_page) m_cache->Unpin(m_page);
+            m_cache = nullptr;
+            m_page = nullptr;
+        }
+
+    private:
+        PageHandleCache* m_cache{};
+        FPDF_PAGE m_page{ nullptr };
+    };
+#endif
+
+    struct RenderCacheKey
+    {
+        uint64_t docRevision{};
+        int32_t pageIndex{};
+        float scale{};
+        int32_t flags{};
+        int32_t tileColumn{ -1 }; // -1: whole page
+        int32_t tileRow{ -1 };
+
+        bool operator==(RenderCacheKey const& other) const noexcept
+        {
+            return docRevision == other.docRevision
+                && pageIndex == other.pageIndex
+                && scale == other.scale
+                && flags == other.flags
+                && tileColumn == other.tileColumn
+                && tileRow == other.tileRow;
+        }
+    };
+
+    struct RenderCacheKeyHash
+    {
+        size_t operator()(RenderCacheKey const& key) const noexcept
+        {
+            size_t h = std::hash<uint64_t>{}(key.docRevision);
+            h = h * 31 + std::hash<int32_t>{}(key.pageIndex);
+            h = h * 31 + std::hash<float>{}(key.scale);
+            h = h * 31 + std::hash<int32_t>{}(key.flags);
+            h = h * 31 + std::hash<int32_t>{}(key.tileColumn);
+            h = h * 31 + std::hash<int32_t>{}(key.tileRow);
+            return h;
+        }
+    };
+}
+
+struct PdfDocumentHandler::Impl
+{
+    std::wstring path{};
+
+    // Bumped whenever a document is opened or closed so stale renders can never match.
+    uint64_t docRevision{ 0 };
+
+    LruByteCache<RenderCacheKey, std::shared_ptr<PixelBuffer const>, RenderCacheKeyHash> renderCache{ DefaultRenderCacheBudgetBytes };
+
+    // Zoom tiles live in their own cache so deep-zoom panning cannot evict whole-page renders.
+    LruByteCache<RenderCacheKey, std::shared_ptr<PixelBuffer const>, RenderCacheKeyHash> tileCache{ DefaultTileCacheBudgetBytes };
+
+    // Thumbnails likewise; their keys carry scale 0 and the requested max edge in `flags`.
+    LruByteCache<RenderCacheKey, std::shared_ptr<PixelBuffer const>, RenderCacheKeyHash> thumbnailCache{ DefaultThumbnailCacheBudgetBytes };
+
+    void InvalidatePage(int32_t pageIndex)
+    {
+        auto onPage = [pageIndex](RenderCacheKey const& key) { return key.pageIndex == pageIndex; };
+        renderCache.EraseIf(onPage);
+        tileCache.EraseIf(onPage);
+        thumbnailCache.EraseIf(onPage);
+    }
+
+    // Stamp journal. `stamps` is the pending state, keyed by id (so in placement order);
+    // the first journalApplied steps of `journal` produced it, the rest can be redone.
+    struct StampStep
+    {
+        std::optional<PdfStamp> before{}; // none: the step placed the stamp
+        std::optional<PdfStamp> after{};  // none: the step removed it
+    };
+
+    std::map<PdfStampId, PdfStamp> stamps{};
+    std::vector<StampStep> journal{};
+    size_t journalApplied{};
+    PdfStampId lastStampId{};
+
+    // Since the handler was created; dirtyPages is filled in by EditStats.
+    PdfEditStats editStats{};
+    PdfStampMode stampMode{ PdfStampMode::PageContent };
+
+    // What ReopenPath reports: the loaded or last saved file, and whether stamps have
+    // been placed since.
+    std::wstring savedPath{};
+    bool changedSinceSave{ false };
+
+    void SetStamp(PdfStampId id, std::optional<PdfStamp> const& state)
+    {
+        if (state) stamps[id] = *state;
+        else stamps.erase(id);
+    }
+
+    void ApplyStampStep(StampStep step)
+    {
+        journal.resize(journalApplied);
+        const PdfStampId id = step.after ? step.after->id : step.before->id;
+        SetStamp(id, step.after);
+        journal.push_back(std::move(step));
+        journalApplied = journal.size();
+    }
+
+    void ClearStampJournal() noexcept
+    {
+        stamps.clear();
+        journal.clear();
+        journalApplied = 0;
+    }
+
+    bool HasPendingStamps(int32_t pageIndex) const noexcept
+    {
+        return std::any_of(stamps.begin(), stamps.end(), [pageIndex](auto const& entry) { return entry.second.pageIndex == pageIndex; });
+    }
+
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    PageHandleCache pages{ DefaultPageHandleCacheCapacity };
+#endif
+
+    // State of the single in-flight progressive render.
+    struct ProgressiveRender
+    {
+        PdfRenderStatus status{ PdfRenderStatus::Idle };
+        PdfCancellationToken cancel{};
+        RenderCacheKey cacheKey{};
+        std::shared_ptr<PixelBuffer> pixels{};
+        std::shared_ptr<PixelBuffer const> result{};
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+        IFSDK_PAUSE pause{};
+        std::chrono::steady_clock::time_point deadline{};
+        PinnedPage page{}; // pinned exclusively while the render is in flight
+        FPDF_BITMAP bitmap{ nullptr }; // wraps pixels
+        bool started{ false };
+
+        // PDFium polls this between chunks of work; pause when the slice is spent or the render was cancelled.
+        static FPDF_BOOL NeedToPauseNow(IFSDK_PAUSE* pause)
+        {
+            auto self = static_cast<ProgressiveRender*>(pause->user);
+            return (self->cancel.IsCancelled() || std::chrono::steady_clock::now() >= self->deadline) ? 1 : 0;
+        }
+
+        void ReleasePdfium() noexcept
+        {
+            if (page)
+            {
+                if (started) FPDF_RenderPage_Close(page.Get());
+                page.Reset();
+            }
+            if (bitmap)
+            {
+                FPDFBitmap_Destroy(bitmap);
+                bitmap = nullptr;
+            }
+            started = false;
+        }
+#endif
+
+        void Reset(PdfRenderStatus newStatus) noexcept
+        {
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+            ReleasePdfium();
+#endif
+            pixels.reset();
+            result.reset();
+            status = newStatus;
+        }
+    } progressive{};
+
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    // Keep backing bytes alive when loading via FPDF_LoadMemDocument64.
+    std::vector<uint8_t> docBytes{};
+
+    // Backing store for documents opened with LoadFromPath; must outlive `doc`.
+    MappedFile mappedFile{};
+    FPDF_FILEACCESS fileAccess{};
+
+    // Progressive load: bytes received so far, PDFium's availability tracker over them,
+    // and the ranges it asked for that have not arrived yet. `incoming` must outlive
+    // `avail`, which must outlive `doc`.
+    IncomingFile incoming{};
+    IncomingAvail incomingAvail{};
+    FPDF_AVAIL avail{ nullptr };
+    std::deque<FileByteRange> wanted{};
+    uint64_t loadCursor{};
+    PdfLoadStatus loadStatus{ PdfLoadStatus::Idle };
+
+    // Runs one availability check; ranges PDFium is still missing join `wanted`.
+    template <typename TCheck>
+    int CheckAvail(TCheck const& check)
+    {
+        IncomingHints hints{};
+        hints.version = 1;
+        hints.AddSegment = &AddIncomingHint;
+        hints.wanted = &wanted;
+        return check(&hints);
+    }
+
+    void CloseProgressiveLoad() noexcept
+    {
+        if (avail)
+        {
+            FPDFAvail_Destroy(avail);
+            avail = nullptr;
+        }
+        incoming.Close();
+        wanted.clear();
+        loadCursor = 0;
+        loadStatus = PdfLoadStatus::Idle;
+    }
+
+    // Signature images embedded in `doc`, keyed by content hash (PdfSignatureImageId).
+    std::unordered_map<uint64_t, SignatureImage> signatureImages{};
+
+    // Form fields found so far by ContinueFormFieldScan, and the next page to scan. The
+    // form environment is only needed to read field names, types and values.
+    std::vector<PdfFormField> formFields{};
+    int32_t formScanNextPage{};
+    FPDF_FORMFILLINFO formFillInfo{};
+    FPDF_FORMHANDLE form{ nullptr };
+
+    // Must run before FPDF_CloseDocument.
+    void CloseForm() noexcept
+    {
+        if (form)
+        {
+            FPDFDOC_ExitFormFillEnvironment(form);
+            form = nullptr;
+        }
+        formFields.clear();
+        formScanNextPage = 0;
+    }
+
+    void CloseSignatureImages() noexcept
+    {
+        for (auto& entry : signatureImages)
+        {
+            FPDF_CloseXObject(entry.second.xobject);
+            if (entry.second.scratch) FPDF_CloseDocument(entry.second.scratch);
+        }
+        signatureImages.clear();
+    }
+
+    // Whether a pending stamp, or one an undo or redo could bring back, shows `image`.
+    bool StampsUseImage(PdfSignatureImageId image) const noexcept
+    {
+        auto uses = [image](std::optional<PdfStamp> const& stamp) { return stamp && stamp->image == image; };
+        return std::any_of(stamps.begin(), stamps.end(), [image](auto const& entry) { return entry.second.image == image; })
+            || std::any_of(journal.begin(), journal.end(), [&uses](StampStep const& step) { return uses(step.before) || uses(step.after); });
+    }
+
+    // The XObjects stay in `doc`; only the scratch documents (and previews) of images no
+    // stamp can show any more are closed, so none keeps a second copy of its content.
+    void CloseUnusedSignatureScratch() noexcept
+    {
+        for (auto& entry : signatureImages)
+        {
+            SignatureImage& image = entry.second;
+            if (!image.scratch || StampsUseImage(entry.first)) continue;
+            FPDF_CloseDocument(image.scratch);
+            image.scratch = nullptr;
+            image.preview = PixelBuffer{};
+        }
+    }
+
+    // Draws the page's pending stamps onto `target`, whose pixel (0, 0) is pixel
+    // (originX, originY) of the page rendered at pxPerPoint.
+    void CompositeStamps(int32_t pageIndex, PixelView target, double pxPerPoint, int32_t originX, int32_t originY)
+    {
+        FS_SIZEF pageSize{};
+        if (!FPDF_GetPageSizeByIndexF(doc, pageIndex, &pageSize)) return;
+
+        for (auto const& entry : stamps)
+        {
+            PdfStamp const& stamp = entry.second;
+            auto registered = signatureImages.find(stamp.image);
+            if (stamp.pageIndex != pageIndex || registered == signatureImages.end()) continue;
+
+            // The stamp's box in page pixels (top-left origin), then the part inside target.
+            const int32_t left = static_cast<int32_t>(std::lround(stamp.rect.x * pxPerPoint));
+            const int32_t top = static_cast<int32_t>(std::lround((pageSize.height - stamp.rect.y - stamp.rect.height) * pxPerPoint));
+            const int32_t width = static_cast<int32_t>(std::lround(stamp.rect.width * pxPerPoint));
+            const int32_t height = static_cast<int32_t>(std::lround(stamp.rect.height * pxPerPoint));
+            const int32_t x0 = (std::max)(left - originX, 0);
+            const int32_t y0 = (std::max)(top - originY, 0);
+            const int32_t x1 = (std::min)(left + width - originX, target.width);
+            const int32_t y1 = (std::min)(top + height - originY, target.height);
+            if (width <= 0 || height <= 0 || x1 <= x0 || y1 <= y0) continue;
+
+            ConstPixelView preview = SignaturePreview(registered->second, width, height);
+            CompositeOver(
+                target.SubView(x0, y0, x1 - x0, y1 - y0),
+                preview.SubView(x0 + originX - left, y0 + originY - top, x1 - x0, y1 - y0));
+        }
+    }
+
+    // `base` with the page's pending stamps drawn over it. Cached renders never contain
+    // pending stamps, so this returns a copy when there are any.
+    std::shared_ptr<PixelBuffer const> WithStamps(int32_t pageIndex, std::shared_ptr<PixelBuffer const> base,
+        double pxPerPoint, int32_t originX = 0, int32_t originY = 0)
+    {
+        if (!base || !HasPendingStamps(pageIndex)) return base;
+
+        TraceSpan span("pdf.composite_stamps", pageIndex);
+        auto composed = std::make_shared<PixelBuffer>(base->Width(), base->Height());
+        CopyPixels(composed->View(), base->View());
+        CompositeStamps(pageIndex, composed->View(), pxPerPoint, originX, originY);
+        return composed;
+    }
+
+    // Objects were just added to `page` inside damagedPts (PDF points). Cached whole-page
+    // renders are re-rasterized in those rects only, on a copy since callers may still
+    // hold the old pixels; tiles touching the damage and the page's thumbnails are dropped.
+    void RepairPage(FPDF_PAGE page, int32_t pageIndex, std::vector<PdfRect> const& damagedPts)
+    {
+        const double pageHeightPts = FPDF_GetPageHeight(page);
+
+        std::vector<std::pair<RenderCacheKey, std::shared_ptr<PixelBuffer const>>> renders{};
+        renderCache.ForEach([&renders, pageIndex](RenderCacheKey const& key, std::shared_ptr<PixelBuffer const> const& pixels)
+        {
+            if (key.pageIndex == pageIndex) renders.emplace_back(key, pixels);
+        });
+
+        for (auto const& [key, cached] : renders)
+        {
+            TraceSpan span("pdf.rasterize_region", pageIndex);
+            const double pxPerPoint = key.scale * (96.0 / 72.0);
+            auto repaired = std::make_shared<PixelBuffer>(cached->Width(), cached->Height());
+            CopyPixels(repaired->View(), cached->View());
+            for (PdfRect const& rect : damagedPts)
+            {
+                const PixelRect region = PixelRectOfPoints(rect, pageHeightPts, pxPerPoint, repaired->Width(), repaired->Height());
+                if (!region.Empty()) RenderRegion(page, repaired->View(), pxPerPoint, 0, 0, region, key.flags);
+            }
+            renderCache.Insert(key, repaired, repaired->SizeBytes());
+        }
+
+        tileCache.EraseIf([&](RenderCacheKey const& key)
+        {
+            if (key.pageIndex != pageIndex) return false;
+            const double pxPerPoint = key.scale * (96.0 / 72.0);
+            const int32_t tileX = key.tileColumn * PdfDocumentHandler::TileSizePx;
+            const int32_t tileY = key.tileRow * PdfDocumentHandler::TileSizePx;
+            for (PdfRect const& rect : damagedPts)
+            {
+                const PixelRect region = PixelRectOfPoints(rect, pageHeightPts, pxPerPoint, (std::numeric_limits<int32_t>::max)(), (std::numeric_limits<int32_t>::max)());
+                if (region.x < tileX + PdfDocumentHandler::TileSizePx && tileX < region.x + region.width
+                    && region.y < tileY + PdfDocumentHandler::TileSizePx && tileY < region.y + region.height)
+                {
+                    return true;
+                }
+            }
+            return false;
+        });
+        thumbnailCache.EraseIf([pageIndex](RenderCacheKey const& key) { return key.pageIndex == pageIndex; });
+    }
+#endif
+
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    FPDF_DOCUMENT doc{ nullptr };
+#endif
+
+    ~Impl()
+    {
+        progressive.Reset(PdfRenderStatus::Idle);
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+        pages.Clear();
+        CloseSignatureImages();
+        CloseForm();
+        if (doc)
+        {
+            FPDF_CloseDocument(doc);
+            doc = nullptr;
+        }
+        CloseProgressiveLoad();
+#endif
+    }
+};
+
+namespace
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    std::once_flag g_pdfiumInitOnce;
+#endif
+}
+
+PdfDocumentHandler::PdfDocumentHandler()
+    : m(new Impl{})
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    std::call_once(g_pdfiumInitOnce, []()
+    {
+        FPDF_InitLibrary();
+    });
+#endif
+}
+
+PdfDocumentHandler::~PdfDocumentHandler()
+{
+    Close();
+    delete m;
+    m = nullptr;
+}
+
+bool PdfDocumentHandler::IsLoaded() const noexcept
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    return m && m->doc != nullptr;
+#else
+    return false;
+#endif
+}
+
+void PdfDocumentHandler::Close()
+{
+    if (!m) return;
+
+    m->progressive.Reset(PdfRenderStatus::Idle);
+
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    m->pages.Clear();
+    m->CloseSignatureImages();
+    m->CloseForm();
+    if (m->doc)
+    {
+        FPDF_CloseDocument(m->doc);
+        m->doc = nullptr;
+    }
+#endif
+
+    m->path.clear();
+    m->savedPath.clear();
+    m->changedSinceSave = false;
+    m->ClearStampJournal();
+    m->renderCache.Clear();
+    m->tileCache.Clear();
+    m->thumbnailCache.Clear();
+    ++m->docRevision;
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    m->docBytes.clear();
+    m->docBytes.shrink_to_fit();
+    m->mappedFile.Close();
+    m->CloseProgressiveLoad();
+    m->fileAccess = FPDF_FILEACCESS{};
+#endif
+}
+
+void PdfDocumentHandler::LoadFromPath(std::wstring const& path)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!m, "PdfDocumentHandler not initialized");
+
+    Close();
+    m->path = path;
+    m->savedPath = path;
+    TraceSpan span("pdf.load");
+
+    // Map the file and let PDFium pull only the blocks it needs (trailer, xref and the
+    // objects of pages it opens) straight out of the mapping; nothing is read up front.
+    TraceSpan mapSpan("file.map");
+    m->mappedFile = MappedFile(path);
+    mapSpan.End();
+    const uint64_t size = m->mappedFile.Size();
+
+    if (size <= (std::numeric_limits<unsigned long>::max)())
+    {
+        m->fileAccess.m_FileLen = static_cast<unsigned long>(size);
+        m->fileAccess.m_GetBlock = &ReadMappedBlock;
+        m->fileAccess.m_Param = &m->mappedFile;
+        m->doc = FPDF_LoadCustomDocument(&m->fileAccess, nullptr);
+    }
+    else
+    {
+        // FPDF_FILEACCESS lengths are 32-bit on Windows; bigger files use the
+        // 64-bit memory loader over the same mapping.
+        ThrowIf(size > (std::numeric_limits<size_t>::max)(), "PDF too large to map");
+        m->doc = FPDF_LoadMemDocument64(m->mappedFile.Data(), static_cast<size_t>(size), nullptr);
+    }
+
+    if (!m->doc)
+    {
+        Close();
+        throw std::runtime_error("FPDF_LoadCustomDocument failed (corrupt PDF, password needed, or PDFium load error)");
+    }
+#else
+    (void)path;
+    throw std::runtime_error("PDFium not integrated: add PDFium headers/libs so fpdfview.h/fpdf_edit.h/fpdf_save.h are available.");
+#endif
+}
+
+void PdfDocumentHandler::LoadFromBytes(std::vector<uint8_t> bytes)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!m, "PdfDocumentHandler not initialized");
+
+    Close();
+
+    // Keep the bytes alive for as long as the document is open.
+    m->docBytes = std::move(bytes);
+    if (m->docBytes.empty())
+    {
+        throw std::runtime_error("PDF buffer is empty");
+    }
+
+    // The 64-bit loader has no int-sized limit on the buffer.
+    TraceSpan span("pdf.load");
+    m->doc = FPDF_LoadMemDocument64(m->docBytes.data(), m->docBytes.size(), nullptr);
+
+    if (!m->doc)
+    {
+        throw std::runtime_error("FPDF_LoadMemDocument64 failed (corrupt PDF, password needed, or PDFium load error)");
+    }
+#else
+    (void)bytes;
+    throw std::runtime_error("PDFium not integrated: add PDFium headers/libs so fpdfview.h/fpdf_edit.h/fpdf_save.h are available.");
+#endif
+}
+
+void PdfDocumentHandler::BeginProgressiveLoad(uint64_t fileSize)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!m, "PdfDocumentHandler not initialized");
+
+    Close();
+
+    // FPDF_FILEACCESS lengths are 32-bit on Windows; bigger files have to arrive whole.
+    ThrowIf(fileSize > (std::numeric_limits<unsigned long>::max)(), "PDF too large to load progressively");
+    m->incoming = IncomingFile(fileSize);
+
+    m->fileAccess.m_FileLen = static_cast<unsigned long>(fileSize);
+    m->fileAccess.m_GetBlock = &ReadIncomingBlock;
+    m->fileAccess.m_Param = &m->incoming;
+
+    m->incomingAvail.version = 1;
+    m->incomingAvail.IsDataAvail = &IsIncomingDataAvail;
+    m->incomingAvail.file = &m->incoming;
+
+    m->avail = FPDFAvail_Create(&m->incomingAvail, &m->fileAccess);
+    if (!m->avail)
+    {
+        Close();
+        throw std::runtime_error("FPDFAvail_Create failed");
+    }
+    m->loadStatus = PdfLoadStatus::NeedData;
+#else
+    (void)fileSize;
+    throw std::runtime_error("PDFium not integrated: add PDFium headers/libs so fpdfview.h/fpdf_edit.h/fpdf_save.h are available.");
+#endif
+}
+
+void PdfDocumentHandler::AddLoadData(uint64_t offset, uint8_t const* data, size_t size)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!m || !m->incoming.IsOpen(), "No progressive load in progress");
+    m->incoming.Write(offset, data, size);
+#else
+    (void)offset;
+    (void)data;
+    (void)size;
+    throw std::runtime_error("PDFium not integrated: cannot load.");
+#endif
+}
+
+FileByteRange PdfDocumentHandler::NextLoadRange(uint64_t maxLength)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (!m || !m->incoming.IsOpen()) return {};
+
+    IncomingFile const& incoming = m->incoming;
+    while (!m->wanted.empty())
+    {
+        const FileByteRange want = m->wanted.front();
+        if (incoming.Has(want.offset, want.length))
+        {
+            m->wanted.pop_front();
+            continue;
+        }
+
+        // The first gap inside the hint; the hint stays queued until all of it has arrived.
+        FileByteRange range = incoming.NextMissing(want.offset, (std::min)(want.length, maxLength));
+        if (range.length > 0 && range.offset < want.offset + want.length)
+        {
+            range.length = (std::min)(range.length, want.offset + want.length - range.offset);
+            return range;
+        }
+        m->wanted.pop_front();
+    }
+
+    // Nothing asked for: keep streaming the file front to back.
+    const FileByteRange range = incoming.NextMissing(m->loadCursor, maxLength);
+    m->loadCursor = range.offset + range.length;
+    return range;
+#else
+    (void)maxLength;
+    return {};
+#endif
+}
+
+PdfLoadStatus PdfDocumentHandler::ContinueProgressiveLoad()
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (!m || !m->avail) return PdfLoadStatus::Idle;
+
+    if (m->loadStatus == PdfLoadStatus::NeedData)
+    {
+        TraceSpan span("pdf.load");
+        const int rc = m->CheckAvail([this](FX_DOWNLOADHINTS* hints) { return FPDFAvail_IsDocAvail(m->avail, hints); });
+        if (rc == PDF_DATA_ERROR)
+        {
+            m->loadStatus = PdfLoadStatus::Failed;
+        }
+        else if (rc == PDF_DATA_AVAIL)
+        {
+            m->doc = FPDFAvail_GetDocument(m->avail, nullptr);
+            m->loadStatus = m->doc ? PdfLoadStatus::Ready : PdfLoadStatus::Failed;
+        }
+    }
+
+    if (m->loadStatus == PdfLoadStatus::Ready && m->incoming.Complete())
+    {
+        m->wanted.clear();
+        m->loadStatus = PdfLoadStatus::Complete;
+    }
+    return m->loadStatus;
+#else
+    return PdfLoadStatus::Idle;
+#endif
+}
+
+PdfLoadStatus PdfDocumentHandler::ProgressiveLoadStatus() const noexcept
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    return m ? m->loadStatus : PdfLoadStatus::Idle;
+#else
+    return PdfLoadStatus::Idle;
+#endif
+}
+
+bool PdfDocumentHandler::IsPageAvailable(int32_t pageIndex)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (!IsLoaded()) return false;
+    if (!m->avail || m->incoming.Complete()) return true;
+
+    const int rc = m->CheckAvail([this, pageIndex](FX_DOWNLOADHINTS* hints)
+    {
+        return FPDFAvail_IsPageAvail(m->avail, pageIndex, hints);
+    });
+    return rc == PDF_DATA_AVAIL;
+#else
+    (void)pageIndex;
+    return false;
+#endif
+}
+
+int32_t PdfDocumentHandler::FirstAvailablePage() const noexcept
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (!IsLoaded() || !m->avail) return 0;
+    return static_cast<int32_t>(FPDFAvail_GetFirstPageNum(m->doc));
+#else
+    return 0;
+#endif
+}
+
+std::shared_ptr<PixelBuffer const> PdfDocumentHandler::RenderPage(int32_t pageIndex, float scale, int32_t renderFlags)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+
+    const RenderCacheKey cacheKey{ m->docRevision, pageIndex, scale, renderFlags };
+    const double pxPerPoint = scale * (96.0 / 72.0);
+    if (auto cached = m->renderCache.Find(cacheKey))
+    {
+        return m->WithStamps(pageIndex, *cached, pxPerPoint);
+    }
+
+    ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+    PinnedPage page(m->pages, m->doc, pageIndex);
+
+    int widthPx = 0, heightPx = 0;
+    PagePixelSize(page.Get(), scale, widthPx, heightPx);
+
+    // PDFium rasterizes straight into the buffer we hand out and cache.
+    auto pixels = std::make_shared<PixelBuffer>(widthPx, heightPx);
+    FPDF_BITMAP bitmap = WrapPixels(pixels->View());
+
+    {
+        TraceSpan span("pdf.rasterize", pageIndex);
+        FillPixels(pixels->View(), 0xFFFFFFFF);
+        FPDF_RenderPageBitmap(bitmap, page.Get(), 0, 0, pixels->Width(), pixels->Height(), 0, renderFlags);
+    }
+
+    FPDFBitmap_Destroy(bitmap);
+
+    m->renderCache.Insert(cacheKey, pixels, pixels->SizeBytes());
+    return m->WithStamps(pageIndex, pixels, pxPerPoint);
+#else
+    (void)pageIndex;
+    (void)scale;
+    (void)renderFlags;
+    throw std::runtime_error("PDFium not integrated: cannot render.");
+#endif
+}
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+SoftwareBitmap PdfDocumentHandler::RenderPageToSoftwareBitmap(int32_t pageIndex, float scale, int32_t renderFlags)
+{
+    return SoftwareBitmapFromPixels(RenderPage(pageIndex, scale, renderFlags)->View());
+}
+#endif
+
+PdfSize PdfDocumentHandler::PageSizePoints(int32_t pageIndex)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+
+    FS_SIZEF size{};
+    ThrowIf(!FPDF_GetPageSizeByIndexF(m->doc, pageIndex, &size), "Failed to get page size");
+    return PdfSize{ size.width, size.height };
+#else
+    (void)pageIndex;
+    throw std::runtime_error("PDFium not integrated: cannot read page size.");
+#endif
+}
+
+std::vector<PdfSize> PdfDocumentHandler::PageSizesPoints()
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+
+    // FPDF_GetPageSizeByIndexF reads the page dictionary only, so this stays cheap
+    // even for documents with thousands of pages.
+    const bool loading = m->avail && !m->incoming.Complete();
+    const int32_t count = PageCount();
+    std::vector<PdfSize> sizes(static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i)
+    {
+        FS_SIZEF size{};
+        if (FPDF_GetPageSizeByIndexF(m->doc, i, &size))
+        {
+            sizes[static_cast<size_t>(i)] = PdfSize{ size.width, size.height };
+            continue;
+        }
+
+        // While loading, pages whose dictionary has not arrived borrow the previous
+        // page's size (or US Letter); ask again once the load completes.
+        ThrowIf(!loading, "Failed to get page size");
+        sizes[static_cast<size_t>(i)] = i > 0 ? sizes[static_cast<size_t>(i - 1)] : PdfSize{ 612.0, 792.0 };
+    }
+    return sizes;
+#else
+    throw std::runtime_error("PDFium not integrated: cannot read page size.");
+#endif
+}
+
+PdfPageText PdfDocumentHandler::ExtractPageText(int32_t pageIndex)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+
+    PinnedPage page(m->pages, m->doc, pageIndex);
+    TraceSpan span("pdf.extract_text", pageIndex);
+
+    FPDF_TEXTPAGE textPage = FPDFText_LoadPage(page.Get());
+    ThrowIf(!textPage, "FPDFText_LoadPage failed");
+
+    PdfPageText result{};
+    const int count = FPDFText_CountChars(textPage);
+    if (count > 0)
+    {
+        // FPDFText_GetText writes UTF-16LE plus a terminator.
+        std::vector<unsigned short> units(static_cast<size_t>(count) + 1);
+        const int written = FPDFText_GetText(textPage, 0, count, units.data());
+        const size_t length = written > 0 ? static_cast<size_t>(written - 1) : 0;
+        result.text.assign(units.begin(), units.begin() + static_cast<ptrdiff_t>(length));
+
+        result.charBoxes.resize(length);
+        for (size_t i = 0; i < length; ++i)
+        {
+            double left = 0.0, right = 0.0, bottom = 0.0, top = 0.0;
+            if (FPDFText_GetCharBox(textPage, static_cast<int>(i), &left, &right, &bottom, &top))
+            {
+                result.charBoxes[i] = PdfRect{ left, bottom, right - left, top - bottom };
+            }
+        }
+    }
+
+    FPDFText_ClosePage(textPage);
+    return result;
+#else
+    (void)pageIndex;
+    throw std::runtime_error("PDFium not integrated: cannot extract text.");
+#endif
+}
+
+std::shared_ptr<PixelBuffer const> PdfDocumentHandler::RenderThumbnail(int32_t pageIndex, int32_t maxEdgePx)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(maxEdgePx <= 0, "Invalid thumbnail size");
+
+    // Embedded thumbnails come in any size; stamps are scaled to whatever the width is.
+    auto withStamps = [this, pageIndex](std::shared_ptr<PixelBuffer const> pixels)
+    {
+        const double pxPerPoint = pixels->Width() / PageSizePoints(pageIndex).width;
+        return m->WithStamps(pageIndex, std::move(pixels), pxPerPoint);
+    };
+
+    const RenderCacheKey cacheKey{ m->docRevision, pageIndex, 0.0f, maxEdgePx };
+    if (auto cached = m->thumbnailCache.Find(cacheKey))
+    {
+        return withStamps(*cached);
+    }
+
+    ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+    PinnedPage page(m->pages, m->doc, pageIndex);
+
+    // Prefer the thumbnail stored in the file: decoding it is far cheaper than
+    // rasterizing the page. Oversized ones are not worth the memory.
+    std::shared_ptr<PixelBuffer> pixels{};
+    if (FPDF_BITMAP embedded = FPDFPage_GetThumbnailAsBitmap(page.Get()))
+    {
+        if (FPDFBitmap_GetWidth(embedded) <= 2 * maxEdgePx && FPDFBitmap_GetHeight(embedded) <= 2 * maxEdgePx)
+        {
+            try
+            {
+                pixels = PixelsFromBitmap(embedded);
+            }
+            catch (...)
+            {
+                FPDFBitmap_Destroy(embedded);
+                throw;
+            }
+        }
+        FPDFBitmap_Destroy(embedded);
+    }
+
+    if (!pixels)
+    {
+        const double pageWidthPx = FPDF_GetPageWidth(page.Get()) * (96.0 / 72.0);
+        const double pageHeightPx = FPDF_GetPageHeight(page.Get()) * (96.0 / 72.0);
+        ThrowIf(pageWidthPx <= 0.0 || pageHeightPx <= 0.0, "Invalid page size");
+
+        const float scale = static_cast<float>(maxEdgePx / (std::max)(pageWidthPx, pageHeightPx));
+        int widthPx = 0, heightPx = 0;
+        PagePixelSize(page.Get(), scale, widthPx, heightPx);
+
+        TraceSpan span("pdf.rasterize_thumbnail", pageIndex);
+        pixels = std::make_shared<PixelBuffer>(widthPx, heightPx);
+        FPDF_BITMAP bitmap = WrapPixels(pixels->View());
+        FillPixels(pixels->View(), 0xFFFFFFFF);
+        FPDF_RenderPageBitmap(bitmap, page.Get(), 0, 0, widthPx, heightPx, 0, DefaultRenderFlags);
+        FPDFBitmap_Destroy(bitmap);
+    }
+
+    m->thumbnailCache.Insert(cacheKey, pixels, pixels->SizeBytes());
+    return withStamps(pixels);
+#else
+    (void)pageIndex;
+    (void)maxEdgePx;
+    throw std::runtime_error("PDFium not integrated: cannot render.");
+#endif
+}
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+SoftwareBitmap PdfDocumentHandler::RenderThumbnailToSoftwareBitmap(int32_t pageIndex, int32_t maxEdgePx)
+{
+    return SoftwareBitmapFromPixels(RenderThumbnail(pageIndex, maxEdgePx)->View());
+}
+#endif
+
+std::vector<PdfTile> PdfDocumentHandler::TilesInViewport(int32_t pageIndex, float scale, PdfRect const& viewportPx)
+{
+    const PdfSize size = PageSizePoints(pageIndex);
+    const int32_t pageWidthPx = static_cast<int32_t>(size.width * (96.0 / 72.0) * scale);
+    const int32_t pageHeightPx = static_cast<int32_t>(size.height * (96.0 / 72.0) * scale);
+
+    // Clamp the viewport to the page, then cover it with whole tiles.
+    const double left = (std::max)(0.0, viewportPx.x);
+    const double top = (std::max)(0.0, viewportPx.y);
+    const double right = (std::min)(static_cast<double>(pageWidthPx), viewportPx.x + viewportPx.width);
+    const double bottom = (std::min)(static_cast<double>(pageHeightPx), viewportPx.y + viewportPx.height);
+
+    std::vector<PdfTile> tiles{};
+    if (right <= left || bottom <= top) return tiles;
+
+    const int32_t firstColumn = static_cast<int32_t>(left) / TileSizePx;
+    const int32_t firstRow = static_cast<int32_t>(top) / TileSizePx;
+    const int32_t lastColumn = (static_cast<int32_t>(std::ceil(right)) - 1) / TileSizePx;
+    const int32_t lastRow = (static_cast<int32_t>(std::ceil(bottom)) - 1) / TileSizePx;
+
+    for (int32_t row = firstRow; row <= lastRow; ++row)
+    {
+        for (int32_t column = firstColumn; column <= lastColumn; ++column)
+        {
+            tiles.push_back(PdfTile{ column, row });
+        }
+    }
+    return tiles;
+}
+
+std::shared_ptr<PixelBuffer const> PdfDocumentHandler::RenderTile(int32_t pageIndex, float scale, PdfTile tile, int32_t renderFlags)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(tile.column < 0 || tile.row < 0, "Invalid tile");
+
+    const RenderCacheKey cacheKey{ m->docRevision, pageIndex, scale, renderFlags, tile.column, tile.row };
+    if (auto cached = m->tileCache.Find(cacheKey))
+    {
+        return m->WithStamps(pageIndex, *cached, scale * (96.0 / 72.0), tile.column * TileSizePx, tile.row * TileSizePx);
+    }
+
+    ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+    PinnedPage page(m->pages, m->doc, pageIndex);
+
+    int pageWidthPx = 0, pageHeightPx = 0;
+    PagePixelSize(page.Get(), scale, pageWidthPx, pageHeightPx);
+
+    // Edge tiles are cut down to the page.
+    const int32_t originX = tile.column * TileSizePx;
+    const int32_t originY = tile.row * TileSizePx;
+    ThrowIf(originX >= pageWidthPx || originY >= pageHeightPx, "Tile outside page");
+
+    const PixelRect region{
+        originX,
+        originY,
+        (std::min)(TileSizePx, pageWidthPx - originX),
+        (std::min)(TileSizePx, pageHeightPx - originY) };
+    auto pixels = std::make_shared<PixelBuffer>(region.width, region.height);
+
+    // The clip keeps rasterization to the tile itself, which is what bounds the cost at
+    // high zoom.
+    {
+        TraceSpan span("pdf.rasterize_tile", pageIndex);
+        RenderRegion(page.Get(), pixels->View(), scale * (96.0 / 72.0), originX, originY, region, renderFlags);
+    }
+
+    m->tileCache.Insert(cacheKey, pixels, pixels->SizeBytes());
+    return m->WithStamps(pageIndex, pixels, scale * (96.0 / 72.0), originX, originY);
+#else
+    (void)pageIndex;
+    (void)scale;
+    (void)tile;
+    (void)renderFlags;
+    throw std::runtime_error("PDFium not integrated: cannot render.");
+#endif
+}
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+SoftwareBitmap PdfDocumentHandler::RenderTileToSoftwareBitmap(int32_t pageIndex, float scale, PdfTile tile, int32_t renderFlags)
+{
+    return SoftwareBitmapFromPixels(RenderTile(pageIndex, scale, tile, renderFlags)->View());
+}
+#endif
+
+PdfRect PdfDocumentHandler::PageRectToPixels(int32_t pageIndex, float scale, PdfRect const& rectInPdfPoints)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    const PdfSize size = PageSizePoints(pageIndex);
+    const double pxPerPoint = scale * (96.0 / 72.0);
+    const PixelRect region = PixelRectOfPoints(rectInPdfPoints, size.height, pxPerPoint,
+        static_cast<int32_t>(size.width * (96.0 / 72.0) * scale),
+        static_cast<int32_t>(size.height * (96.0 / 72.0) * scale));
+    if (region.Empty()) return {};
+    return PdfRect{ static_cast<double>(region.x), static_cast<double>(region.y), static_cast<double>(region.width), static_cast<double>(region.height) };
+#else
+    (void)pageIndex;
+    (void)scale;
+    (void)rectInPdfPoints;
+    throw std::runtime_error("PDFium not integrated: cannot read page size.");
+#endif
+}
+
+std::shared_ptr<PixelBuffer const> PdfDocumentHandler::RenderPageRegion(int32_t pageIndex, float scale, PdfRect const& regionPx, int32_t renderFlags)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+
+    const PdfSize size = PageSizePoints(pageIndex);
+    const double pxPerPoint = scale * (96.0 / 72.0);
+    const PixelRect region = PixelRectOut(
+        regionPx.x, regionPx.y, regionPx.x + regionPx.width, regionPx.y + regionPx.height,
+        static_cast<int32_t>(size.width * (96.0 / 72.0) * scale),
+        static_cast<int32_t>(size.height * (96.0 / 72.0) * scale));
+    ThrowIf(region.Empty(), "Region outside page");
+
+    auto pixels = std::make_shared<PixelBuffer>(region.width, region.height);
+
+    // The page render, when cached, already has these pixels.
+    const RenderCacheKey cacheKey{ m->docRevision, pageIndex, scale, renderFlags };
+    auto cached = m->renderCache.Find(cacheKey);
+    if (cached && region.x + region.width <= (*cached)->Width() && region.y + region.height <= (*cached)->Height())
+    {
+        CopyPixels(pixels->View(), (*cached)->View().SubView(region.x, region.y, region.width, region.height));
+    }
+    else
+    {
+        ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+        PinnedPage page(m->pages, m->doc, pageIndex);
+
+        TraceSpan span("pdf.rasterize_region", pageIndex);
+        RenderRegion(page.Get(), pixels->View(), pxPerPoint, region.x, region.y, region, renderFlags);
+    }
+
+    if (m->HasPendingStamps(pageIndex))
+    {
+        m->CompositeStamps(pageIndex, pixels->View(), pxPerPoint, region.x, region.y);
+    }
+    return pixels;
+#else
+    (void)pageIndex;
+    (void)scale;
+    (void)regionPx;
+    (void)renderFlags;
+    throw std::runtime_error("PDFium not integrated: cannot render.");
+#endif
+}
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+SoftwareBitmap PdfDocumentHandler::RenderPageRegionToSoftwareBitmap(int32_t pageIndex, float scale, PdfRect const& regionPx, int32_t renderFlags)
+{
+    return SoftwareBitmapFromPixels(RenderPageRegion(pageIndex, scale, regionPx, renderFlags)->View());
+}
+#endif
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+PdfStampId PdfDocumentHandler::StampSignatureBitmap(int32_t pageIndex, SoftwareBitmap const& signatureBitmap, PdfRect const& rectInPdfPoints)
+{
+    // Hand the SoftwareBitmap's own memory to PDFium; nothing is copied on our side.
+    LockedSoftwareBitmap locked(signatureBitmap, BitmapBufferAccessMode::Read);
+    const PdfAlphaMode alpha = signatureBitmap.BitmapAlphaMode() == BitmapAlphaMode::Premultiplied
+        ? PdfAlphaMode::Premultiplied
+        : PdfAlphaMode::Straight;
+    return StampSignaturePixels(pageIndex, locked.view, rectInPdfPoints, alpha);
+}
+#endif
+
+PdfStampId PdfDocumentHandler::StampSignaturePixels(int32_t pageIndex, ConstPixelView signature, PdfRect const& rectInPdfPoints, PdfAlphaMode alpha)
+{
+    return StampSignatureImage(pageIndex, RegisterSignatureImage(signature, alpha), rectInPdfPoints);
+}
+
+PdfSignatureImageId PdfDocumentHandler::RegisterSignatureImage(ConstPixelView signature, PdfAlphaMode alpha)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(signature.Empty(), "Invalid signature bitmap");
+
+    // Hash the input as given so a repeat registration skips compaction too.
+    const PdfSignatureImageId id = HashPixels(signature, alpha);
+    auto registered = m->signatureImages.find(id);
+    if (registered == m->signatureImages.end() || !registered->second.scratch)
+    {
+        TraceSpan span("pdf.embed_signature");
+        const CompactSignatureBitmap compact = CompactSignature(signature, alpha == PdfAlphaMode::Premultiplied);
+        auto build = [&compact, height = signature.height](FPDF_DOCUMENT scratch, FPDF_PAGE page)
+        {
+            return NewImageObject(scratch, page, compact, height);
+        };
+        if (registered == m->signatureImages.end())
+        {
+            SignatureImage image = EmbedSignature(m->doc, signature.width, signature.height, build);
+            image.contentBytes = compact.data.size();
+            m->signatureImages.emplace(id, std::move(image));
+        }
+        else
+        {
+            // Embedded already; only the scratch page for previews is drawn again.
+            registered->second.scratch = DrawSignature(signature.width, signature.height, build);
+        }
+    }
+    return id;
+#else
+    (void)signature;
+    (void)alpha;
+    throw std::runtime_error("PDFium not integrated: cannot stamp.");
+#endif
+}
+
+PdfStampId PdfDocumentHandler::StampSignatureStrokes(int32_t pageIndex, PdfInkSignature const& signature, PdfRect const& rectInPdfPoints)
+{
+    return StampSignatureImage(pageIndex, RegisterSignatureStrokes(signature), rectInPdfPoints);
+}
+
+PdfSignatureImageId PdfDocumentHandler::RegisterSignatureStrokes(PdfInkSignature const& signature)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(signature.canvasSize.width <= 0 || signature.canvasSize.height <= 0, "Invalid signature canvas size");
+
+    const bool hasInk = std::any_of(signature.strokes.begin(), signature.strokes.end(), [](auto const& stroke) { return !stroke.empty(); });
+    ThrowIf(!hasInk, "Signature has no strokes");
+
+    const PdfSignatureImageId id = HashInk(signature);
+    auto registered = m->signatureImages.find(id);
+    if (registered == m->signatureImages.end() || !registered->second.scratch)
+    {
+        TraceSpan span("pdf.embed_signature");
+        auto build = [&signature](FPDF_DOCUMENT, FPDF_PAGE) { return NewInkPathObject(signature); };
+        if (registered == m->signatureImages.end())
+        {
+            SignatureImage image = EmbedSignature(m->doc, signature.canvasSize.width, signature.canvasSize.height, build);
+            image.contentBytes = EstimatedInkBytes(signature);
+            m->signatureImages.emplace(id, std::move(image));
+        }
+        else
+        {
+            registered->second.scratch = DrawSignature(signature.canvasSize.width, signature.canvasSize.height, build);
+        }
+    }
+    return id;
+#else
+    (void)signature;
+    throw std::runtime_error("PDFium not integrated: cannot stamp.");
+#endif
+}
 
-#if __has_include("fpdfview.h") && __has_include("fpdf_edit.h") && __has_include("fpdf_save.h")
-  #include "fpdfview.h"
-  #include "fpdf_edit.h"
-  #include "fpdf_save.h"
-  #define PUT_A_SIGNATURE_HAS_PDFIUM 1
+PdfStampId PdfDocumentHandler::StampSignatureImage(int32_t pageIndex, PdfSignatureImageId image, PdfRect const& rectInPdfPoints)
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    ThrowIf(!IsLoaded(), "No document loaded");
+    auto registered = m->signatureImages.find(image);
+    ThrowIf(registered == m->signatureImages.end(), "Signature image is not registered with this document");
+    ThrowIf(!registered->second.scratch, "Signature image must be registered again to stamp it after CommitStamps");
+    ThrowIf(pageIndex < 0 || pageIndex >= PageCount(), "Invalid page index");
+    ThrowIf(rectInPdfPoints.width <= 0.0 || rectInPdfPoints.height <= 0.0, "Invalid stamp rect");
+    ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+    TraceSpan span("pdf.stamp", pageIndex);
+
+    // Only journaled; renders composite it until CommitStamps writes it into the page.
+    const PdfStamp stamp{ ++m->lastStampId, pageIndex, image, rectInPdfPoints };
+    m->ApplyStampStep(Impl::StampStep{ std::nullopt, stamp });
+    return stamp.id;
 #else
-  #define PUT_A_SIGNATURE_HAS_PDFIUM 0
+    (void)pageIndex;
+    (void)image;
+    (void)rectInPdfPoints;
+    throw std::runtime_error("PDFium not integrated: cannot stamp.");
 #endif
+}
 
-namespace
+void PdfDocumentHandler::MoveStamp(PdfStampId stamp, PdfRect const& rectInPdfPoints)
 {
-    void ThrowIf(bool condition, char const* message)
-    {
-        if (condition) throw std::runtime_error(message);
-    }
+    auto pending = m->stamps.find(stamp);
+    ThrowIf(pending == m->stamps.end(), "Stamp is not pending");
+    ThrowIf(rectInPdfPoints.width <= 0.0 || rectInPdfPoints.height <= 0.0, "Invalid stamp rect");
 
-    std::string WideToUtf8(std::wstring const& w)
-    {
-        if (w.empty()) return {};
-        int required = ::WideCharToMultiByte(CP_UTF8, 0, w.data(), static_cast<int>(w.size()), nullptr, 0, nullptr, nullptr);
-        ThrowIf(required <= 0, "WideCharToMultiByte failed");
-        std::string out(static_cast<size_t>(required), '\0');
-        int written = ::WideCharToMultiByte(CP_UTF8, 0, w.data(), static_cast<int>(w.size()), out.data(), required, nullptr, nullptr);
-        ThrowIf(written != required, "WideCharToMultiByte wrote unexpected length");
-        return out;
-    }
+    PdfStamp moved = pending->second;
+    moved.rect = rectInPdfPoints;
+    m->ApplyStampStep(Impl::StampStep{ pending->second, moved });
+}
 
-    // Minimal COM interface to access BitmapBuffer bytes.
-    struct __declspec(uuid("5B0D3235-4DBA-4D44-8659-BC8A2776DCC1")) IMemoryBufferByteAccess : IUnknown
-    {
-        virtual HRESULT __stdcall GetBuffer(uint8_t** value, uint32_t* capacity) = 0;
-    };
+void PdfDocumentHandler::RemoveStamp(PdfStampId stamp)
+{
+    auto pending = m->stamps.find(stamp);
+    ThrowIf(pending == m->stamps.end(), "Stamp is not pending");
+    m->ApplyStampStep(Impl::StampStep{ pending->second, std::nullopt });
+}
 
-    std::vector<uint8_t> CopySoftwareBitmapToBgra(SoftwareBitmap const& bmp, uint32_t& outWidth, uint32_t& outHeight, int32_t& outStride)
-    {
-        ThrowIf(bmp.BitmapPixelFormat() != BitmapPixelFormat::Bgra8, "Expected BGRA8 SoftwareBitmap");
+int32_t PdfDocumentHandler::UndoStamp()
+{
+    if (!CanUndoStamp()) return -1;
+
+    Impl::StampStep const& step = m->journal[--m->journalApplied];
+    PdfStamp const& changed = step.after ? *step.after : *step.before;
+    m->SetStamp(changed.id, step.before);
+    return changed.pageIndex;
+}
+
+int32_t PdfDocumentHandler::RedoStamp()
+{
+    if (!CanRedoStamp()) return -1;
 
-        outWidth = static_cast<uint32_t>(bmp.PixelWidth());
-        outHeight = static_cast<uint32_t>(bmp.PixelHeight());
+    Impl::StampStep const& step = m->journal[m->journalApplied++];
+    PdfStamp const& changed = step.after ? *step.after : *step.before;
+    m->SetStamp(changed.id, step.after);
+    return changed.pageIndex;
+}
 
-        BitmapBuffer buffer = bmp.LockBuffer(BitmapBufferAccessMode::Read);
-        auto desc = buffer.GetPlaneDescription(0);
-        outStride = desc.Stride;
+bool PdfDocumentHandler::CanUndoStamp() const noexcept
+{
+    return m && m->journalApplied > 0;
+}
 
-        auto reference = buffer.CreateReference();
-        uint8_t* data = nullptr;
-        uint32_t capacity = 0;
-        check_hresult(reference.as<IMemoryBufferByteAccess>()->GetBuffer(&data, &capacity));
+bool PdfDocumentHandler::CanRedoStamp() const noexcept
+{
+    return m && m->journalApplied < m->journal.size();
+}
 
-        std::vector<uint8_t> out(static_cast<size_t>(desc.Stride) * desc.Height);
-        std::memcpy(out.data(), data + desc.StartIndex, out.size());
-        return out;
+std::vector<PdfStamp> PdfDocumentHandler::PendingStamps(int32_t pageIndex) const
+{
+    std::vector<PdfStamp> pending{};
+    for (auto const& entry : m->stamps)
+    {
+        if (pageIndex < 0 || entry.second.pageIndex == pageIndex) pending.push_back(entry.second);
     }
+    return pending;
 }
 
-struct PdfDocumentHandler::Impl
+void PdfDocumentHandler::CommitStamps()
 {
-    std::wstring path{};
 #if PUT_A_SIGNATURE_HAS_PDFIUM
-    // Keep backing bytes alive when loading via FPDF_LoadMemDocument.
-    std::vector<uint8_t> docBytes{};
+    if (m->stamps.empty()) return;
+    ThrowIf(!IsLoaded(), "No document loaded");
+    TraceSpan span("pdf.commit_stamps");
 
-    // Keep image bitmaps alive for the lifetime of the document.
-    // PDFium does not clearly document ownership for FPDFImageObj_SetBitmap(), so we keep them.
-    std::vector<FPDF_BITMAP> ownedBitmaps{};
-#endif
+    // From here on stamps only leave the pending set by being inserted; if a page fails,
+    // the ones not inserted yet stay pending for the next attempt.
+    m->journal.clear();
+    m->journalApplied = 0;
 
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-    FPDF_DOCUMENT doc{ nullptr };
-#endif
+    std::map<int32_t, std::vector<PdfStamp>> byPage{};
+    for (auto const& entry : m->stamps)
+    {
+        byPage[entry.second.pageIndex].push_back(entry.second);
+    }
 
-    ~Impl()
+    for (auto const& [pageIndex, pageStamps] : byPage)
     {
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-        if (doc)
+        // The objects (or annotations) go into the cached handle itself, which for content
+        // stamps stays open until the page is flushed. An in-flight progressive render of
+        // this page holds it exclusively.
+        if (m->progressive.cacheKey.pageIndex == pageIndex)
         {
-            FPDF_CloseDocument(doc);
-            doc = nullptr;
+            CancelProgressiveRender();
+        }
+
+        PinnedPage pinned(m->pages, m->doc, pageIndex);
+        FPDF_PAGE page = pinned.Get();
+
+        // A new form object per stamp, referencing the shared XObject; only its matrix is
+        // per placement. All are created before any is inserted, so a failure leaves the
+        // page (and edits it already has) as it was.
+        std::vector<FPDF_PAGEOBJECT> objects{};
+        auto destroyObjects = [&objects]()
+        {
+            for (FPDF_PAGEOBJECT object : objects) FPDFPageObj_Destroy(object);
+        };
+        for (PdfStamp const& stamp : pageStamps)
+        {
+            SignatureImage const& signature = m->signatureImages.at(stamp.image);
+            FPDF_PAGEOBJECT formObj = FPDF_NewFormObjectFromXObject(signature.xobject);
+            if (!formObj)
+            {
+                destroyObjects();
+                throw std::runtime_error("FPDF_NewFormObjectFromXObject failed");
+            }
+            objects.push_back(formObj);
+
+            // Scale the width x height form box onto the target rect.
+            FPDFPageObj_Transform(
+                formObj,
+                stamp.rect.width / signature.width,
+                0.0,
+                0.0,
+                stamp.rect.height / signature.height,
+                stamp.rect.x,
+                stamp.rect.y);
+        }
+
+        if (m->stampMode == PdfStampMode::Annotation)
+        {
+            // One /Stamp annotation per stamp, its appearance stream holding the form
+            // object. The page dictionary only gains /Annots entries; its content stream
+            // is untouched, so the page does not become dirty. A failure removes the
+            // annotations this page got so far (and with them the objects they own).
+            const int annotsBefore = FPDFPage_GetAnnotCount(page);
+            size_t appended = 0;
+            auto undoAnnotations = [&]()
+            {
+                for (size_t i = appended; i < objects.size(); ++i) FPDFPageObj_Destroy(objects[i]);
+                for (int index = FPDFPage_GetAnnotCount(page) - 1; index >= annotsBefore; --index)
+                {
+                    FPDFPage_RemoveAnnot(page, index);
+                }
+            };
+            for (; appended < objects.size(); ++appended)
+            {
+                PdfRect const& rect = pageStamps[appended].rect;
+                FPDF_ANNOTATION annot = FPDFPage_CreateAnnot(page, FPDF_ANNOT_STAMP);
+                if (!annot)
+                {
+                    undoAnnotations();
+                    throw std::runtime_error("FPDFPage_CreateAnnot failed");
+                }
+
+                // FS_RECTF in page space: top is the larger y. The appearance stream's BBox
+                // follows the rect, so the object keeps its page-space matrix.
+                const FS_RECTF annotRect{
+                    static_cast<float>(rect.x), static_cast<float>(rect.y + rect.height),
+                    static_cast<float>(rect.x + rect.width), static_cast<float>(rect.y) };
+                const bool added = FPDFAnnot_SetRect(annot, &annotRect)
+                    && FPDFAnnot_SetFlags(annot, FPDF_ANNOT_FLAG_PRINT)
+                    && FPDFAnnot_AppendObject(annot, objects[appended]);
+                FPDFPage_CloseAnnot(annot);
+                if (!added)
+                {
+                    undoAnnotations();
+                    throw std::runtime_error("Failed to build the stamp annotation");
+                }
+            }
+            m->editStats.annotationsAdded += objects.size();
+            m->changedSinceSave = true;
+        }
+        else
+        {
+            if (!m->pages.MarkEdited(page, static_cast<uint32_t>(objects.size())))
+            {
+                destroyObjects();
+                throw std::runtime_error("Page handle cannot hold edits");
+            }
+            for (FPDF_PAGEOBJECT object : objects)
+            {
+                FPDFPage_InsertObject(page, object);
+            }
+            m->editStats.objectsInserted += objects.size();
+            m->changedSinceSave = true;
+        }
+
+        std::vector<PdfRect> damaged{};
+        for (PdfStamp const& stamp : pageStamps)
+        {
+            damaged.push_back(stamp.rect);
+            m->stamps.erase(stamp.id);
+        }
+
+        // Renders of the handle include the new objects; cached ones do not. Only the
+        // stamped rects changed, so that is all that is re-rasterized.
+        try
+        {
+            m->RepairPage(page, pageIndex, damaged);
+        }
+        catch (...)
+        {
+            m->InvalidatePage(pageIndex);
         }
-#endif
     }
-};
 
-namespace
-{
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-    std::once_flag g_pdfiumInitOnce;
+    // Committed stamps reference the XObjects in `doc`; nothing previews them any more.
+    m->CloseUnusedSignatureScratch();
 #endif
 }
 
-PdfDocumentHandler::PdfDocumentHandler()
-    : m(new Impl{})
+void PdfDocumentHandler::FlushPageContent()
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
-    std::call_once(g_pdfiumInitOnce, []()
+    if (!IsLoaded()) return;
+
+    for (int32_t pageIndex : m->pages.EditedPages())
     {
-        FPDF_InitLibrary();
-    });
+        // Pinning finds the edited handle; it is never busy outside a progressive render.
+        if (m->progressive.cacheKey.pageIndex == pageIndex)
+        {
+            CancelProgressiveRender();
+        }
+        PinnedPage pinned(m->pages, m->doc, pageIndex);
+
+        TraceSpan generateSpan("pdf.generate_content", pageIndex);
+        const bool generated = FPDFPage_GenerateContent(pinned.Get()) != 0;
+        generateSpan.End();
+        ++m->editStats.contentRegenerations;
+
+        if (!generated)
+        {
+            // The handle's object list no longer matches the page's content stream; reparse next time.
+            pinned.Reset();
+            m->pages.Discard(pageIndex);
+            m->InvalidatePage(pageIndex);
+            throw std::runtime_error("FPDFPage_GenerateContent failed");
+        }
+
+        const uint32_t edits = m->pages.MarkRegenerated(pinned.Get());
+        m->editStats.regenerationsAvoided += edits > 0 ? edits - 1 : 0;
+    }
 #endif
 }
 
-PdfDocumentHandler::~PdfDocumentHandler()
+void PdfDocumentHandler::SetStampMode(PdfStampMode mode) noexcept
 {
-    Close();
-    delete m;
-    m = nullptr;
+    m->stampMode = mode;
 }
 
-bool PdfDocumentHandler::IsLoaded() const noexcept
+PdfStampMode PdfDocumentHandler::StampMode() const noexcept
 {
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-    return m && m->doc != nullptr;
-#else
-    return false;
-#endif
+    return m->stampMode;
 }
 
-void PdfDocumentHandler::Close()
+PdfEditStats PdfDocumentHandler::EditStats() const noexcept
 {
-    if (!m) return;
-
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-    for (auto bmp : m->ownedBitmaps)
-    {
-        if (bmp) FPDFBitmap_Destroy(bmp);
-    }
-    m->ownedBitmaps.clear();
-
-    if (m->doc)
-    {
-        FPDF_CloseDocument(m->doc);
-        m->doc = nullptr;
-    }
-#endif
-
-    m->path.clear();
+    PdfEditStats stats = m->editStats;
 #if PUT_A_SIGNATURE_HAS_PDFIUM
-    m->docBytes.clear();
-    m->docBytes.shrink_to_fit();
+    stats.dirtyPages = m->pages.EditedPageCount();
 #endif
+    return stats;
 }
 
-void PdfDocumentHandler::LoadFromPath(std::wstring const& path)
+size_t PdfDocumentHandler::SignatureImageCount() const noexcept
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
-    ThrowIf(!m, "PdfDocumentHandler not initialized");
-
-    Close();
-    m->path = path;
-
-    std::string utf8Path = WideToUtf8(path);
-    m->doc = FPDF_LoadDocument(utf8Path.c_str(), nullptr);
-    if (!m->doc)
-    {
-        throw std::runtime_error("FPDF_LoadDocument failed (bad path, password needed, or PDFium load error)");
-    }
+    return m ? m->signatureImages.size() : 0;
 #else
-    (void)path;
-    throw std::runtime_error("PDFium not integrated: add PDFium headers/libs so fpdfview.h/fpdf_edit.h/fpdf_save.h are available.");
+    return 0;
 #endif
 }
 
-void PdfDocumentHandler::LoadFromBytes(std::vector<uint8_t> bytes)
+bool PdfDocumentHandler::ContinueFormFieldScan(int32_t pageBudget)
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
-    ThrowIf(!m, "PdfDocumentHandler not initialized");
+    ThrowIf(!IsLoaded(), "No document loaded");
 
-    Close();
+    const int32_t pageCount = PageCount();
+    if (m->formScanNextPage >= pageCount) return true;
 
-    // Keep the bytes alive for as long as the document is open.
-    m->docBytes = std::move(bytes);
-    if (m->docBytes.empty())
+    if (!m->form)
     {
-        throw std::runtime_error("PDF buffer is empty");
+        m->formFillInfo.version = 1;
+        m->form = FPDFDOC_InitFormFillEnvironment(m->doc, &m->formFillInfo);
+        ThrowIf(!m->form, "FPDFDOC_InitFormFillEnvironment failed");
     }
 
-#if defined(FPDF_LoadMemDocument64)
-    m->doc = FPDF_LoadMemDocument64(m->docBytes.data(), static_cast<size_t>(m->docBytes.size()), nullptr);
-#else
-    if (m->docBytes.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+    TraceSpan span("pdf.scan_fields");
+    const int32_t end = (std::min)(pageCount, m->formScanNextPage + (std::max)(pageBudget, 1));
+    for (; m->formScanNextPage < end; ++m->formScanNextPage)
     {
-        throw std::runtime_error("PDF too large for FPDF_LoadMemDocument");
+        const int32_t pageIndex = m->formScanNextPage;
+        if (!IsPageAvailable(pageIndex)) return false;
+
+        // PDFium only exposes annotations through a loaded page. A private handle keeps
+        // the scan from evicting the pages being viewed out of the page cache.
+        FPDF_PAGE page = FPDF_LoadPage(m->doc, pageIndex);
+        if (!page) continue;
+        ScanPageFormFields(m->form, page, pageIndex, m->formFields);
+        FPDF_ClosePage(page);
     }
-    m->doc = FPDF_LoadMemDocument(m->docBytes.data(), static_cast<int>(m->docBytes.size()), nullptr);
+    return m->formScanNextPage >= pageCount;
+#else
+    (void)pageBudget;
+    throw std::runtime_error("PDFium not integrated: cannot read form fields.");
 #endif
+}
 
-    if (!m->doc)
-    {
-        throw std::runtime_error("FPDF_LoadMemDocument failed (corrupt PDF, password needed, or PDFium load error)");
-    }
-#else
-    (void)bytes;
-    throw std::runtime_error("PDFium not integrated: add PDFium headers/libs so fpdfview.h/fpdf_edit.h/fpdf_save.h are available.");
+std::vector<PdfFormField> const& PdfDocumentHandler::FormFields() const noexcept
+{
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (m) return m->formFields;
 #endif
+    static const std::vector<PdfFormField> none{};
+    return none;
 }
 
-SoftwareBitmap PdfDocumentHandler::RenderPageToSoftwareBitmap(int32_t pageIndex, float scale)
+void PdfDocumentHandler::BeginProgressiveRender(int32_t pageIndex, float scale, PdfCancellationToken const& cancel, int32_t renderFlags)
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
     ThrowIf(!IsLoaded(), "No document loaded");
 
-    FPDF_PAGE page = FPDF_LoadPage(m->doc, pageIndex);
-    ThrowIf(!page, "Failed to load page");
-
-    const double pageWidthPts = FPDF_GetPageWidth(page);
-    const double pageHeightPts = FPDF_GetPageHeight(page);
-
-    const int widthPx = static_cast<int>(pageWidthPts * (96.0 / 72.0) * scale);
-    const int heightPx = static_cast<int>(pageHeightPts * (96.0 / 72.0) * scale);
-    ThrowIf(widthPx <= 0 || heightPx <= 0, "Invalid page size");
-
-    FPDF_BITMAP bitmap = FPDFBitmap_Create(widthPx, heightPx, 1);
-    ThrowIf(!bitmap, "Failed to create bitmap");
-
-    FPDFBitmap_FillRect(bitmap, 0, 0, widthPx, heightPx, 0xFFFFFFFF);
-
-    int flags = FPDF_ANNOT;
-    FPDF_RenderPageBitmap(bitmap, page, 0, 0, widthPx, heightPx, 0, flags);
-
-    uint8_t* buffer = static_cast<uint8_t*>(FPDFBitmap_GetBuffer(bitmap));
-    const int stride = FPDFBitmap_GetStride(bitmap);
+    auto& pr = m->progressive;
+    pr.Reset(PdfRenderStatus::Idle);
+    pr.cancel = cancel;
+    pr.cacheKey = RenderCacheKey{ m->docRevision, pageIndex, scale, renderFlags };
 
-    // Avoid relying on IMemoryBufferByteAccess (can fail depending on toolchain/runtime).
-    // Build a tightly-packed BGRA buffer (stride = width * 4) and create SoftwareBitmap from it.
-    const int dstStride = widthPx * 4;
-    std::vector<uint8_t> pixels(static_cast<size_t>(dstStride) * static_cast<size_t>(heightPx));
-
-    const size_t rowCopy = static_cast<size_t>((std::min)(dstStride, stride));
-    for (int y = 0; y < heightPx; ++y)
+    if (auto cached = m->renderCache.Find(pr.cacheKey))
     {
-        std::memcpy(pixels.data() + static_cast<size_t>(y) * dstStride, buffer + static_cast<size_t>(y) * stride, rowCopy);
+        pr.result = *cached;
+        pr.status = PdfRenderStatus::Done;
+        return;
     }
 
-    winrt::com_array<uint8_t> bytes(static_cast<uint32_t>(pixels.size()));
-    std::memcpy(bytes.data(), pixels.data(), pixels.size());
-    auto ibuf = CryptographicBuffer::CreateFromByteArray(bytes);
+    try
+    {
+        ThrowIf(!IsPageAvailable(pageIndex), "Page data has not arrived yet");
+        pr.page = PinnedPage(m->pages, m->doc, pageIndex, true);
 
-    SoftwareBitmap sb = SoftwareBitmap::CreateCopyFromBuffer(
-        ibuf,
-        BitmapPixelFormat::Bgra8,
-        widthPx,
-        heightPx,
-        BitmapAlphaMode::Premultiplied);
+        int widthPx = 0, heightPx = 0;
+        PagePixelSize(pr.page.Get(), scale, widthPx, heightPx);
 
-    FPDFBitmap_Destroy(bitmap);
-    FPDF_ClosePage(page);
+        pr.pixels = std::make_shared<PixelBuffer>(widthPx, heightPx);
+        pr.bitmap = WrapPixels(pr.pixels->View());
+    }
+    catch (...)
+    {
+        pr.Reset(PdfRenderStatus::Failed);
+        throw;
+    }
+    FillPixels(pr.pixels->View(), 0xFFFFFFFF);
 
-    return sb;
+    pr.pause.version = 1;
+    pr.pause.NeedToPauseNow = &Impl::ProgressiveRender::NeedToPauseNow;
+    pr.pause.user = &pr;
+    pr.status = PdfRenderStatus::InProgress;
 #else
     (void)pageIndex;
     (void)scale;
+    (void)cancel;
+    (void)renderFlags;
     throw std::runtime_error("PDFium not integrated: cannot render.");
 #endif
 }
 
-void PdfDocumentHandler::StampSignatureBitmap(int32_t pageIndex, SoftwareBitmap const& signatureBitmap, PdfRect const& rectInPdfPoints)
+PdfRenderStatus PdfDocumentHandler::ContinueProgressiveRender(std::chrono::milliseconds timeSlice)
 {
-#if PUT_A_SIGNATURE_HAS_PDFIUM
-    ThrowIf(!IsLoaded(), "No document loaded");
+    if (!m) return PdfRenderStatus::Idle;
 
-    FPDF_PAGE page = FPDF_LoadPage(m->doc, pageIndex);
-    ThrowIf(!page, "Failed to load page");
+    auto& pr = m->progressive;
+    if (pr.status != PdfRenderStatus::InProgress) return pr.status;
 
-    uint32_t sigW = 0, sigH = 0;
-    int32_t sigStride = 0;
-    std::vector<uint8_t> sigBgra = CopySoftwareBitmapToBgra(signatureBitmap, sigW, sigH, sigStride);
-    ThrowIf(sigW == 0 || sigH == 0, "Invalid signature bitmap");
-
-    // Create an owned PDFium bitmap and copy pixels into it.
-    FPDF_BITMAP sigBmp = FPDFBitmap_Create(static_cast<int>(sigW), static_cast<int>(sigH), 1);
-    ThrowIf(!sigBmp, "Failed to create signature bitmap");
-
-    uint8_t* dst = static_cast<uint8_t*>(FPDFBitmap_GetBuffer(sigBmp));
-    int dstStride = FPDFBitmap_GetStride(sigBmp);
-    const size_t rowCopy = static_cast<size_t>((std::min)(dstStride, sigStride));
-    for (uint32_t y = 0; y < sigH; ++y)
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    if (pr.cancel.IsCancelled())
     {
-        std::memcpy(dst + static_cast<size_t>(y) * dstStride, sigBgra.data() + static_cast<size_t>(y) * sigStride, rowCopy);
+        pr.Reset(PdfRenderStatus::Cancelled);
+        return pr.status;
     }
 
-    FPDF_PAGEOBJECT imageObj = FPDFPageObj_NewImageObj(m->doc);
-    ThrowIf(!imageObj, "Failed to create image object");
+    pr.deadline = std::chrono::steady_clock::now() + timeSlice;
+
+    TraceSpan span("pdf.rasterize", pr.cacheKey.pageIndex);
+    int rc = pr.started
+        ? FPDF_RenderPage_Continue(pr.page.Get(), &pr.pause)
+        : FPDF_RenderPageBitmap_Start(pr.bitmap, pr.page.Get(), 0, 0, pr.pixels->Width(), pr.pixels->Height(), 0, pr.cacheKey.flags, &pr.pause);
+    pr.started = true;
 
-    // Provide the loaded page array correctly: &page with count=1 (or NULL/0).
-    if (!FPDFImageObj_SetBitmap(&page, 1, imageObj, sigBmp))
+    if (rc == FPDF_RENDER_TOBECONTINUED)
     {
-        FPDFBitmap_Destroy(sigBmp);
-        FPDFPageObj_Destroy(imageObj);
-        FPDF_ClosePage(page);
-        throw std::runtime_error("FPDFImageObj_SetBitmap failed");
+        if (pr.cancel.IsCancelled()) pr.Reset(PdfRenderStatus::Cancelled);
+        return pr.status;
     }
 
-    if (!FPDFImageObj_SetMatrix(
-        imageObj,
-        static_cast<float>(rectInPdfPoints.width),
-        0.0f,
-        0.0f,
-        static_cast<float>(rectInPdfPoints.height),
-        static_cast<float>(rectInPdfPoints.x),
-        static_cast<float>(rectInPdfPoints.y)))
+    if (rc != FPDF_RENDER_DONE)
     {
-        FPDFBitmap_Destroy(sigBmp);
-        FPDFPageObj_Destroy(imageObj);
-        FPDF_ClosePage(page);
-        throw std::runtime_error("FPDFImageObj_SetMatrix failed");
+        pr.Reset(PdfRenderStatus::Failed);
+        return pr.status;
     }
 
-    FPDFPage_InsertObject(page, imageObj);
-    FPDFPage_GenerateContent(page);
-
-    // Keep bitmap alive for the lifetime of the document to avoid use-after-free.
-    m->ownedBitmaps.push_back(sigBmp);
-    FPDF_ClosePage(page);
+    // The buffer PDFium drew into becomes the result; no copy.
+    pr.ReleasePdfium();
+    pr.result = std::move(pr.pixels);
+    m->renderCache.Insert(pr.cacheKey, pr.result, pr.result->SizeBytes());
+    pr.status = PdfRenderStatus::Done;
+    return pr.status;
 #else
-    (void)pageIndex;
-    (void)signatureBitmap;
-    (void)rectInPdfPoints;
-    throw std::runtime_error("PDFium not integrated: cannot stamp.");
+    (void)timeSlice;
+    return PdfRenderStatus::Failed;
+#endif
+}
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+SoftwareBitmap PdfDocumentHandler::ProgressiveRenderSnapshot()
+{
+    if (!m) return nullptr;
+
+    auto& pr = m->progressive;
+    std::shared_ptr<PixelBuffer const> pixels = pr.result ? pr.result : pr.pixels;
+    if (!pixels) return nullptr;
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    pixels = m->WithStamps(pr.cacheKey.pageIndex, std::move(pixels), pr.cacheKey.scale * (96.0 / 72.0));
 #endif
+    return SoftwareBitmapFromPixels(pixels->View());
+}
+#endif
+
+void PdfDocumentHandler::CancelProgressiveRender() noexcept
+{
+    if (!m) return;
+    if (m->progressive.status == PdfRenderStatus::InProgress)
+    {
+        m->progressive.Reset(PdfRenderStatus::Cancelled);
+    }
 }
 
-void PdfDocumentHandler::SaveAs(std::wstring const& outputPath)
+PdfSaveStats PdfDocumentHandler::SaveAs(std::wstring const& outputPath, PdfSaveMode mode)
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
     ThrowIf(!IsLoaded(), "No document loaded");
+    ThrowIf(m->avail && !m->incoming.Complete(), "The document is still loading");
+    CommitStamps();
+    FlushPageContent();
+
+    TraceSpan span("pdf.save");
+    const auto started = std::chrono::steady_clock::now();
+
+    // An incremental save re-emits the original file verbatim before appending. For a
+    // mapped document those bytes are already in the source file, so we start from the
+    // source (the file itself, or an OS-level copy of it) and write only the tail.
+    const bool mapped = m->mappedFile.IsOpen();
+    std::error_code ec{};
+    const bool sameFile = mapped && std::filesystem::equivalent(outputPath, m->path, ec);
+    ThrowIf(sameFile && mode == PdfSaveMode::FullRewrite,
+        "Cannot rewrite the open document in place; save incrementally or to another file");
+
+    const bool reuseOriginal = mapped && mode == PdfSaveMode::Incremental;
+    if (reuseOriginal && !sameFile)
+    {
+        ThrowIf(!std::filesystem::copy_file(m->path, outputPath, std::filesystem::copy_options::overwrite_existing, ec),
+            "Failed to copy the document to the output file");
+    }
 
-    // Simple synchronous file writer for FPDF_SaveAsCopy.
-    struct FileWriter
+    // Adapts PDFium's block writes to the buffered writer. Original bytes that are already
+    // on disk are checked against the mapping and skipped instead of written.
+    struct BlockWriter
     {
         FPDF_FILEWRITE iface{};
-        HANDLE hFile{ INVALID_HANDLE_VALUE };
+        BufferedFileWriter* out{};
+        uint8_t const* original{};
+        uint64_t originalSize{};
+        uint64_t offset{};
+        uint64_t blocks{};
 
         static int WriteBlock(FPDF_FILEWRITE* pThis, const void* data, unsigned long size)
         {
-            auto self = reinterpret_cast<FileWriter*>(pThis);
-            DWORD written = 0;
-            BOOL ok = ::WriteFile(self->hFile, data, size, &written, nullptr);
-            return (ok && written == size) ? 1 : 0;
+            auto self = reinterpret_cast<BlockWriter*>(pThis);
+            ++self->blocks;
+            try
+            {
+                auto const* bytes = static_cast<uint8_t const*>(data);
+                size_t remaining = size;
+                if (self->offset < self->originalSize)
+                {
+                    const size_t reused = static_cast<size_t>((std::min)(static_cast<uint64_t>(remaining), self->originalSize - self->offset));
+                    if (std::memcmp(bytes, self->original + self->offset, reused) != 0) return 0;
+                    bytes += reused;
+                    remaining -= reused;
+                    self->offset += reused;
+                }
+                if (remaining > 0)
+                {
+                    self->out->Write(bytes, remaining);
+                    self->offset += remaining;
+                }
+                return 1;
+            }
+            catch (...)
+            {
+                return 0;
+            }
         }
     };
 
-    FileWriter writer{};
-    writer.iface.version = 1;
-    writer.iface.WriteBlock = &FileWriter::WriteBlock;
-
-    writer.hFile = ::CreateFileW(
-        outputPath.c_str(),
-        GENERIC_WRITE,
-        0,
-        nullptr,
-        CREATE_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        nullptr);
+    const uint64_t originalSize = reuseOriginal ? m->mappedFile.Size() : 0;
+    BufferedFileWriter out(
+        outputPath,
+        reuseOriginal ? BufferedFileWriter::OpenMode::Existing : BufferedFileWriter::OpenMode::Truncate,
+        originalSize);
 
-    ThrowIf(writer.hFile == INVALID_HANDLE_VALUE, "Failed to open output file for writing");
+    BlockWriter writer{};
+    writer.iface.version = 1;
+    writer.iface.WriteBlock = &BlockWriter::WriteBlock;
+    writer.out = &out;
+    writer.original = reuseOriginal ? m->mappedFile.Data() : nullptr;
+    writer.originalSize = originalSize;
 
-    if (!FPDF_SaveAsCopy(m->doc, &writer.iface, 0))
+    const FPDF_DWORD flags = mode == PdfSaveMode::Incremental ? FPDF_INCREMENTAL : FPDF_NO_INCREMENTAL;
+    if (!FPDF_SaveAsCopy(m->doc, &writer.iface, flags) || writer.offset < originalSize)
     {
-        ::CloseHandle(writer.hFile);
+        // Never leave a half-appended tail on a file that was valid before.
+        out.Abandon();
         throw std::runtime_error("FPDF_SaveAsCopy failed");
     }
-
-    ::CloseHandle(writer.hFile);
+    out.Finish();
+
+    // The file now holds everything, committed stamps included.
+    m->savedPath = outputPath;
+    m->changedSinceSave = false;
+
+    PdfSaveStats stats{};
+    stats.bytesWritten = out.BytesWritten();
+    stats.bytesReused = originalSize;
+    stats.pdfiumBlocks = writer.blocks;
+    stats.diskWrites = out.DiskWrites();
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return stats;
 #else
     (void)outputPath;
+    (void)mode;
     throw std::runtime_error("PDFium not integrated: cannot save.");
 #endif
 }
 
+PdfMemoryUsage PdfDocumentHandler::MemoryUsage() const noexcept
+{
+    PdfMemoryUsage usage{};
+    if (!m) return usage;
+
+    usage.renderCacheBytes = m->renderCache.Stats().bytes + m->tileCache.Stats().bytes + m->thumbnailCache.Stats().bytes;
+    if (m->progressive.pixels) usage.retainedBitmapBytes += m->progressive.pixels->SizeBytes();
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    usage.documentBytes = m->docBytes.capacity() + (m->incoming.IsOpen() ? static_cast<size_t>(m->incoming.Size()) : 0);
+    usage.mappedBytes = m->mappedFile.IsOpen() ? static_cast<size_t>(m->mappedFile.Size()) : 0;
+    usage.pageHandles = m->pages.Size();
+    usage.pageHandleBytes = usage.pageHandles * EstimatedPageHandleBytes;
+    for (auto const& entry : m->signatureImages)
+    {
+        // Embedded content stays in the document; the scratch copy only while stamps
+        // can still show it.
+        SignatureImage const& image = entry.second;
+        usage.retainedBitmapBytes += image.contentBytes * (image.scratch ? 2 : 1);
+        if (!image.preview.Empty()) usage.retainedBitmapBytes += image.preview.SizeBytes();
+    }
+#endif
+    return usage;
+}
+
+void PdfDocumentHandler::ReleaseCaches() noexcept
+{
+    if (!m) return;
+
+    m->renderCache.Clear();
+    m->tileCache.Clear();
+    m->thumbnailCache.Clear();
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    m->pages.CloseIdle();
+    for (auto& entry : m->signatureImages)
+    {
+        entry.second.preview = PixelBuffer{};
+    }
+    m->CloseUnusedSignatureScratch();
+#endif
+}
+
+std::wstring PdfDocumentHandler::ReopenPath() const
+{
+    if (!m || !IsLoaded() || m->changedSinceSave || !m->stamps.empty()) return {};
+    return m->savedPath;
+}
+
 int32_t PdfDocumentHandler::PageCount() const noexcept
 {
 #if PUT_A_SIGNATURE_HAS_PDFIUM
@@ -392,3 +2590,51 @@ int32_t PdfDocumentHandler::PageCount() const noexcept
     return 0;
 #endif
 }
+
+void PdfDocumentHandler::SetRenderCacheBudget(size_t budgetBytes)
+{
+    if (!m) return;
+    m->renderCache.SetBudget(budgetBytes);
+}
+
+CacheStats PdfDocumentHandler::RenderCacheStats() const noexcept
+{
+    return m ? m->renderCache.Stats() : CacheStats{};
+}
+
+void PdfDocumentHandler::ClearRenderCache() noexcept
+{
+    if (m) m->renderCache.Clear();
+}
+
+void PdfDocumentHandler::SetTileCacheBudget(size_t budgetBytes)
+{
+    if (!m) return;
+    m->tileCache.SetBudget(budgetBytes);
+}
+
+CacheStats PdfDocumentHandler::TileCacheStats() const noexcept
+{
+    return m ? m->tileCache.Stats() : CacheStats{};
+}
+
+void PdfDocumentHandler::SetThumbnailCacheBudget(size_t budgetBytes)
+{
+    if (!m) return;
+    m->thumbnailCache.SetBudget(budgetBytes);
+}
+
+CacheStats PdfDocumentHandler::ThumbnailCacheStats() const noexcept
+{
+    return m ? m->thumbnailCache.Stats() : CacheStats{};
+}
+
+void PdfDocumentHandler::SetPageHandleCacheCapacity(size_t pageCount)
+{
+    if (!m) return;
+#if PUT_A_SIGNATURE_HAS_PDFIUM
+    m->pages.SetCapacity(pageCount);
+#else
+    (void)pageCount;
+#endif
+}
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include <winrt/Windows.Graphics.Imaging.h>
+// Headless builds (tools/, defined by their CMakeLists) compile the PDFium core
+// without the Windows App SDK and leave out the SoftwareBitmap conveniences.
+#if defined(PUT_A_SIGNATURE_HEADLESS)
+  #define PUT_A_SIGNATURE_HAS_WINRT 0
+#else
+  #define PUT_A_SIGNATURE_HAS_WINRT 1
+  #include <winrt/Windows.Graphics.Imaging.h>
+#endif
+
+#include "IncomingFile.h"
+#include "LruByteCache.h"
+#include "PixelBuffer.h"
 
 struct PdfRect
 {
@@ -14,12 +28,227 @@ struct PdfRect
     double height{};
 };
 
+struct PdfSize
+{
+    double width{};
+    double height{};
+};
+
+struct PdfPoint
+{
+    double x{};
+    double y{};
+};
+
+// A page's text as PDFium extracts it: UTF-16 code units in reading order, and one box
+// per unit in PDF points (bottom-left origin). Characters PDFium generates (spaces and
+// line breaks between text runs) have an empty box.
+struct PdfPageText
+{
+    std::u16string text{};
+    std::vector<PdfRect> charBoxes{};
+};
+
+// A hand-drawn signature as captured: one point list per stroke, in the capture
+// surface's coordinates (top-left origin, y down) and units.
+struct PdfInkSignature
+{
+    std::vector<std::vector<PdfPoint>> strokes{};
+    PdfSize canvasSize{};           // the capture surface; it is scaled onto the stamp rect
+    double strokeWidth{ 3.0 };      // in capture units
+    uint32_t colorArgb{ 0xFF000000 };
+};
+
+enum class PdfFormFieldType
+{
+    Unknown,
+    PushButton,
+    CheckBox,
+    RadioButton,
+    ComboBox,
+    ListBox,
+    Text,
+    Signature,
+};
+
+// One widget (on-page box) of an interactive form field. A field can have several.
+struct PdfFormField
+{
+    int32_t pageIndex{};
+    PdfRect rect{};                 // PDF points, bottom-left origin
+    std::u16string name{};          // fully qualified, e.g. "buyer.signature"
+    PdfFormFieldType type{ PdfFormFieldType::Unknown };
+    bool filled{ false };           // signed, checked, or has a value
+};
+
+// How colour relates to alpha in caller-supplied BGRA pixels.
+enum class PdfAlphaMode
+{
+    Straight,       // PDFium's own convention
+    Premultiplied,  // e.g. RenderTargetBitmap / SoftwareBitmap captures
+};
+
+// Signature image embedded in the open document (see RegisterSignatureImage).
+using PdfSignatureImageId = uint64_t;
+
+// A placement in the stamp journal (see StampSignatureImage), not yet written into its page.
+using PdfStampId = uint64_t;
+
+struct PdfStamp
+{
+    PdfStampId id{};
+    int32_t pageIndex{};
+    PdfSignatureImageId image{};
+    PdfRect rect{};                 // PDF points, bottom-left origin
+};
+
+// Zoom tile address: column/row of a TileSizePx square in the page rendered at some scale.
+struct PdfTile
+{
+    int32_t column{};
+    int32_t row{};
+};
+
+// Cancellation flag shared between whoever requests a render and the render itself.
+// Copies share the same flag, so the UI can keep one and hand another to the handler.
+class PdfCancellationToken
+{
+public:
+    void Cancel() const noexcept { m_cancelled->store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const noexcept { return m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled{ std::make_shared<std::atomic<bool>>(false) };
+};
+
+enum class PdfSaveMode
+{
+    // Original bytes kept as they are, objects appended with a new xref section, so
+    // existing digital signatures stay valid. The tail is small (about 1 KB with nothing
+    // stamped, plus the annotations of PdfStampMode::Annotation stamps) until a page's
+    // content is regenerated: after FPDFPage_GenerateContent (FlushPageContent, for
+    // PageContent stamps) PDFium appends every object it has parsed, so the tail is as
+    // big as a full rewrite. Large images it has parsed, such as a scanned page's, are
+    // appended again in either mode. Stamp as annotations when appends must stay small.
+    Incremental,
+    // Whole document rewritten (and compacted).
+    FullRewrite,
+};
+
+struct PdfSaveStats
+{
+    uint64_t bytesWritten{};  // bytes that actually went to disk
+    uint64_t bytesReused{};   // original bytes already in place (incremental save), not written again
+    uint64_t pdfiumBlocks{};  // WriteBlock calls from PDFium
+    uint64_t diskWrites{};    // WriteFile calls after coalescing
+    double elapsedMs{};
+};
+
+// How CommitStamps writes a stamp into the document.
+enum class PdfStampMode
+{
+    // A form object in the page's content stream, which FlushPageContent then regenerates.
+    PageContent,
+    // A /Stamp annotation drawing the signature from its own appearance stream. The page's
+    // content stream is left byte-for-byte intact, so an incremental save appends only
+    // the annotation, its appearance stream and the page dictionary, and removing the
+    // signature later means dropping one annotation. PDFium does re-append every object it
+    // has parsed, so a scanned page's image stream is written again.
+    Annotation,
+};
+
+struct PdfEditStats
+{
+    uint64_t objectsInserted{};          // page objects added (PageContent stamps)
+    uint64_t annotationsAdded{};         // stamp annotations added (Annotation stamps)
+    uint64_t contentRegenerations{};     // FPDFPage_GenerateContent calls
+    uint64_t regenerationsAvoided{};     // insertions that shared a page's regeneration
+    size_t dirtyPages{};                 // pages with insertions not regenerated yet
+};
+
+// Memory one document holds, by owner (MemoryUsage). A mapped file is paged in on
+// demand and shared with the OS file cache, so it is reported but left out of Total().
+struct PdfMemoryUsage
+{
+    size_t documentBytes{};        // file bytes copied into memory (LoadFromBytes, progressive load)
+    size_t mappedBytes{};          // size of the mapped file (LoadFromPath)
+    size_t pageHandles{};          // open page handles
+    size_t pageHandleBytes{};      // estimate: EstimatedPageHandleBytes per handle
+    size_t renderCacheBytes{};     // cached page renders, zoom tiles and thumbnails
+    size_t retainedBitmapBytes{};  // signature content (estimate) and previews, progressive render target
+
+    size_t Total() const noexcept { return documentBytes + pageHandleBytes + renderCacheBytes + retainedBitmapBytes; }
+};
+
+enum class PdfRenderStatus
+{
+    Idle,
+    InProgress,
+    Done,
+    Cancelled,
+    Failed,
+};
+
+enum class PdfLoadStatus
+{
+    Idle,       // no progressive load
+    NeedData,   // the document cannot be opened yet; keep feeding bytes
+    Ready,      // the document is open; pages render once IsPageAvailable says so
+    Complete,   // every byte has arrived
+    Failed,
+};
+
 // Minimal PDFium wrapper focused on:
 // - Load document
-// - Render page -> SoftwareBitmap (BGRA8)
-// - Stamp a signature bitmap onto a page
+// - Render page -> PixelBuffer / SoftwareBitmap (BGRA8)
+// - Stamp a signature bitmap onto a page (journaled, with undo/redo)
 // - Save as a new file
 //
+// PDFium renders straight into PixelBuffer memory (FPDFBitmap_CreateEx) and reads
+// signature pixels straight from the caller's memory; the only remaining copy is
+// into a SoftwareBitmap for display.
+//
+// Rendered pages are kept in an LRU cache bounded by a byte budget, keyed by
+// (page index, scale, render flags, document revision). Committing stamps to a
+// page drops that page's cached renders.
+//
+// Pages that get objects inserted are marked dirty and their handles kept open (the
+// objects live in the handle); each dirty page's content stream is regenerated once,
+// by FlushPageContent or SaveAs, however many insertions it got.
+//
+// SetStampMode(PdfStampMode::Annotation) commits stamps as annotations instead:
+// nothing is inserted into the page content, so those pages never become dirty.
+//
+// Stamps are journaled: the Stamp* calls, MoveStamp and RemoveStamp record steps
+// that UndoStamp / RedoStamp walk through, and every render composites the pending
+// stamps over the page's cached raster. Page content is only written when
+// CommitStamps runs (SaveAs commits first), so placing, moving or undoing a
+// signature costs neither a content stream rewrite nor a page re-render.
+//
+// For deep zoom, RenderTile renders fixed-size tiles of the page at any scale
+// through a clipped FPDF_RenderPageBitmapWithMatrix, so only the tiles covering
+// the viewport are rasterized and memory follows the screen, not the zoom.
+// Tiles have their own byte-budgeted cache.
+//
+// RenderPageRegion re-rasterizes just a rectangle of a page render the same way,
+// for patching a displayed raster after a small change. CommitStamps repairs its
+// cached page renders like that too: only the stamped rects are rendered again,
+// and only the tiles they touch are dropped.
+//
+// Progressive rendering (BeginProgressiveRender / ContinueProgressiveRender) runs
+// one render in time slices so the caller can yield between slices, show partial
+// output, and abandon a stale page within a slice. Only one progressive render
+// is active at a time; beginning a new one abandons the previous one.
+//
+// Progressive loading (BeginProgressiveLoad) opens a document while its bytes are
+// still arriving, through PDFium's FPDF_AVAIL: a linearized file opens and shows its
+// first page after its first few chunks, and other pages become available as their
+// data lands. The caller asks NextLoadRange what to read next, so the parts PDFium
+// needs are read first even for files that are not linearized.
+//
+// Not thread-safe, and PDFium itself is not either: all calls must come from one
+// thread. The app routes them through PdfExecutor.
+//
 // If PDFium headers are not available, this compiles but throws at runtime
 // with a clear "PDFium not integrated" message.
 class PdfDocumentHandler
@@ -33,29 +262,251 @@ public:
 
     bool IsLoaded() const noexcept;
 
+    // Closes the document and frees what it holds. Settings (cache budgets and
+    // capacities, stamp mode) are kept for the next document.
+    void Close();
+
+    // Memory-maps the file and loads it through FPDF_LoadCustomDocument, so only the
+    // parts PDFium reads are paged in. The file stays open (read-shared) until Close().
     void LoadFromPath(std::wstring const& path);
 
     // Preferred for packaged apps: load from in-memory PDF bytes (keeps bytes alive for PDFium).
     void LoadFromBytes(std::vector<uint8_t> bytes);
 
+    // Start loading a fileSize-byte document whose bytes will be fed in with AddLoadData:
+    //
+    //     BeginProgressiveLoad(size);
+    //     for (range = NextLoadRange(chunk); range.length; range = NextLoadRange(chunk))
+    //     {
+    //         AddLoadData(range.offset, read(range), range.length);
+    //         ContinueProgressiveLoad(); // Ready: show the first page
+    //     }
+    //
+    // The document counts as loaded (PageCount, rendering) from Ready on; before
+    // Complete, only pages for which IsPageAvailable is true can be rendered or stamped,
+    // and SaveAs throws.
+    void BeginProgressiveLoad(uint64_t fileSize);
+
+    // Bytes of the file at `offset`; chunks may arrive in any order.
+    void AddLoadData(uint64_t offset, uint8_t const* data, size_t size);
+
+    // What to read next, at most maxLength bytes: ranges PDFium asked for (document
+    // structure, then pages asked about through IsPageAvailable) first, otherwise the
+    // next missing bytes in file order. Length 0 once everything has arrived.
+    FileByteRange NextLoadRange(uint64_t maxLength);
+
+    // Re-checks availability after new data; opens the document as soon as PDFium can.
+    PdfLoadStatus ContinueProgressiveLoad();
+    PdfLoadStatus ProgressiveLoadStatus() const noexcept;
+
+    // Whether the page's data has arrived. Always true for documents loaded whole. If
+    // not, the ranges the page needs go to the front of NextLoadRange.
+    bool IsPageAvailable(int32_t pageIndex);
+
+    // Page a linearized file delivers first (usually 0; always 0 for other files).
+    int32_t FirstAvailablePage() const noexcept;
+
+    // PDFium render flags used when none are given (FPDF_ANNOT).
+    static constexpr int32_t DefaultRenderFlags = 0x01;
+
+    // Default render cache budget: roughly eight A4 pages at scale 2.0.
+    static constexpr size_t DefaultRenderCacheBudgetBytes = 128u * 1024u * 1024u;
+
+    // Render a page into a BGRA8 PixelBuffer. The buffer may be served from (and shared
+    // with) the render cache, hence const.
+    std::shared_ptr<PixelBuffer const> RenderPage(int32_t pageIndex, float scale, int32_t renderFlags = DefaultRenderFlags);
+
+#if PUT_A_SIGNATURE_HAS_WINRT
     // Render a page to a BGRA8 SoftwareBitmap (premultiplied alpha).
     // scale: 1.0 = native pixel size based on page points -> pixels at 96 DPI (placeholder).
-    winrt::Windows::Graphics::Imaging::SoftwareBitmap RenderPageToSoftwareBitmap(int32_t pageIndex, float scale);
+    // renderFlags: PDFium FPDF_* render flags.
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap RenderPageToSoftwareBitmap(int32_t pageIndex, float scale, int32_t renderFlags = DefaultRenderFlags);
+#endif
+
+    // Zoom tiles are TileSizePx square (smaller along the page's right/bottom edges).
+    static constexpr int32_t TileSizePx = 256;
+    static constexpr size_t DefaultTileCacheBudgetBytes = 64u * 1024u * 1024u;
+
+    PdfSize PageSizePoints(int32_t pageIndex);
+
+    // Sizes of every page without loading page content; used to lay out the continuous view.
+    std::vector<PdfSize> PageSizesPoints();
+
+    // Text and character boxes of a page (for TextIndex). Throws if the page's data has
+    // not arrived yet (see IsPageAvailable).
+    PdfPageText ExtractPageText(int32_t pageIndex);
+
+    // Thumbnails fit in a maxEdgePx square. The page's embedded thumbnail is used when it
+    // has one; otherwise the page is rendered small. Cached separately from page renders.
+    static constexpr int32_t DefaultThumbnailMaxEdgePx = 160;
+    static constexpr size_t DefaultThumbnailCacheBudgetBytes = 16u * 1024u * 1024u;
+
+    std::shared_ptr<PixelBuffer const> RenderThumbnail(int32_t pageIndex, int32_t maxEdgePx = DefaultThumbnailMaxEdgePx);
+#if PUT_A_SIGNATURE_HAS_WINRT
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap RenderThumbnailToSoftwareBitmap(int32_t pageIndex, int32_t maxEdgePx = DefaultThumbnailMaxEdgePx);
+#endif
+
+    // Tiles of the page rendered at `scale` that intersect viewportPx (pixels at that scale, top-left origin).
+    std::vector<PdfTile> TilesInViewport(int32_t pageIndex, float scale, PdfRect const& viewportPx);
 
+    std::shared_ptr<PixelBuffer const> RenderTile(int32_t pageIndex, float scale, PdfTile tile, int32_t renderFlags = DefaultRenderFlags);
+#if PUT_A_SIGNATURE_HAS_WINRT
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap RenderTileToSoftwareBitmap(int32_t pageIndex, float scale, PdfTile tile, int32_t renderFlags = DefaultRenderFlags);
+#endif
+
+    // Pixels of the page rendered at `scale` (top-left origin) that rectInPdfPoints covers,
+    // rounded out to whole pixels and clipped to the page; empty if it misses the page.
+    PdfRect PageRectToPixels(int32_t pageIndex, float scale, PdfRect const& rectInPdfPoints);
+
+    // The regionPx part of RenderPage(pageIndex, scale), pending stamps included. Cut from
+    // the cached page render when there is one; otherwise only the region is rasterized.
+    // Not cached.
+    std::shared_ptr<PixelBuffer const> RenderPageRegion(int32_t pageIndex, float scale, PdfRect const& regionPx, int32_t renderFlags = DefaultRenderFlags);
+#if PUT_A_SIGNATURE_HAS_WINRT
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap RenderPageRegionToSoftwareBitmap(int32_t pageIndex, float scale, PdfRect const& regionPx, int32_t renderFlags = DefaultRenderFlags);
+#endif
+
+    // Start a progressive render of a page. A cache hit completes immediately.
+    // Cancelling the token stops the render at the next PDFium pause check.
+    void BeginProgressiveRender(int32_t pageIndex, float scale, PdfCancellationToken const& cancel, int32_t renderFlags = DefaultRenderFlags);
+
+    // Run the active progressive render for at most roughly timeSlice.
+    // Returns InProgress while more work remains; Done once the result is available.
+    PdfRenderStatus ContinueProgressiveRender(std::chrono::milliseconds timeSlice);
+
+#if PUT_A_SIGNATURE_HAS_WINRT
+    // Copy of what has been drawn so far (white where PDFium has not painted yet).
+    // After Done this is the finished page, which is also put in the render cache.
+    // Returns nullptr if there is no active render.
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap ProgressiveRenderSnapshot();
+#endif
+
+    // Abandon the active progressive render, if any.
+    void CancelProgressiveRender() noexcept;
+
+#if PUT_A_SIGNATURE_HAS_WINRT
     // Stamp a signature bitmap (BGRA8) onto a page at rectInPdfPoints (PDF points).
     // Coordinate conversion from UI pixels is intentionally a placeholder and should be handled by the UI layer.
-    void StampSignatureBitmap(int32_t pageIndex,
+    PdfStampId StampSignatureBitmap(int32_t pageIndex,
         winrt::Windows::Graphics::Imaging::SoftwareBitmap const& signatureBitmap,
         PdfRect const& rectInPdfPoints);
+#endif
+
+    // Same, from caller-owned BGRA pixels. The memory only has to stay valid for the
+    // duration of the call. Equivalent to RegisterSignatureImage + StampSignatureImage,
+    // so stamping the same pixels again reuses the embedded image.
+    PdfStampId StampSignaturePixels(int32_t pageIndex, ConstPixelView signature, PdfRect const& rectInPdfPoints,
+        PdfAlphaMode alpha = PdfAlphaMode::Straight);
+
+    // Embed a signature image in the open document once and return its id. Pixels that
+    // are already embedded (same content hash) return the existing id without
+    // re-encoding. Only the ink's bounding box is embedded, as opaque gray or as one
+    // ink colour plus soft mask when possible (see CompactSignature); the ink stays
+    // where it was within the full bitmap. The pixels are not retained: previews of
+    // pending stamps come from a copy that CommitStamps releases, and registering the
+    // pixels again after that redraws it (the embedded image is still reused). Throws if
+    // the bitmap is fully transparent.
+    PdfSignatureImageId RegisterSignatureImage(ConstPixelView signature, PdfAlphaMode alpha = PdfAlphaMode::Straight);
+
+    // Place a registered image on a page. Every placement references the same image
+    // stream, so output size does not grow with the number of stamps. Ids are valid
+    // until the document is closed or another one is loaded.
+    //
+    // The placement goes into the stamp journal: renders show it from now on, and it is
+    // written into the page by CommitStamps. Returns its id for MoveStamp / RemoveStamp.
+    // Images last registered before a CommitStamps must be registered again first, which
+    // StampSignaturePixels and StampSignatureStrokes do.
+    PdfStampId StampSignatureImage(int32_t pageIndex, PdfSignatureImageId image, PdfRect const& rectInPdfPoints);
+
+    // Stamp a signature as vector paths (one stroked path, round caps and joins) instead
+    // of an image: a few KB, sharp at any zoom, and no UI capture step. The canvas is
+    // mapped onto rectInPdfPoints the same way a captured bitmap would be.
+    PdfStampId StampSignatureStrokes(int32_t pageIndex, PdfInkSignature const& signature, PdfRect const& rectInPdfPoints);
+
+    // Vector counterpart of RegisterSignatureImage; place the result with StampSignatureImage.
+    PdfSignatureImageId RegisterSignatureStrokes(PdfInkSignature const& signature);
+
+    // Number of distinct signature images embedded since the document was loaded.
+    size_t SignatureImageCount() const noexcept;
+
+    // Journal steps: each call can be undone. Throw if the stamp is not pending.
+    void MoveStamp(PdfStampId stamp, PdfRect const& rectInPdfPoints);
+    void RemoveStamp(PdfStampId stamp);
+
+    // Step back / forward through the journal. Return the page the step changed, or -1
+    // if there was nothing to undo / redo. A new step drops what could be redone.
+    int32_t UndoStamp();
+    int32_t RedoStamp();
+    bool CanUndoStamp() const noexcept;
+    bool CanRedoStamp() const noexcept;
 
-    void SaveAs(std::wstring const& outputPath);
+    // Stamps not written into their pages yet, in placement order; -1 for every page.
+    std::vector<PdfStamp> PendingStamps(int32_t pageIndex = -1) const;
+
+    // Writes the pending stamps into their pages (as content, marking the pages dirty, or as
+    // annotations; see SetStampMode) and clears the journal: committed stamps can no
+    // longer be undone or moved.
+    void CommitStamps();
+
+    // How the next CommitStamps writes stamps; PageContent by default. Kept across documents.
+    void SetStampMode(PdfStampMode mode) noexcept;
+    PdfStampMode StampMode() const noexcept;
+
+    // Regenerates the content stream of every dirty page, once each.
+    void FlushPageContent();
+    PdfEditStats EditStats() const noexcept;
+
+    // Finds the form fields (widget annotations) from the pages' annotation lists, without
+    // rendering, pageBudget pages per call so the caller can interleave other work.
+    // Returns true once every page has been scanned, false if there is more to do (or the
+    // next page's data has not arrived yet). The results accumulate in FormFields, in page
+    // order, and are kept until the document is closed.
+    bool ContinueFormFieldScan(int32_t pageBudget);
+    std::vector<PdfFormField> const& FormFields() const noexcept;
+
+    // Commits pending stamps and flushes dirty pages first. Saving incrementally over the
+    // document's own file (or to a copy of it, for documents opened with LoadFromPath)
+    // does not write the original bytes again, only the tail PDFium appends. After
+    // PageContent stamps that tail is as big as a FullRewrite output, so the incremental
+    // file is the source plus a full rewrite (about 773 KB against 156 KB for a 617 KB
+    // text document); see PdfSaveMode::Incremental.
+    PdfSaveStats SaveAs(std::wstring const& outputPath, PdfSaveMode mode = PdfSaveMode::Incremental);
 
     // Returns number of pages in the loaded document, or 0 if not loaded / PDFium not integrated.
     int32_t PageCount() const noexcept;
 
-private:
-    void Close();
+    // Render cache controls. Lowering the budget evicts immediately; 0 disables caching.
+    void SetRenderCacheBudget(size_t budgetBytes);
+    CacheStats RenderCacheStats() const noexcept;
+    void ClearRenderCache() noexcept;
+
+    // Open page handles kept between calls so PDFium does not reparse a page on every render.
+    static constexpr size_t DefaultPageHandleCacheCapacity = 8;
+    void SetPageHandleCacheCapacity(size_t pageCount);
 
+    void SetTileCacheBudget(size_t budgetBytes);
+    CacheStats TileCacheStats() const noexcept;
+
+    void SetThumbnailCacheBudget(size_t budgetBytes);
+    CacheStats ThumbnailCacheStats() const noexcept;
+
+    // PDFium does not report what a parsed page costs; this is a rough figure for a page
+    // with its content and fonts loaded, used to account for open handles.
+    static constexpr size_t EstimatedPageHandleBytes = 512u * 1024u;
+
+    PdfMemoryUsage MemoryUsage() const noexcept;
+
+    // Drops the render, tile and thumbnail caches, the signature previews and the page
+    // handles nobody is using; handles of dirty pages stay. Budgets are unchanged, so
+    // the caches fill up again with use.
+    void ReleaseCaches() noexcept;
+
+    // A file the document can be reopened from as it is now: the file it was loaded
+    // from or last saved to, provided nothing was stamped since. Empty otherwise, and
+    // for documents loaded from bytes or progressively.
+    std::wstring ReopenPath() const;
+
+private:
     struct Impl;
     Impl* m{};
 };
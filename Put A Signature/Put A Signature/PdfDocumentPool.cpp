@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "PdfDocumentPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "TraceLog.h"
+
+PdfDocumentPool::PdfDocumentPool(size_t budgetBytes) noexcept
+    : m_budget(budgetBytes)
+{
+}
+
+PdfDocumentId PdfDocumentPool::Add()
+{
+    Entry entry{};
+    entry.id = ++m_lastId;
+    entry.pdf = std::make_unique<PdfDocumentHandler>();
+    m_entries.push_front(std::move(entry));
+    return m_entries.front().id;
+}
+
+void PdfDocumentPool::Remove(PdfDocumentId id) noexcept
+{
+    auto it = Find(id);
+    if (it != m_entries.end()) m_entries.erase(it);
+}
+
+bool PdfDocumentPool::Contains(PdfDocumentId id) const noexcept
+{
+    return std::any_of(m_entries.begin(), m_entries.end(), [id](Entry const& entry) { return entry.id == id; });
+}
+
+PdfDocumentHandler& PdfDocumentPool::Use(PdfDocumentId id)
+{
+    auto it = Find(id);
+    if (it == m_entries.end()) throw std::out_of_range("Unknown document");
+
+    if (!it->parkedPath.empty())
+    {
+        TraceSpan span("pool.reopen");
+        it->pdf->LoadFromPath(it->parkedPath);
+        it->parkedPath.clear();
+        ++m_stats.reopened;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return *m_entries.front().pdf;
+}
+
+size_t PdfDocumentPool::Enforce()
+{
+    size_t total = MemoryBytes();
+    if (total <= m_budget || m_entries.size() < 2) return total;
+
+    TraceSpan span("pool.enforce");
+
+    // Least recently used first; the front entry is the document in use. Dropping caches
+    // is cheap to undo, so every candidate gives those up before any is parked.
+    for (auto it = std::prev(m_entries.end()); it != m_entries.begin() && total > m_budget; --it)
+    {
+        if (!it->parkedPath.empty()) continue;
+
+        const size_t before = it->pdf->MemoryUsage().Total();
+        it->pdf->ReleaseCaches();
+        const size_t after = it->pdf->MemoryUsage().Total();
+        if (after < before)
+        {
+            total -= before - after;
+            ++m_stats.cachesReleased;
+        }
+    }
+
+    for (auto it = std::prev(m_entries.end()); it != m_entries.begin() && total > m_budget; --it)
+    {
+        if (!it->parkedPath.empty()) continue;
+
+        std::wstring path = it->pdf->ReopenPath();
+        if (path.empty()) continue; // unsaved stamps, or nothing to reopen from
+
+        total -= (std::min)(total, it->pdf->MemoryUsage().Total());
+        it->pdf->Close();
+        it->parkedPath = std::move(path);
+        ++m_stats.parked;
+    }
+    return total;
+}
+
+std::vector<PdfPooledDocument> PdfDocumentPool::Documents() const
+{
+    std::vector<PdfPooledDocument> documents{};
+    documents.reserve(m_entries.size());
+    for (Entry const& entry : m_entries)
+    {
+        PdfPooledDocument document{};
+        document.id = entry.id;
+        document.parked = !entry.parkedPath.empty();
+        document.reopenPath = document.parked ? entry.parkedPath : entry.pdf->ReopenPath();
+        document.memory = entry.pdf->MemoryUsage();
+        documents.push_back(std::move(document));
+    }
+    return documents;
+}
+
+size_t PdfDocumentPool::MemoryBytes() const noexcept
+{
+    size_t total = 0;
+    for (Entry const& entry : m_entries)
+    {
+        total += entry.pdf->MemoryUsage().Total();
+    }
+    return total;
+}
+
+std::list<PdfDocumentPool::Entry>::iterator PdfDocumentPool::Find(PdfDocumentId id) noexcept
+{
+    return std::find_if(m_entries.begin(), m_entries.end(), [id](Entry const& entry) { return entry.id == id; });
+}
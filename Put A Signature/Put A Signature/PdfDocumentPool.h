@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PdfDocumentHandler.h"
+
+using PdfDocumentId = uint64_t;
+
+// One document of a PdfDocumentPool, as Documents() reports it.
+struct PdfPooledDocument
+{
+    PdfDocumentId id{};
+    bool parked{ false };        // closed; Use reopens it from reopenPath
+    std::wstring reopenPath{};   // empty: the document cannot be parked
+    PdfMemoryUsage memory{};
+};
+
+struct PdfPoolStats
+{
+    uint64_t cachesReleased{};   // documents whose caches Enforce dropped
+    uint64_t parked{};
+    uint64_t reopened{};
+};
+
+// Several documents open at once (a packet to sign) under one memory budget covering
+// their file bytes, page handles, render caches and retained bitmaps.
+//
+// Documents are kept in least-recently-used order. When the pool is over budget,
+// Enforce first releases the caches of the least recently used documents, then parks
+// the ones that can be reopened as they are (PdfDocumentHandler::ReopenPath: nothing
+// stamped since they were loaded or saved): a parked document is closed and costs
+// nothing until Use reopens it from its file. Documents with pending or unsaved
+// stamps, and ones loaded from bytes, are never parked. The most recently used
+// document is never touched, so the pool can exceed its budget by that one.
+//
+// Handlers have stable addresses while they are in the pool. Not thread-safe; like the
+// handlers themselves, the pool is used from the PDF thread only.
+class PdfDocumentPool
+{
+public:
+    // Leaves room for the app and the OS on an 8 GB machine.
+    static constexpr size_t DefaultBudgetBytes = 1024u * 1024u * 1024u;
+
+    explicit PdfDocumentPool(size_t budgetBytes = DefaultBudgetBytes) noexcept;
+
+    PdfDocumentPool(PdfDocumentPool const&) = delete;
+    PdfDocumentPool& operator=(PdfDocumentPool const&) = delete;
+
+    // A new, empty document, now the most recently used; load it through Use(id).
+    PdfDocumentId Add();
+
+    // Closes the document and forgets it. Unsaved stamps are lost.
+    void Remove(PdfDocumentId id) noexcept;
+
+    bool Contains(PdfDocumentId id) const noexcept;
+    size_t Count() const noexcept { return m_entries.size(); }
+
+    // The document's handler, reopened first if it was parked, and now the most recently
+    // used. Throws std::out_of_range for an unknown id, or what LoadFromPath throws if
+    // the file cannot be reopened (the document then stays parked).
+    PdfDocumentHandler& Use(PdfDocumentId id);
+
+    // Brings the pool under budget as described above. Returns the bytes held afterwards.
+    size_t Enforce();
+
+    void SetBudget(size_t budgetBytes) noexcept { m_budget = budgetBytes; }
+    size_t Budget() const noexcept { return m_budget; }
+
+    // Per document, most recently used first.
+    std::vector<PdfPooledDocument> Documents() const;
+    size_t MemoryBytes() const noexcept;
+    PdfPoolStats Stats() const noexcept { return m_stats; }
+
+private:
+    struct Entry
+    {
+        PdfDocumentId id{};
+        std::unique_ptr<PdfDocumentHandler> pdf{};
+        std::wstring parkedPath{}; // non-empty while parked
+    };
+
+    std::list<Entry>::iterator Find(PdfDocumentId id) noexcept;
+
+    std::list<Entry> m_entries{}; // most recently used first
+    size_t m_budget{};
+    PdfDocumentId m_lastId{};
+    PdfPoolStats m_stats{};
+};
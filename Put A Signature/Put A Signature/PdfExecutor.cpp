@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "PdfExecutor.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+
+namespace
+{
+    double MillisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+PdfExecutor::PdfExecutor()
+{
+    m_thread = std::thread([this]() { ThreadMain(); });
+}
+
+PdfExecutor::~PdfExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void PdfExecutor::SetResumer(Resumer resumer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_resumer = std::move(resumer);
+}
+
+void PdfExecutor::Post(PdfTaskPriority priority, std::function<void()> work)
+{
+    Task task{};
+    task.droppable = true;
+    task.fn = [work = std::move(work)](bool abandoned)
+    {
+        if (abandoned) return;
+        try
+        {
+            work();
+        }
+        catch (...)
+        {
+            // Fire-and-forget: nobody is waiting for the error.
+        }
+    };
+    Enqueue(priority, std::move(task));
+}
+
+size_t PdfExecutor::DropPending(PdfTaskPriority priority)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& queue = m_queues[static_cast<size_t>(priority)];
+    const size_t before = queue.size();
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [](Task const& task) { return task.droppable; }), queue.end());
+
+    const size_t dropped = before - queue.size();
+    m_dropped += dropped;
+    return dropped;
+}
+
+PdfExecutorStats PdfExecutor::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    PdfExecutorStats stats{};
+    for (size_t i = 0; i < m_queues.size(); ++i)
+    {
+        stats.queueDepthByPriority[i] = m_queues[i].size();
+        stats.queueDepth += m_queues[i].size();
+    }
+    stats.maxQueueDepth = m_maxQueueDepth;
+    stats.completed = m_completed;
+    stats.dropped = m_dropped;
+    stats.maxWaitMs = m_maxWaitMs;
+    if (m_completed > 0)
+    {
+        stats.averageWaitMs = m_totalWaitMs / static_cast<double>(m_completed);
+        stats.averageRunMs = m_totalRunMs / static_cast<double>(m_completed);
+    }
+    return stats;
+}
+
+bool PdfExecutor::IsExecutorThread() const noexcept
+{
+    return std::this_thread::get_id() == m_thread.get_id();
+}
+
+void PdfExecutor::Enqueue(PdfTaskPriority priority, Task task)
+{
+    bool abandon = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            abandon = true;
+        }
+        else
+        {
+            task.enqueued = std::chrono::steady_clock::now();
+            m_queues[static_cast<size_t>(priority)].push_back(std::move(task));
+
+            size_t depth = 0;
+            for (auto const& queue : m_queues) depth += queue.size();
+            m_maxQueueDepth = (std::max)(m_maxQueueDepth, depth);
+        }
+    }
+
+    if (abandon)
+    {
+        task.fn(true);
+        return;
+    }
+    m_wake.notify_one();
+}
+
+void PdfExecutor::Resume(std::function<void()> resume)
+{
+    Resumer resumer{};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        resumer = m_resumer;
+    }
+
+    if (resumer)
+    {
+        resumer(std::move(resume));
+    }
+    else
+    {
+        resume();
+    }
+}
+
+void PdfExecutor::ThreadMain()
+{
+    SetTraceThreadName("PDF executor");
+
+    for (;;)
+    {
+        Task task{};
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]()
+            {
+                return m_stopping || std::any_of(m_queues.begin(), m_queues.end(), [](auto const& queue) { return !queue.empty(); });
+            });
+
+            if (m_stopping) break;
+
+            // Highest priority first, FIFO within a priority.
+            for (auto& queue : m_queues)
+            {
+                if (queue.empty()) continue;
+                task = std::move(queue.front());
+                queue.pop_front();
+                break;
+            }
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        task.fn(false);
+        const auto finished = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double waitMs = MillisecondsBetween(task.enqueued, started);
+        ++m_completed;
+        m_totalWaitMs += waitMs;
+        m_maxWaitMs = (std::max)(m_maxWaitMs, waitMs);
+        m_totalRunMs += MillisecondsBetween(started, finished);
+    }
+
+    // Shutting down: let anything still awaiting a result resume with an error.
+    std::array<std::deque<Task>, 3> leftover{};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        leftover.swap(m_queues);
+    }
+    for (auto& queue : leftover)
+    {
+        for (auto& task : queue)
+        {
+            task.fn(true);
+        }
+    }
+}
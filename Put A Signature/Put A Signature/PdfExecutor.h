@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Queues are served strictly in this order.
+enum class PdfTaskPriority
+{
+    Visible = 0,    // the page or operation the user is waiting on
+    Prefetch = 1,   // neighbour pages likely to be shown next
+    Background = 2, // everything else
+};
+
+struct PdfExecutorStats
+{
+    size_t queueDepth{};
+    size_t maxQueueDepth{};
+    std::array<size_t, 3> queueDepthByPriority{};
+    uint64_t completed{};
+    uint64_t dropped{};
+    double averageWaitMs{};
+    double maxWaitMs{};
+    double averageRunMs{};
+};
+
+namespace PdfExecutorDetail
+{
+    // Result (or exception) of a task, handed from the executor thread to the awaiting coroutine.
+    template <typename TResult>
+    struct Outcome
+    {
+        std::optional<TResult> value{};
+        std::exception_ptr error{};
+
+        template <typename TFunc>
+        void Capture(TFunc& func)
+        {
+            try
+            {
+                value.emplace(func());
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+
+        TResult Get()
+        {
+            if (error) std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct Outcome<void>
+    {
+        std::exception_ptr error{};
+
+        template <typename TFunc>
+        void Capture(TFunc& func)
+        {
+            try
+            {
+                func();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+
+        void Get()
+        {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+}
+
+// Owns the single thread that is allowed to call into PDFium.
+// PDFium is not thread-safe, so every PdfDocumentHandler call is marshalled here.
+//
+// Usage from a coroutine:
+//     int32_t pages = co_await executor.Run(PdfTaskPriority::Visible, [&] { return pdf.PageCount(); });
+// The awaiting coroutine resumes through the resumer (e.g. the UI DispatcherQueue),
+// and exceptions thrown by the work are rethrown at the co_await.
+class PdfExecutor
+{
+public:
+    using Resumer = std::function<void(std::function<void()>)>;
+
+    PdfExecutor();
+    ~PdfExecutor();
+
+    PdfExecutor(PdfExecutor const&) = delete;
+    PdfExecutor& operator=(PdfExecutor const&) = delete;
+
+    // Where awaiting coroutines continue. Without a resumer they continue on the executor thread.
+    void SetResumer(Resumer resumer);
+
+    // Fire-and-forget work. Exceptions are swallowed; queued work can be dropped with DropPending.
+    void Post(PdfTaskPriority priority, std::function<void()> work);
+
+    // Awaitable that runs func on the executor thread and yields its result.
+    template <typename TFunc>
+    auto Run(PdfTaskPriority priority, TFunc func);
+
+    // Drop fire-and-forget work at this priority that has not started yet (e.g. stale prefetches).
+    size_t DropPending(PdfTaskPriority priority);
+
+    PdfExecutorStats Stats() const;
+
+    bool IsExecutorThread() const noexcept;
+
+private:
+    struct Task
+    {
+        // Called with abandoned = true instead of running when the executor shuts down first.
+        std::function<void(bool abandoned)> fn;
+        bool droppable{};
+        std::chrono::steady_clock::time_point enqueued{};
+    };
+
+    template <typename TFunc>
+    class RunAwaiter
+    {
+    public:
+        using Result = std::invoke_result_t<TFunc&>;
+
+        RunAwaiter(PdfExecutor& executor, PdfTaskPriority priority, TFunc func)
+            : m_executor(executor), m_priority(priority), m_func(std::move(func))
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        template <typename THandle>
+        void await_suspend(THandle handle)
+        {
+            Task task{};
+            task.fn = [this, handle](bool abandoned)
+            {
+                if (abandoned)
+                {
+                    m_outcome.error = std::make_exception_ptr(std::runtime_error("PDF executor shut down"));
+                }
+                else
+                {
+                    m_outcome.Capture(m_func);
+                }
+                m_executor.Resume([handle]() { handle(); });
+            };
+            m_executor.Enqueue(m_priority, std::move(task));
+        }
+
+        Result await_resume() { return m_outcome.Get(); }
+
+    private:
+        PdfExecutor& m_executor;
+        PdfTaskPriority m_priority;
+        TFunc m_func;
+        PdfExecutorDetail::Outcome<Result> m_outcome{};
+    };
+
+    void Enqueue(PdfTaskPriority priority, Task task);
+    void Resume(std::function<void()> resume);
+    void ThreadMain();
+
+    mutable std::mutex m_mutex{};
+    std::condition_variable m_wake{};
+    std::array<std::deque<Task>, 3> m_queues{};
+    bool m_stopping{ false };
+    Resumer m_resumer{};
+
+    size_t m_maxQueueDepth{};
+    uint64_t m_completed{};
+    uint64_t m_dropped{};
+    double m_totalWaitMs{};
+    double m_maxWaitMs{};
+    double m_totalRunMs{};
+
+    std::thread m_thread{};
+};
+
+template <typename TFunc>
+auto PdfExecutor::Run(PdfTaskPriority priority, TFunc func)
+{
+    return RunAwaiter<TFunc>(*this, priority, std::move(func));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+// Non-owning view of BGRA8 pixels (4 bytes per pixel, rows `stride` bytes apart).
+// Platform-neutral so the same memory can be handed to PDFium, WinRT or a file writer.
+template <typename TByte>
+struct BasicPixelView
+{
+    TByte* data{};
+    int32_t width{};
+    int32_t height{};
+    int32_t stride{};
+
+    bool Empty() const noexcept { return !data || width <= 0 || height <= 0; }
+    size_t SizeBytes() const noexcept { return static_cast<size_t>(stride) * static_cast<size_t>(height); }
+    TByte* Row(int32_t y) const noexcept { return data + static_cast<ptrdiff_t>(y) * stride; }
+
+    // The w x h rectangle at (x, y); the caller keeps it inside the view.
+    BasicPixelView SubView(int32_t x, int32_t y, int32_t w, int32_t h) const noexcept
+    {
+        return { Row(y) + static_cast<ptrdiff_t>(x) * 4, w, h, stride };
+    }
+
+    // Mutable views convert to read-only ones.
+    template <typename T = TByte, typename = std::enable_if_t<!std::is_const_v<T>>>
+    operator BasicPixelView<T const>() const noexcept { return { data, width, height, stride }; }
+};
+
+using PixelView = BasicPixelView<uint8_t>;
+using ConstPixelView = BasicPixelView<uint8_t const>;
+
+// Owning BGRA8 pixel storage with tightly packed rows (stride = width * 4).
+// Memory is left uninitialized; renderers fill it. Move-only: pixel data is
+// shared through std::shared_ptr<PixelBuffer const> rather than copied.
+class PixelBuffer
+{
+public:
+    static constexpr int32_t BytesPerPixel = 4;
+
+    PixelBuffer() = default;
+
+    PixelBuffer(int32_t width, int32_t height)
+        : m_width(width), m_height(height), m_stride(width * BytesPerPixel)
+    {
+        if (width <= 0 || height <= 0) throw std::invalid_argument("PixelBuffer size must be positive");
+        m_data.reset(new uint8_t[static_cast<size_t>(m_stride) * static_cast<size_t>(m_height)]);
+    }
+
+    PixelBuffer(PixelBuffer&&) noexcept = default;
+    PixelBuffer& operator=(PixelBuffer&&) noexcept = default;
+    PixelBuffer(PixelBuffer const&) = delete;
+    PixelBuffer& operator=(PixelBuffer const&) = delete;
+
+    int32_t Width() const noexcept { return m_width; }
+    int32_t Height() const noexcept { return m_height; }
+    int32_t Stride() const noexcept { return m_stride; }
+    size_t SizeBytes() const noexcept { return static_cast<size_t>(m_stride) * static_cast<size_t>(m_height); }
+    bool Empty() const noexcept { return !m_data; }
+
+    uint8_t* Data() noexcept { return m_data.get(); }
+    uint8_t const* Data() const noexcept { return m_data.get(); }
+
+    PixelView View() noexcept { return { m_data.get(), m_width, m_height, m_stride }; }
+    ConstPixelView View() const noexcept { return { m_data.get(), m_width, m_height, m_stride }; }
+
+private:
+    std::unique_ptr<uint8_t[]> m_data{};
+    int32_t m_width{};
+    int32_t m_height{};
+    int32_t m_stride{};
+};
+
+// Copy the overlapping area of src into dst, row by row (strides may differ).
+inline void CopyPixels(PixelView dst, ConstPixelView src) noexcept
+{
+    const int32_t width = dst.width < src.width ? dst.width : src.width;
+    const int32_t height = dst.height < src.height ? dst.height : src.height;
+    if (width <= 0 || height <= 0) return;
+
+    const size_t rowBytes = static_cast<size_t>(width) * PixelBuffer::BytesPerPixel;
+    if (dst.stride == src.stride && static_cast<size_t>(dst.stride) == rowBytes)
+    {
+        std::memcpy(dst.data, src.data, rowBytes * static_cast<size_t>(height));
+        return;
+    }
+
+    for (int32_t y = 0; y < height; ++y)
+    {
+        std::memcpy(dst.Row(y), src.Row(y), rowBytes);
+    }
+}
@@ -0,0 +1,565 @@
+#include "pch.h"
+#include "PixelKernels.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  #define PIXEL_KERNELS_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #endif
+#else
+  #define PIXEL_KERNELS_X86 0
+#endif
+
+// MSVC compiles any intrinsic anywhere; GCC/Clang need the ISA enabled per function.
+#if defined(_MSC_VER) && !defined(__clang__)
+  #define PIXEL_KERNELS_TARGET(isa)
+#else
+  #define PIXEL_KERNELS_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace
+{
+    // One row of each kernel; the public functions walk the rows.
+    struct KernelTable
+    {
+        void (*fill)(uint8_t* dst, int32_t width, uint32_t bgra) noexcept;
+        void (*premultiply)(uint8_t* dst, uint8_t const* src, int32_t width) noexcept;
+        void (*unpremultiply)(uint8_t* dst, uint8_t const* src, int32_t width) noexcept;
+        void (*over)(uint8_t* dst, uint8_t const* src, int32_t width) noexcept;
+        void (*gray)(uint8_t* dst, uint8_t const* src, int32_t width) noexcept;
+        int32_t (*findForward)(uint8_t const* row, int32_t from, int32_t to) noexcept;
+        int32_t (*findBackward)(uint8_t const* row, int32_t from, int32_t to) noexcept;
+    };
+
+    constexpr int32_t GrayWeightB = 29;
+    constexpr int32_t GrayWeightG = 150;
+    constexpr int32_t GrayWeightR = 77;
+
+    // ---- Scalar: the reference every SIMD level must match bit for bit ----
+
+    // x / 255 rounded to nearest, exact for x <= 255 * 255.
+    inline uint32_t Div255(uint32_t x) noexcept
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // 255 / a in 16.16 fixed point, so unpremultiplying is a multiply and a shift in
+    // every implementation (SIMD has no integer divide). Within 0.002 of c * 255 / a.
+    struct ReciprocalTable
+    {
+        uint32_t values[256]{};
+
+        constexpr ReciprocalTable()
+        {
+            for (uint32_t a = 1; a < 256; ++a)
+            {
+                values[a] = (255u * 65536u + a / 2) / a;
+            }
+        }
+    };
+    constexpr ReciprocalTable Reciprocals{};
+
+    inline uint8_t UnpremultiplyChannel(uint32_t c, uint32_t reciprocal) noexcept
+    {
+        const uint32_t value = (c * reciprocal + 32768u) >> 16;
+        return static_cast<uint8_t>(value > 255 ? 255 : value);
+    }
+
+    void FillScalar(uint8_t* dst, int32_t width, uint32_t bgra) noexcept
+    {
+        for (int32_t x = 0; x < width; ++x)
+        {
+            std::memcpy(dst + x * 4, &bgra, 4);
+        }
+    }
+
+    void PremultiplyScalar(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        for (int32_t x = 0; x < width; ++x, dst += 4, src += 4)
+        {
+            const uint8_t a = src[3];
+            dst[0] = static_cast<uint8_t>(Div255(src[0] * a));
+            dst[1] = static_cast<uint8_t>(Div255(src[1] * a));
+            dst[2] = static_cast<uint8_t>(Div255(src[2] * a));
+            dst[3] = a;
+        }
+    }
+
+    void UnpremultiplyScalar(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        for (int32_t x = 0; x < width; ++x, dst += 4, src += 4)
+        {
+            const uint8_t a = src[3];
+            const uint32_t reciprocal = Reciprocals.values[a]; // 0 for a == 0, clearing the pixel
+            dst[0] = UnpremultiplyChannel(src[0], reciprocal);
+            dst[1] = UnpremultiplyChannel(src[1], reciprocal);
+            dst[2] = UnpremultiplyChannel(src[2], reciprocal);
+            dst[3] = a;
+        }
+    }
+
+    void OverScalar(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        for (int32_t x = 0; x < width; ++x, dst += 4, src += 4)
+        {
+            const uint32_t inverse = 255u - src[3];
+            for (int c = 0; c < 4; ++c)
+            {
+                const uint32_t value = src[c] + Div255(dst[c] * inverse);
+                dst[c] = static_cast<uint8_t>(value > 255 ? 255 : value);
+            }
+        }
+    }
+
+    void GrayScalar(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        for (int32_t x = 0; x < width; ++x, src += 4)
+        {
+            dst[x] = static_cast<uint8_t>((src[0] * GrayWeightB + src[1] * GrayWeightG + src[2] * GrayWeightR + 128) >> 8);
+        }
+    }
+
+    int32_t FindForwardScalar(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        for (int32_t x = from; x < to; ++x)
+        {
+            if (row[x * 4 + 3]) return x;
+        }
+        return to;
+    }
+
+    int32_t FindBackwardScalar(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        for (int32_t x = to - 1; x >= from; --x)
+        {
+            if (row[x * 4 + 3]) return x;
+        }
+        return from - 1;
+    }
+
+    constexpr KernelTable ScalarKernels{
+        &FillScalar, &PremultiplyScalar, &UnpremultiplyScalar, &OverScalar, &GrayScalar, &FindForwardScalar, &FindBackwardScalar };
+
+#if PIXEL_KERNELS_X86
+    // ---- SSE4.1: four pixels per step ----
+
+    PIXEL_KERNELS_TARGET("sse4.1") inline __m128i Div255Epi16(__m128i x) noexcept
+    {
+        x = _mm_add_epi16(x, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    // Each pixel's alpha in all four of its 16-bit channel slots.
+    PIXEL_KERNELS_TARGET("sse4.1") inline __m128i BroadcastAlphaEpi16(__m128i x) noexcept
+    {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") void FillSse41(uint8_t* dst, int32_t width, uint32_t bgra) noexcept
+    {
+        const __m128i value = _mm_set1_epi32(static_cast<int>(bgra));
+        int32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), value);
+        }
+        FillScalar(dst + x * 4, width - x, bgra);
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") void PremultiplySse41(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + x * 4));
+            __m128i lo = _mm_unpacklo_epi8(px, zero);
+            __m128i hi = _mm_unpackhi_epi8(px, zero);
+            lo = Div255Epi16(_mm_mullo_epi16(lo, BroadcastAlphaEpi16(lo)));
+            hi = Div255Epi16(_mm_mullo_epi16(hi, BroadcastAlphaEpi16(hi)));
+            const __m128i result = _mm_blendv_epi8(_mm_packus_epi16(lo, hi), px, alphaBytes);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), result);
+        }
+        PremultiplyScalar(dst + x * 4, src + x * 4, width - x);
+    }
+
+    // One pixel as four int32 lanes -> unpremultiplied int32 lanes (alpha lane kept).
+    PIXEL_KERNELS_TARGET("sse4.1") inline __m128i UnpremultiplyPixelSse41(__m128i channels, uint32_t reciprocal) noexcept
+    {
+        // Wrapping 32-bit multiply: the product fits in uint32 and the shift is logical.
+        __m128i value = _mm_mullo_epi32(channels, _mm_set1_epi32(static_cast<int>(reciprocal)));
+        value = _mm_srli_epi32(_mm_add_epi32(value, _mm_set1_epi32(32768)), 16);
+        value = _mm_min_epu32(value, _mm_set1_epi32(255));
+        return _mm_blend_epi16(value, channels, 0xC0); // keep alpha itself
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") void UnpremultiplySse41(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        int32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            uint8_t const* p = src + x * 4;
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+            const __m128i p0 = UnpremultiplyPixelSse41(_mm_cvtepu8_epi32(px), Reciprocals.values[p[3]]);
+            const __m128i p1 = UnpremultiplyPixelSse41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 4)), Reciprocals.values[p[7]]);
+            const __m128i p2 = UnpremultiplyPixelSse41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 8)), Reciprocals.values[p[11]]);
+            const __m128i p3 = UnpremultiplyPixelSse41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 12)), Reciprocals.values[p[15]]);
+            const __m128i result = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), result);
+        }
+        UnpremultiplyScalar(dst + x * 4, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") void OverSse41(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        int32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + x * 4));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(dst + x * 4));
+            const __m128i inverseLo = _mm_sub_epi16(full, BroadcastAlphaEpi16(_mm_unpacklo_epi8(s, zero)));
+            const __m128i inverseHi = _mm_sub_epi16(full, BroadcastAlphaEpi16(_mm_unpackhi_epi8(s, zero)));
+            const __m128i lo = Div255Epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inverseLo));
+            const __m128i hi = Div255Epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inverseHi));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+        }
+        OverScalar(dst + x * 4, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") void GraySse41(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(GrayWeightB, GrayWeightG, GrayWeightR, 0, GrayWeightB, GrayWeightG, GrayWeightR, 0);
+        const __m128i round = _mm_set1_epi32(128);
+        int32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + x * 4));
+            const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights);
+            const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights);
+            const __m128i sums = _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), round), 8);
+            const __m128i bytes = _mm_packus_epi16(_mm_packus_epi32(sums, sums), zero);
+            const int32_t packed = _mm_cvtsi128_si32(bytes);
+            std::memcpy(dst + x, &packed, 4);
+        }
+        GrayScalar(dst + x, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") int32_t FindForwardSse41(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = from;
+        while (x + 4 <= to && _mm_testz_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(row + x * 4)), alphaBytes)) x += 4;
+        return FindForwardScalar(row, x, to);
+    }
+
+    PIXEL_KERNELS_TARGET("sse4.1") int32_t FindBackwardSse41(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = to;
+        while (x - 4 >= from && _mm_testz_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(row + (x - 4) * 4)), alphaBytes)) x -= 4;
+        return FindBackwardScalar(row, from, x);
+    }
+
+    constexpr KernelTable Sse41Kernels{
+        &FillSse41, &PremultiplySse41, &UnpremultiplySse41, &OverSse41, &GraySse41, &FindForwardSse41, &FindBackwardSse41 };
+
+    // ---- AVX2: eight pixels per step (unpack/pack work per 128-bit lane, which keeps pixel order) ----
+
+    PIXEL_KERNELS_TARGET("avx2") inline __m256i Div255Epi16Avx2(__m256i x) noexcept
+    {
+        x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") inline __m256i BroadcastAlphaEpi16Avx2(__m256i x) noexcept
+    {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") void FillAvx2(uint8_t* dst, int32_t width, uint32_t bgra) noexcept
+    {
+        const __m256i value = _mm256_set1_epi32(static_cast<int>(bgra));
+        int32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), value);
+        }
+        FillScalar(dst + x * 4, width - x, bgra);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") void PremultiplyAvx2(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alphaBytes = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + x * 4));
+            __m256i lo = _mm256_unpacklo_epi8(px, zero);
+            __m256i hi = _mm256_unpackhi_epi8(px, zero);
+            lo = Div255Epi16Avx2(_mm256_mullo_epi16(lo, BroadcastAlphaEpi16Avx2(lo)));
+            hi = Div255Epi16Avx2(_mm256_mullo_epi16(hi, BroadcastAlphaEpi16Avx2(hi)));
+            const __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), px, alphaBytes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), result);
+        }
+        PremultiplySse41(dst + x * 4, src + x * 4, width - x);
+    }
+
+    // Two pixels as eight int32 lanes (one pixel per 128-bit lane).
+    PIXEL_KERNELS_TARGET("avx2") inline __m256i UnpremultiplyPixelsAvx2(__m256i channels, uint8_t const* pixels) noexcept
+    {
+        const int r0 = static_cast<int>(Reciprocals.values[pixels[3]]);
+        const int r1 = static_cast<int>(Reciprocals.values[pixels[7]]);
+        __m256i value = _mm256_mullo_epi32(channels, _mm256_setr_epi32(r0, r0, r0, r0, r1, r1, r1, r1));
+        value = _mm256_srli_epi32(_mm256_add_epi32(value, _mm256_set1_epi32(32768)), 16);
+        value = _mm256_min_epu32(value, _mm256_set1_epi32(255));
+        return _mm256_blend_epi32(value, channels, 0x88); // keep alpha itself
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") void UnpremultiplyAvx2(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        int32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            uint8_t const* p = src + x * 4;
+            const __m128i half0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+            const __m128i half1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16));
+
+            // Pixels (0,1), (2,3), ... widened to int32, one pixel per 128-bit lane.
+            const __m256i p01 = UnpremultiplyPixelsAvx2(_mm256_cvtepu8_epi32(half0), p);
+            const __m256i p23 = UnpremultiplyPixelsAvx2(_mm256_cvtepu8_epi32(_mm_srli_si128(half0, 8)), p + 8);
+            const __m256i p45 = UnpremultiplyPixelsAvx2(_mm256_cvtepu8_epi32(half1), p + 16);
+            const __m256i p67 = UnpremultiplyPixelsAvx2(_mm256_cvtepu8_epi32(_mm_srli_si128(half1, 8)), p + 24);
+
+            // The packs work per lane, so lane 0 ends up with pixels 0,2,4,6 and lane 1
+            // with 1,3,5,7; interleave them back into order.
+            const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(p01, p23), _mm256_packus_epi32(p45, p67));
+            const __m128i even = _mm256_castsi256_si128(bytes);
+            const __m128i odd = _mm256_extracti128_si256(bytes, 1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_unpacklo_epi32(even, odd));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 16), _mm_unpackhi_epi32(even, odd));
+        }
+        UnpremultiplySse41(dst + x * 4, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") void OverAvx2(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i full = _mm256_set1_epi16(255);
+        int32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + x * 4));
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(dst + x * 4));
+            const __m256i inverseLo = _mm256_sub_epi16(full, BroadcastAlphaEpi16Avx2(_mm256_unpacklo_epi8(s, zero)));
+            const __m256i inverseHi = _mm256_sub_epi16(full, BroadcastAlphaEpi16Avx2(_mm256_unpackhi_epi8(s, zero)));
+            const __m256i lo = Div255Epi16Avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inverseLo));
+            const __m256i hi = Div255Epi16Avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inverseHi));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi)));
+        }
+        OverSse41(dst + x * 4, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") void GrayAvx2(uint8_t* dst, uint8_t const* src, int32_t width) noexcept
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i weights = _mm256_setr_epi16(
+            GrayWeightB, GrayWeightG, GrayWeightR, 0, GrayWeightB, GrayWeightG, GrayWeightR, 0,
+            GrayWeightB, GrayWeightG, GrayWeightR, 0, GrayWeightB, GrayWeightG, GrayWeightR, 0);
+        const __m256i round = _mm256_set1_epi32(128);
+        int32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + x * 4));
+            const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), weights);
+            const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), weights);
+
+            // Per lane: pixels 0-3 in lane 0, 4-7 in lane 1.
+            const __m256i sums = _mm256_srli_epi32(_mm256_add_epi32(_mm256_hadd_epi32(lo, hi), round), 8);
+            const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(sums, sums), zero);
+            const int32_t first = _mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+            const int32_t second = _mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+            std::memcpy(dst + x, &first, 4);
+            std::memcpy(dst + x + 4, &second, 4);
+        }
+        GraySse41(dst + x, src + x * 4, width - x);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") int32_t FindForwardAvx2(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        const __m256i alphaBytes = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = from;
+        while (x + 8 <= to && _mm256_testz_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + x * 4)), alphaBytes)) x += 8;
+        return FindForwardSse41(row, x, to);
+    }
+
+    PIXEL_KERNELS_TARGET("avx2") int32_t FindBackwardAvx2(uint8_t const* row, int32_t from, int32_t to) noexcept
+    {
+        const __m256i alphaBytes = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+        int32_t x = to;
+        while (x - 8 >= from && _mm256_testz_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + (x - 8) * 4)), alphaBytes)) x -= 8;
+        return FindBackwardSse41(row, from, x);
+    }
+
+    constexpr KernelTable Avx2Kernels{
+        &FillAvx2, &PremultiplyAvx2, &UnpremultiplyAvx2, &OverAvx2, &GrayAvx2, &FindForwardAvx2, &FindBackwardAvx2 };
+
+    PixelKernelLevel DetectLevel() noexcept
+    {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4]{};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) // OS saves XMM and YMM state
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        const bool sse41 = __builtin_cpu_supports("sse4.1");
+        const bool avx2 = __builtin_cpu_supports("avx2");
+    #endif
+        if (avx2 && sse41) return PixelKernelLevel::Avx2;
+        if (sse41) return PixelKernelLevel::Sse41;
+        return PixelKernelLevel::Scalar;
+    }
+#else
+    PixelKernelLevel DetectLevel() noexcept
+    {
+        return PixelKernelLevel::Scalar;
+    }
+#endif
+
+    KernelTable const& TableFor(PixelKernelLevel level) noexcept
+    {
+        switch (level)
+        {
+#if PIXEL_KERNELS_X86
+        case PixelKernelLevel::Avx2: return Avx2Kernels;
+        case PixelKernelLevel::Sse41: return Sse41Kernels;
+#endif
+        default: return ScalarKernels;
+        }
+    }
+
+    PixelKernelLevel const g_detectedLevel = DetectLevel();
+    std::atomic<PixelKernelLevel> g_activeLevel{ g_detectedLevel };
+
+    KernelTable const& Active() noexcept
+    {
+        return TableFor(g_activeLevel.load(std::memory_order_relaxed));
+    }
+
+    int32_t OverlapWidth(PixelView dst, ConstPixelView src) noexcept { return dst.width < src.width ? dst.width : src.width; }
+    int32_t OverlapHeight(PixelView dst, ConstPixelView src) noexcept { return dst.height < src.height ? dst.height : src.height; }
+
+    template <typename TRowKernel>
+    void ForEachRow(PixelView dst, ConstPixelView src, TRowKernel kernel) noexcept
+    {
+        if (dst.Empty() || src.Empty()) return;
+        const int32_t width = OverlapWidth(dst, src);
+        const int32_t height = OverlapHeight(dst, src);
+        for (int32_t y = 0; y < height; ++y)
+        {
+            kernel(dst.Row(y), src.Row(y), width);
+        }
+    }
+}
+
+PixelKernelLevel DetectedPixelKernelLevel() noexcept
+{
+    return g_detectedLevel;
+}
+
+PixelKernelLevel ActivePixelKernelLevel() noexcept
+{
+    return g_activeLevel.load(std::memory_order_relaxed);
+}
+
+void SetPixelKernelLevel(PixelKernelLevel level) noexcept
+{
+    g_activeLevel.store(level < g_detectedLevel ? level : g_detectedLevel, std::memory_order_relaxed);
+}
+
+char const* PixelKernelLevelName(PixelKernelLevel level) noexcept
+{
+    switch (level)
+    {
+    case PixelKernelLevel::Avx2: return "avx2";
+    case PixelKernelLevel::Sse41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+void FillPixels(PixelView dst, uint32_t bgra) noexcept
+{
+    if (dst.Empty()) return;
+    auto fill = Active().fill;
+
+    // Tightly packed rows are one run.
+    if (static_cast<size_t>(dst.stride) == static_cast<size_t>(dst.width) * PixelBuffer::BytesPerPixel)
+    {
+        const int64_t total = static_cast<int64_t>(dst.width) * dst.height;
+        if (total <= INT32_MAX)
+        {
+            fill(dst.data, static_cast<int32_t>(total), bgra);
+            return;
+        }
+    }
+    for (int32_t y = 0; y < dst.height; ++y)
+    {
+        fill(dst.Row(y), dst.width, bgra);
+    }
+}
+
+void PremultiplyAlpha(PixelView dst, ConstPixelView src) noexcept
+{
+    ForEachRow(dst, src, Active().premultiply);
+}
+
+void UnpremultiplyAlpha(PixelView dst, ConstPixelView src) noexcept
+{
+    ForEachRow(dst, src, Active().unpremultiply);
+}
+
+void CompositeOver(PixelView dst, ConstPixelView src) noexcept
+{
+    ForEachRow(dst, src, Active().over);
+}
+
+void BgraToGray(uint8_t* dst, int32_t dstStride, ConstPixelView src) noexcept
+{
+    if (!dst || src.Empty()) return;
+    auto gray = Active().gray;
+    for (int32_t y = 0; y < src.height; ++y)
+    {
+        gray(dst + static_cast<ptrdiff_t>(y) * dstStride, src.Row(y), src.width);
+    }
+}
+
+int32_t FindAlphaForward(uint8_t const* row, int32_t from, int32_t to) noexcept
+{
+    return from < to ? Active().findForward(row, from, to) : to;
+}
+
+int32_t FindAlphaBackward(uint8_t const* row, int32_t from, int32_t to) noexcept
+{
+    return from < to ? Active().findBackward(row, from, to) : from - 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "PixelBuffer.h"
+
+// Instruction sets the pixel kernels can use, lowest first.
+enum class PixelKernelLevel
+{
+    Scalar = 0,
+    Sse41 = 1,
+    Avx2 = 2,
+};
+
+// Best level this CPU supports (detected once; Scalar on non-x86 targets).
+PixelKernelLevel DetectedPixelKernelLevel() noexcept;
+
+// Level the kernels dispatch to; starts at DetectedPixelKernelLevel().
+PixelKernelLevel ActivePixelKernelLevel() noexcept;
+
+// Caps the level, e.g. to compare SIMD output with Scalar or to measure the speedup.
+// Clamped to DetectedPixelKernelLevel().
+void SetPixelKernelLevel(PixelKernelLevel level) noexcept;
+
+char const* PixelKernelLevelName(PixelKernelLevel level) noexcept;
+
+// BGRA8 kernels, SIMD where the CPU allows. Every level produces bit-identical
+// output. Two-view kernels process the overlapping area, and src may be the same
+// memory as dst. Premultiplying rounds x * a / 255 to nearest; unpremultiplying is
+// within 0.002 of x * 255 / a before rounding.
+//
+// Plain row copies (stride repacking) stay with CopyPixels in PixelBuffer.h: memcpy
+// is already vectorised by the C runtime.
+
+// Set every pixel to `bgra` (0xAARRGGBB read as a little-endian uint32).
+void FillPixels(PixelView dst, uint32_t bgra) noexcept;
+
+// Straight -> premultiplied alpha.
+void PremultiplyAlpha(PixelView dst, ConstPixelView src) noexcept;
+
+// Premultiplied -> straight alpha; fully transparent pixels become 0.
+void UnpremultiplyAlpha(PixelView dst, ConstPixelView src) noexcept;
+
+// dst = src over dst, both premultiplied.
+void CompositeOver(PixelView dst, ConstPixelView src) noexcept;
+
+// 8-bit luma (BT.601 weights 77/150/29 of 256) into rows `dstStride` bytes apart; alpha ignored.
+void BgraToGray(uint8_t* dst, int32_t dstStride, ConstPixelView src) noexcept;
+
+// First x in [from, to) of a BGRA row with non-zero alpha, or `to` if there is none.
+int32_t FindAlphaForward(uint8_t const* row, int32_t from, int32_t to) noexcept;
+
+// Last x in [from, to) of a BGRA row with non-zero alpha, or from - 1 if there is none.
+int32_t FindAlphaBackward(uint8_t const* row, int32_t from, int32_t to) noexcept;
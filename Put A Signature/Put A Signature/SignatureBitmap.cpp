@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "SignatureBitmap.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Ink colour spread (per channel, straight alpha) still treated as one colour, and
+    // the alpha below which a pixel's colour is too quantised to judge that by.
+    constexpr int32_t SingleColorTolerance = 40;
+    constexpr uint8_t ColorSampleMinAlpha = 96;
+
+    uint8_t Unpremultiply(uint8_t channel, uint8_t alpha) noexcept
+    {
+        if (alpha == 0) return 0;
+        const int32_t value = (channel * 255 + alpha / 2) / alpha;
+        return static_cast<uint8_t>(value > 255 ? 255 : value);
+    }
+
+    // Colour range and alpha-weighted mean colour (straight alpha) of the pixels added.
+    struct InkColorSample
+    {
+        int32_t lo[3]{ 255, 255, 255 };
+        int32_t hi[3]{ 0, 0, 0 };
+        uint64_t sum[3]{};
+        uint64_t weight{};
+
+        void Add(uint8_t const* pixel, bool premultiplied) noexcept
+        {
+            const uint8_t a = pixel[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                const int32_t value = premultiplied ? Unpremultiply(pixel[c], a) : pixel[c];
+                lo[c] = (std::min)(lo[c], value);
+                hi[c] = (std::max)(hi[c], value);
+                sum[c] += static_cast<uint64_t>(value) * a;
+            }
+            weight += a;
+        }
+
+        bool SingleColor() const noexcept
+        {
+            return weight > 0
+                && hi[0] - lo[0] <= SingleColorTolerance && hi[1] - lo[1] <= SingleColorTolerance && hi[2] - lo[2] <= SingleColorTolerance;
+        }
+    };
+}
+
+PixelRect FindInkBounds(ConstPixelView pixels) noexcept
+{
+    if (pixels.Empty()) return {};
+
+    int32_t top = 0;
+    int32_t left = pixels.width;
+    while (top < pixels.height && (left = FindAlphaForward(pixels.Row(top), 0, pixels.width)) == pixels.width) ++top;
+    if (top == pixels.height) return {};
+
+    int32_t bottom = pixels.height - 1;
+    while (bottom > top && FindAlphaForward(pixels.Row(bottom), 0, pixels.width) == pixels.width) --bottom;
+
+    int32_t right = FindAlphaBackward(pixels.Row(top), left, pixels.width);
+    for (int32_t y = top + 1; y <= bottom; ++y)
+    {
+        uint8_t const* row = pixels.Row(y);
+        left = FindAlphaForward(row, 0, left);
+        right = (std::max)(right, FindAlphaBackward(row, right + 1, pixels.width));
+    }
+    return { left, top, right - left + 1, bottom - top + 1 };
+}
+
+CompactSignatureBitmap CompactSignature(ConstPixelView pixels, bool premultiplied)
+{
+    const PixelRect crop = FindInkBounds(pixels);
+    if (crop.Empty()) throw std::runtime_error("Signature bitmap has no ink");
+
+    // One pass over the crop: colour of the well-covered pixels, and whether the ink
+    // is opaque gray.
+    InkColorSample sample{};
+    bool opaque = true;
+    bool gray = true;
+    for (int32_t y = 0; y < crop.height; ++y)
+    {
+        uint8_t const* src = pixels.Row(crop.y + y) + crop.x * 4;
+        for (int32_t x = 0; x < crop.width; ++x, src += 4)
+        {
+            const uint8_t a = src[3];
+            opaque = opaque && a == 255;
+            gray = gray && src[0] == src[1] && src[1] == src[2];
+            if (a >= ColorSampleMinAlpha) sample.Add(src, premultiplied);
+        }
+    }
+
+    const ConstPixelView cropped{ pixels.Row(crop.y) + crop.x * 4, crop.width, crop.height, pixels.stride };
+    if (sample.weight == 0)
+    {
+        // Only faint ink (a light or semi-transparent pen): judge the colour by all of it.
+        for (int32_t y = 0; y < crop.height; ++y)
+        {
+            uint8_t const* src = cropped.Row(y);
+            for (int32_t x = 0; x < crop.width; ++x, src += 4)
+            {
+                if (src[3] != 0) sample.Add(src, premultiplied);
+            }
+        }
+    }
+
+    CompactSignatureBitmap out{};
+    out.crop = crop;
+    out.width = crop.width;
+    out.height = crop.height;
+
+    if (opaque && gray)
+    {
+        // R == G == B, so the luma weights (summing to 256) reproduce the value exactly.
+        out.format = CompactSignatureBitmap::Format::Gray8;
+        out.stride = crop.width;
+        out.data.resize(static_cast<size_t>(out.stride) * out.height);
+        BgraToGray(out.data.data(), out.stride, cropped);
+        return out;
+    }
+
+    out.format = CompactSignatureBitmap::Format::Bgra8;
+    out.stride = crop.width * 4;
+    out.data.resize(static_cast<size_t>(out.stride) * out.height);
+    const PixelView outView{ out.data.data(), out.width, out.height, out.stride };
+
+    out.singleColor = sample.SingleColor();
+
+    if (!out.singleColor)
+    {
+        if (premultiplied)
+        {
+            UnpremultiplyAlpha(outView, cropped);
+        }
+        else
+        {
+            CopyPixels(outView, cropped);
+        }
+        return out;
+    }
+
+    uint8_t ink[3]{};
+    for (int c = 0; c < 3; ++c)
+    {
+        ink[c] = static_cast<uint8_t>((sample.sum[c] + sample.weight / 2) / sample.weight);
+    }
+
+    for (int32_t y = 0; y < crop.height; ++y)
+    {
+        uint8_t const* src = cropped.Row(y);
+        uint8_t* dst = outView.Row(y);
+        for (int32_t x = 0; x < crop.width; ++x, src += 4, dst += 4)
+        {
+            dst[0] = ink[0];
+            dst[1] = ink[1];
+            dst[2] = ink[2];
+            dst[3] = src[3];
+        }
+    }
+    return out;
+}
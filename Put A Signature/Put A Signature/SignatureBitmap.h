@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "PixelBuffer.h"
+
+struct PixelRect
+{
+    int32_t x{};
+    int32_t y{};
+    int32_t width{};
+    int32_t height{};
+
+    bool Empty() const noexcept { return width <= 0 || height <= 0; }
+};
+
+// Smallest rectangle holding every pixel with non-zero alpha; empty if there is none.
+// Uses the SIMD row scans from PixelKernels.h and, between the first and last ink
+// rows, only looks at the columns outside the box found so far.
+PixelRect FindInkBounds(ConstPixelView pixels) noexcept;
+
+// A signature bitmap reduced to what has to be embedded. Captured signatures are
+// mostly transparent margin around ink of a single colour, which PDFium would
+// otherwise encode as a full-size RGB image plus an 8-bit soft mask.
+struct CompactSignatureBitmap
+{
+    enum class Format
+    {
+        Gray8, // opaque grayscale: one byte per pixel, no soft mask
+        Bgra8, // straight (non-premultiplied) alpha
+    };
+
+    Format format{ Format::Bgra8 };
+    std::vector<uint8_t> data{};
+    int32_t width{};
+    int32_t height{};
+    int32_t stride{};
+
+    // Where `data` sits inside the source bitmap, so placement is unchanged by cropping.
+    PixelRect crop{};
+
+    // True when every ink pixel was recoloured to one ink colour. PDFium then writes
+    // a constant RGB plane that deflates to almost nothing, leaving the soft mask as
+    // the only real image data.
+    bool singleColor{};
+};
+
+// Crops to FindInkBounds and picks the smallest representation: Gray8 when the ink is
+// opaque gray, otherwise BGRA with colour flattened to the ink colour when the ink is
+// (within rounding) one colour. Premultiplied input (RenderTargetBitmap output) is
+// converted to straight alpha, which is what PDFium expects. Throws std::runtime_error
+// if the bitmap has no ink.
+CompactSignatureBitmap CompactSignature(ConstPixelView pixels, bool premultiplied);
@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "SignatureInk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using Point = SignatureInk::Point;
+
+    constexpr uint8_t SerializedMagic[4]{ 'P', 'S', 'I', '1' };
+
+    float DistanceSquared(Point a, Point b) noexcept
+    {
+        const float dx = a.x - b.x;
+        const float dy = a.y - b.y;
+        return dx * dx + dy * dy;
+    }
+
+    // Squared distance from p to the segment a-b.
+    float SegmentDistanceSquared(Point p, Point a, Point b) noexcept
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float lengthSquared = dx * dx + dy * dy;
+        if (lengthSquared <= 0.0f) return DistanceSquared(p, a);
+
+        float t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared;
+        t = (std::min)(1.0f, (std::max)(0.0f, t));
+        return DistanceSquared(p, Point{ a.x + t * dx, a.y + t * dy });
+    }
+
+    // Ramer-Douglas-Peucker over points[0, count); compacts the kept points to the
+    // front and returns how many there are. Iterative so long strokes cannot overflow the stack.
+    size_t Simplify(Point* points, size_t count, float tolerance)
+    {
+        if (count < 3) return count;
+
+        std::vector<bool> keep(count, false);
+        keep.front() = true;
+        keep.back() = true;
+
+        const float toleranceSquared = tolerance * tolerance;
+        std::vector<std::pair<size_t, size_t>> ranges{ { 0, count - 1 } };
+        while (!ranges.empty())
+        {
+            const auto [first, last] = ranges.back();
+            ranges.pop_back();
+
+            float farthest = 0.0f;
+            size_t index = first;
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                const float d = SegmentDistanceSquared(points[i], points[first], points[last]);
+                if (d > farthest)
+                {
+                    farthest = d;
+                    index = i;
+                }
+            }
+
+            if (farthest > toleranceSquared)
+            {
+                keep[index] = true;
+                if (index - first > 1) ranges.push_back({ first, index });
+                if (last - index > 1) ranges.push_back({ index, last });
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (keep[i]) points[kept++] = points[i];
+        }
+        return kept;
+    }
+
+    void Append(std::vector<uint8_t>& out, void const* data, size_t size)
+    {
+        auto const* bytes = static_cast<uint8_t const*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    // The serialized form is little-endian; so are all targets this builds for.
+    struct Reader
+    {
+        uint8_t const* data;
+        size_t size;
+
+        template <typename T>
+        T Read()
+        {
+            if (size < sizeof(T)) throw std::runtime_error("Truncated signature ink data");
+            T value{};
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            size -= sizeof(T);
+            return value;
+        }
+    };
+}
+
+void SmoothStroke(PdfPoint const* points, size_t count, std::vector<InkCurve>& curves)
+{
+    if (count < 2) return;
+
+    // Segment i runs p1 -> p2; the tangents come from the neighbours p0 and p3
+    // (the end points are repeated at either end of the stroke).
+    const size_t last = count - 1;
+    for (size_t i = 0; i < last; ++i)
+    {
+        const PdfPoint p0 = points[i > 0 ? i - 1 : i];
+        const PdfPoint p1 = points[i];
+        const PdfPoint p2 = points[i + 1];
+        const PdfPoint p3 = points[i + 1 < last ? i + 2 : last];
+
+        curves.push_back({
+            { p1.x + (p2.x - p0.x) / 6.0, p1.y + (p2.y - p0.y) / 6.0 },
+            { p2.x - (p3.x - p1.x) / 6.0, p2.y - (p3.y - p1.y) / 6.0 },
+            p2 });
+    }
+}
+
+void SignatureInk::BeginStroke(Point point)
+{
+    if (m_drawing) EndStroke();
+
+    m_strokeStarts.push_back(static_cast<uint32_t>(m_points.size()));
+    m_points.push_back(point);
+    Include(point);
+    m_drawing = true;
+}
+
+bool SignatureInk::AddPoint(Point point)
+{
+    if (!m_drawing) return false;
+    if (DistanceSquared(point, m_points.back()) < MinSampleSpacing * MinSampleSpacing) return false;
+
+    m_points.push_back(point);
+    Include(point);
+    return true;
+}
+
+void SignatureInk::EndStroke()
+{
+    if (!m_drawing) return;
+    m_drawing = false;
+
+    const size_t start = m_strokeStarts.back();
+    const size_t kept = Simplify(m_points.data() + start, m_points.size() - start, m_tolerance);
+    m_points.resize(start + kept);
+}
+
+void SignatureInk::Clear() noexcept
+{
+    m_points.clear();
+    m_strokeStarts.clear();
+    m_drawing = false;
+}
+
+SignatureInk::StrokeView SignatureInk::Stroke(size_t index) const noexcept
+{
+    if (index >= m_strokeStarts.size()) return {};
+
+    const size_t start = m_strokeStarts[index];
+    const size_t end = index + 1 < m_strokeStarts.size() ? m_strokeStarts[index + 1] : m_points.size();
+    return { m_points.data() + start, end - start };
+}
+
+PdfRect SignatureInk::Bounds() const noexcept
+{
+    if (m_points.empty()) return {};
+    return { m_minX, m_minY, static_cast<double>(m_maxX) - m_minX, static_cast<double>(m_maxY) - m_minY };
+}
+
+PdfInkSignature SignatureInk::ToInkSignature(PdfSize canvasSize, double strokeWidth, uint32_t colorArgb) const
+{
+    PdfInkSignature ink{};
+    ink.canvasSize = canvasSize;
+    ink.strokeWidth = strokeWidth;
+    ink.colorArgb = colorArgb;
+    ink.strokes.reserve(StrokeCount());
+    for (size_t i = 0; i < StrokeCount(); ++i)
+    {
+        std::vector<PdfPoint> stroke{};
+        stroke.reserve(Stroke(i).count);
+        for (Point const& p : Stroke(i))
+        {
+            stroke.push_back({ p.x, p.y });
+        }
+        ink.strokes.push_back(std::move(stroke));
+    }
+    return ink;
+}
+
+PdfInkSignature SignatureInk::ToCroppedInkSignature(double strokeWidth, uint32_t colorArgb) const
+{
+    const PdfRect bounds = Bounds();
+    const double margin = strokeWidth / 2.0;
+
+    PdfInkSignature ink = ToInkSignature({ bounds.width + strokeWidth, bounds.height + strokeWidth }, strokeWidth, colorArgb);
+    for (auto& stroke : ink.strokes)
+    {
+        for (PdfPoint& p : stroke)
+        {
+            p.x += margin - bounds.x;
+            p.y += margin - bounds.y;
+        }
+    }
+    return ink;
+}
+
+std::vector<uint8_t> SignatureInk::Serialize() const
+{
+    // magic, tolerance, stroke count, then per stroke: point count and x/y pairs.
+    std::vector<uint8_t> out{};
+    out.reserve(sizeof(SerializedMagic) + 8 + m_strokeStarts.size() * 4 + m_points.size() * sizeof(Point));
+
+    Append(out, SerializedMagic, sizeof(SerializedMagic));
+    Append(out, &m_tolerance, sizeof(m_tolerance));
+    const uint32_t strokeCount = static_cast<uint32_t>(StrokeCount());
+    Append(out, &strokeCount, sizeof(strokeCount));
+    for (size_t i = 0; i < StrokeCount(); ++i)
+    {
+        const StrokeView stroke = Stroke(i);
+        const uint32_t pointCount = static_cast<uint32_t>(stroke.count);
+        Append(out, &pointCount, sizeof(pointCount));
+        Append(out, stroke.points, stroke.count * sizeof(Point));
+    }
+    return out;
+}
+
+SignatureInk SignatureInk::Deserialize(uint8_t const* data, size_t size)
+{
+    Reader reader{ data, size };
+    for (uint8_t expected : SerializedMagic)
+    {
+        if (reader.Read<uint8_t>() != expected) throw std::runtime_error("Not signature ink data");
+    }
+
+    const float tolerance = reader.Read<float>();
+    if (!std::isfinite(tolerance) || tolerance < 0.0f) throw std::runtime_error("Corrupt signature ink data");
+
+    SignatureInk ink(tolerance);
+    const uint32_t strokeCount = reader.Read<uint32_t>();
+    for (uint32_t s = 0; s < strokeCount; ++s)
+    {
+        const uint32_t pointCount = reader.Read<uint32_t>();
+        if (pointCount == 0 || pointCount > reader.size / sizeof(Point)) throw std::runtime_error("Corrupt signature ink data");
+
+        // Already simplified when it was stored; append as-is.
+        ink.m_strokeStarts.push_back(static_cast<uint32_t>(ink.m_points.size()));
+        for (uint32_t p = 0; p < pointCount; ++p)
+        {
+            Point point{};
+            point.x = reader.Read<float>();
+            point.y = reader.Read<float>();
+            if (!std::isfinite(point.x) || !std::isfinite(point.y)) throw std::runtime_error("Corrupt signature ink data");
+            ink.m_points.push_back(point);
+            ink.Include(point);
+        }
+    }
+    if (reader.size != 0) throw std::runtime_error("Corrupt signature ink data");
+    return ink;
+}
+
+void SignatureInk::Include(Point point) noexcept
+{
+    if (m_points.size() == 1)
+    {
+        m_minX = m_maxX = point.x;
+        m_minY = m_maxY = point.y;
+        return;
+    }
+    m_minX = (std::min)(m_minX, point.x);
+    m_minY = (std::min)(m_minY, point.y);
+    m_maxX = (std::max)(m_maxX, point.x);
+    m_maxY = (std::max)(m_maxY, point.y);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PdfDocumentHandler.h"
+
+// One cubic Bezier segment; it starts where the previous segment (or the stroke) ends.
+struct InkCurve
+{
+    PdfPoint control1{};
+    PdfPoint control2{};
+    PdfPoint end{};
+};
+
+// Catmull-Rom spline through `points`, as cubic Beziers (count - 1 segments).
+void SmoothStroke(PdfPoint const* points, size_t count, std::vector<InkCurve>& curves);
+
+// Platform-neutral model of a hand-drawn signature, fed by pointer samples.
+//
+// Points of all strokes live in one flat float array with per-stroke offsets. Samples
+// closer than MinSampleSpacing to the previous kept point are dropped as they arrive;
+// when a stroke ends it is reduced with Ramer-Douglas-Peucker to within `tolerance`
+// of the raw trace, which typically leaves a tenth of the samples. The bounding box
+// is kept up to date as points arrive.
+//
+// The UI draws Stroke(i); stamping uses ToInkSignature; Serialize/Deserialize store it.
+class SignatureInk
+{
+public:
+    struct Point
+    {
+        float x{};
+        float y{};
+    };
+
+    // Default RDP tolerance and live sample spacing, in input units (DIPs for the canvas).
+    static constexpr float DefaultTolerance = 0.5f;
+    static constexpr float MinSampleSpacing = 1.0f;
+
+    explicit SignatureInk(float tolerance = DefaultTolerance) noexcept
+        : m_tolerance(tolerance)
+    {
+    }
+
+    void BeginStroke(Point point);
+
+    // Returns false if the sample was dropped (too close to the last kept point, or no
+    // stroke in progress), so callers only redraw for points that were kept.
+    bool AddPoint(Point point);
+
+    // Simplifies the finished stroke in place. No-op without a stroke in progress.
+    void EndStroke();
+
+    void Clear() noexcept;
+
+    bool Empty() const noexcept { return m_points.empty(); }
+    bool IsDrawing() const noexcept { return m_drawing; }
+    size_t StrokeCount() const noexcept { return m_strokeStarts.size(); }
+    size_t PointCount() const noexcept { return m_points.size(); }
+
+    struct StrokeView
+    {
+        Point const* points{};
+        size_t count{};
+
+        Point const* begin() const noexcept { return points; }
+        Point const* end() const noexcept { return points + count; }
+    };
+    StrokeView Stroke(size_t index) const noexcept;
+
+    // Bounding box of every accepted sample, including ones simplification later dropped
+    // (so it may exceed the kept points by up to the tolerance). Stroke width not included.
+    PdfRect Bounds() const noexcept;
+
+    // Stroke data for PdfDocumentHandler::StampSignatureStrokes.
+    PdfInkSignature ToInkSignature(PdfSize canvasSize, double strokeWidth, uint32_t colorArgb) const;
+
+    // Same, with the canvas cropped to the ink (Bounds plus half the pen on every side),
+    // so the stamp rect is filled by the signature rather than the empty canvas around it.
+    PdfInkSignature ToCroppedInkSignature(double strokeWidth, uint32_t colorArgb) const;
+
+    // Compact binary form (little-endian floats). Deserialize throws std::runtime_error
+    // on malformed input: truncated or trailing bytes, empty strokes, a negative or
+    // non-finite tolerance, non-finite coordinates.
+    std::vector<uint8_t> Serialize() const;
+    static SignatureInk Deserialize(uint8_t const* data, size_t size);
+
+private:
+    void Include(Point point) noexcept;
+
+    std::vector<Point> m_points{};
+    std::vector<uint32_t> m_strokeStarts{};
+    float m_tolerance{};
+    bool m_drawing{};
+
+    float m_minX{}, m_minY{}, m_maxX{}, m_maxY{};
+};
@@ -0,0 +1,307 @@
+#include "pch.h"
+#include "TextIndex.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <iterator>
+
+namespace
+{
+    struct CodeUnitRange
+    {
+        char16_t first;
+        char16_t last;
+    };
+
+    // The BMP code points beyond ASCII that are not letters, combining marks or digits:
+    // punctuation, symbols, spaces and format characters (General_Category P*, S*, Z*,
+    // Cf), sorted. Blocks of such characters are listed whole; lone ones inside letter
+    // blocks are listed where documents use them (Greek ano teleia, Arabic comma, ...).
+    constexpr CodeUnitRange NonWordRanges[] = {
+        { 0x0080, 0x00A9 },   // C1 controls, no-break space, inverted !, currency, section sign, (c)
+        { 0x00AB, 0x00B1 },   // guillemet, not sign, soft hyphen, (R), macron, degree, plus-minus
+        { 0x00B4, 0x00B4 },   // acute accent
+        { 0x00B6, 0x00B8 },   // pilcrow, middle dot, cedilla
+        { 0x00BB, 0x00BB },   // guillemet
+        { 0x00BF, 0x00BF },   // inverted question mark
+        { 0x00D7, 0x00D7 },   // multiplication sign
+        { 0x00F7, 0x00F7 },   // division sign
+        { 0x02C2, 0x02C5 },   // modifier symbols
+        { 0x02D2, 0x02DF },
+        { 0x02E5, 0x02EB },
+        { 0x02ED, 0x02ED },
+        { 0x02EF, 0x02FF },
+        { 0x0375, 0x0375 },   // Greek
+        { 0x037E, 0x037E },
+        { 0x0384, 0x0385 },
+        { 0x0387, 0x0387 },
+        { 0x03F6, 0x03F6 },
+        { 0x0482, 0x0482 },   // Cyrillic thousands sign
+        { 0x055A, 0x055F },   // Armenian
+        { 0x0589, 0x058A },
+        { 0x058D, 0x058F },
+        { 0x05BE, 0x05BE },   // Hebrew
+        { 0x05C0, 0x05C0 },
+        { 0x05C3, 0x05C3 },
+        { 0x05C6, 0x05C6 },
+        { 0x05F3, 0x05F4 },
+        { 0x0600, 0x060F },   // Arabic
+        { 0x061B, 0x061F },
+        { 0x066A, 0x066D },
+        { 0x06D4, 0x06D4 },
+        { 0x06DE, 0x06DE },
+        { 0x06E9, 0x06E9 },
+        { 0x06FD, 0x06FE },
+        { 0x0964, 0x0965 },   // Devanagari danda
+        { 0x0970, 0x0970 },
+        { 0x0E3F, 0x0E3F },   // Thai
+        { 0x0E4F, 0x0E4F },
+        { 0x0E5A, 0x0E5B },
+        { 0x2000, 0x206F },   // general punctuation, spaces, format characters
+        { 0x20A0, 0x214F },   // currency, symbol marks, letterlike symbols
+        { 0x2190, 0x2BFF },   // arrows, maths, technical, box drawing, shapes, dingbats
+        { 0x2E00, 0x2E7F },   // supplemental punctuation
+        { 0x3000, 0x3004 },   // CJK symbols and punctuation
+        { 0x3008, 0x3020 },
+        { 0x3030, 0x3030 },
+        { 0x3036, 0x3037 },
+        { 0x303D, 0x303F },
+        { 0x30FB, 0x30FB },   // katakana middle dot
+        { 0xFD3E, 0xFD3F },   // ornate parentheses
+        { 0xFE10, 0xFE1F },   // vertical forms
+        { 0xFE30, 0xFE6F },   // CJK compatibility and small forms
+        { 0xFEFF, 0xFEFF },   // byte order mark
+        { 0xFF01, 0xFF0F },   // fullwidth punctuation and symbols
+        { 0xFF1A, 0xFF20 },
+        { 0xFF3B, 0xFF40 },
+        { 0xFF5B, 0xFF65 },
+        { 0xFFE0, 0xFFFF },   // fullwidth symbols, specials
+    };
+
+    // Letters, marks and digits of any script. Surrogates and private-use code points
+    // (where some fonts put their glyphs) count as letters.
+    bool IsWordChar(char16_t c) noexcept
+    {
+        if (c < 0x80)
+        {
+            return (c >= u'0' && c <= u'9') || (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z');
+        }
+        auto after = std::upper_bound(std::begin(NonWordRanges), std::end(NonWordRanges), c,
+            [](char16_t value, CodeUnitRange const& range) { return value < range.first; });
+        return after == std::begin(NonWordRanges) || c > std::prev(after)->last;
+    }
+
+    char16_t Fold(char16_t c) noexcept
+    {
+        if (c >= u'A' && c <= u'Z') return static_cast<char16_t>(c + (u'a' - u'A'));
+        if (c < 0x80) return c;
+        return static_cast<char16_t>(std::towlower(static_cast<wint_t>(c)));
+    }
+
+    // Calls onWord(begin, end, foldedWord) for each word of `text`.
+    template <typename TOnWord>
+    void ForEachWord(std::u16string_view text, TOnWord const& onWord)
+    {
+        std::u16string word{};
+        size_t begin = 0;
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            if (i < text.size() && IsWordChar(text[i]))
+            {
+                if (word.empty()) begin = i;
+                word.push_back(Fold(text[i]));
+                continue;
+            }
+            if (!word.empty())
+            {
+                onWord(begin, i, word);
+                word.clear();
+            }
+        }
+    }
+}
+
+uint32_t TextIndex::TermId(std::u16string const& term)
+{
+    auto [it, inserted] = m_vocabulary.emplace(term, static_cast<uint32_t>(m_postings.size()));
+    if (inserted) m_postings.emplace_back();
+    return it->second;
+}
+
+void TextIndex::AddPage(int32_t pageIndex, PdfPageText const& text)
+{
+    if (pageIndex < 0) return;
+    RemovePage(pageIndex);
+
+    const size_t page = static_cast<size_t>(pageIndex);
+    if (page >= m_pages.size())
+    {
+        m_pages.resize(page + 1);
+        m_indexed.resize(page + 1, false);
+    }
+
+    std::vector<Word>& words = m_pages[page];
+    ForEachWord(text.text, [&](size_t begin, size_t end, std::u16string const& folded)
+    {
+        Word word{};
+        word.term = TermId(folded);
+        word.charIndex = static_cast<int32_t>(begin);
+        word.charCount = static_cast<int32_t>(end - begin);
+
+        // Generated characters (and some glyphs) have no box; the word's box covers the rest.
+        bool& hasBox = word.hasBox;
+        for (size_t i = begin; i < end && i < text.charBoxes.size(); ++i)
+        {
+            PdfRect const& box = text.charBoxes[i];
+            if (box.width <= 0.0 && box.height <= 0.0) continue;
+
+            const float left = static_cast<float>(box.x);
+            const float bottom = static_cast<float>(box.y);
+            const float right = static_cast<float>(box.x + box.width);
+            const float top = static_cast<float>(box.y + box.height);
+            word.left = hasBox ? (std::min)(word.left, left) : left;
+            word.bottom = hasBox ? (std::min)(word.bottom, bottom) : bottom;
+            word.right = hasBox ? (std::max)(word.right, right) : right;
+            word.top = hasBox ? (std::max)(word.top, top) : top;
+            hasBox = true;
+        }
+
+        m_postings[word.term].push_back(Posting{ pageIndex, static_cast<uint32_t>(words.size()) });
+        words.push_back(word);
+    });
+    words.shrink_to_fit();
+
+    m_indexed[page] = true;
+    ++m_indexedPages;
+}
+
+void TextIndex::RemovePage(int32_t pageIndex)
+{
+    if (!HasPage(pageIndex)) return;
+
+    std::vector<Word>& words = m_pages[static_cast<size_t>(pageIndex)];
+    std::vector<uint32_t> terms{};
+    terms.reserve(words.size());
+    for (Word const& word : words) terms.push_back(word.term);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    for (uint32_t term : terms)
+    {
+        auto& postings = m_postings[term];
+        postings.erase(std::remove_if(postings.begin(), postings.end(), [pageIndex](Posting const& posting)
+        {
+            return posting.pageIndex == pageIndex;
+        }), postings.end());
+    }
+
+    words.clear();
+    m_indexed[static_cast<size_t>(pageIndex)] = false;
+    --m_indexedPages;
+}
+
+bool TextIndex::HasPage(int32_t pageIndex) const noexcept
+{
+    return pageIndex >= 0 && static_cast<size_t>(pageIndex) < m_indexed.size() && m_indexed[static_cast<size_t>(pageIndex)];
+}
+
+std::vector<PdfTextMatch> TextIndex::Find(std::u16string_view query, size_t maxResults) const
+{
+    std::vector<std::u16string> terms{};
+    ForEachWord(query, [&terms](size_t, size_t, std::u16string const& folded) { terms.push_back(folded); });
+    if (terms.empty() || maxResults == 0) return {};
+
+    // Every word but the last must match exactly.
+    std::vector<uint32_t> exact{};
+    for (size_t i = 0; i + 1 < terms.size(); ++i)
+    {
+        auto it = m_vocabulary.find(terms[i]);
+        if (it == m_vocabulary.end()) return {};
+        exact.push_back(it->second);
+    }
+
+    // The last one is a prefix: the vocabulary range starting with it.
+    std::u16string const& last = terms.back();
+    std::vector<uint32_t> lastTerms{};
+    for (auto it = m_vocabulary.lower_bound(last); it != m_vocabulary.end() && it->first.compare(0, last.size(), last) == 0; ++it)
+    {
+        lastTerms.push_back(it->second);
+    }
+    if (lastTerms.empty()) return {};
+    std::sort(lastTerms.begin(), lastTerms.end());
+
+    std::vector<Posting> starts{};
+    if (exact.empty())
+    {
+        for (uint32_t term : lastTerms)
+        {
+            starts.insert(starts.end(), m_postings[term].begin(), m_postings[term].end());
+        }
+    }
+    else
+    {
+        starts = m_postings[exact.front()];
+    }
+
+    // Keep the phrase starts whose following words match.
+    const size_t wordCount = terms.size();
+    starts.erase(std::remove_if(starts.begin(), starts.end(), [&](Posting const& start)
+    {
+        std::vector<Word> const& words = m_pages[static_cast<size_t>(start.pageIndex)];
+        if (start.wordIndex + wordCount > words.size()) return true;
+        for (size_t i = 1; i < exact.size(); ++i)
+        {
+            if (words[start.wordIndex + i].term != exact[i]) return true;
+        }
+        return !std::binary_search(lastTerms.begin(), lastTerms.end(), words[start.wordIndex + wordCount - 1].term);
+    }), starts.end());
+
+    // Word order within a page is text order.
+    auto inTextOrder = [](Posting const& a, Posting const& b)
+    {
+        return a.pageIndex != b.pageIndex ? a.pageIndex < b.pageIndex : a.wordIndex < b.wordIndex;
+    };
+    const size_t kept = (std::min)(maxResults, starts.size());
+    std::partial_sort(starts.begin(), starts.begin() + static_cast<ptrdiff_t>(kept), starts.end(), inTextOrder);
+    starts.resize(kept);
+
+    std::vector<PdfTextMatch> matches{};
+    matches.reserve(kept);
+    for (Posting const& start : starts)
+    {
+        std::vector<Word> const& words = m_pages[static_cast<size_t>(start.pageIndex)];
+        Word const& first = words[start.wordIndex];
+        Word const& end = words[start.wordIndex + wordCount - 1];
+
+        // Words without a box do not pull the match's box towards the page origin.
+        bool hasBox = false;
+        float left = 0.0f, bottom = 0.0f, right = 0.0f, top = 0.0f;
+        for (size_t i = 0; i < wordCount; ++i)
+        {
+            Word const& word = words[start.wordIndex + i];
+            if (!word.hasBox) continue;
+            left = hasBox ? (std::min)(left, word.left) : word.left;
+            bottom = hasBox ? (std::min)(bottom, word.bottom) : word.bottom;
+            right = hasBox ? (std::max)(right, word.right) : word.right;
+            top = hasBox ? (std::max)(top, word.top) : word.top;
+            hasBox = true;
+        }
+
+        PdfTextMatch match{};
+        match.pageIndex = start.pageIndex;
+        match.charIndex = first.charIndex;
+        match.charCount = end.charIndex + end.charCount - first.charIndex;
+        match.bounds = PdfRect{ left, bottom, right - left, top - bottom };
+        matches.push_back(match);
+    }
+    return matches;
+}
+
+void TextIndex::Clear() noexcept
+{
+    m_vocabulary.clear();
+    m_postings.clear();
+    m_pages.clear();
+    m_indexed.clear();
+    m_indexedPages = 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PdfDocumentHandler.h"
+
+// A hit: characters [charIndex, charIndex + charCount) of the page's text, and the box
+// around them in PDF points (bottom-left origin), ready to anchor a signature rect.
+// The box is empty (all zero) if none of the characters had one.
+struct PdfTextMatch
+{
+    int32_t pageIndex{};
+    int32_t charIndex{};
+    int32_t charCount{};
+    PdfRect bounds{};
+};
+
+// Inverted index over the text of a document's pages, filled one page at a time in
+// any order (PdfDocumentHandler::ExtractPageText). Queries never touch the document.
+//
+// Text is split into words (runs of letters and digits) and case-folded; each word
+// keeps its character range and the box around its characters. A query matches
+// consecutive words, the last one as a prefix, so "initial he" finds "Initial here".
+//
+// Memory is about 30 bytes per word plus the vocabulary; character boxes are merged
+// into word boxes as pages are added and not kept.
+class TextIndex
+{
+public:
+    // Indexes (or re-indexes) a page.
+    void AddPage(int32_t pageIndex, PdfPageText const& text);
+
+    bool HasPage(int32_t pageIndex) const noexcept;
+    size_t IndexedPageCount() const noexcept { return m_indexedPages; }
+
+    // Matches in page and text order; at most maxResults.
+    std::vector<PdfTextMatch> Find(std::u16string_view query, size_t maxResults = 1000) const;
+
+    void Clear() noexcept;
+
+private:
+    struct Word
+    {
+        uint32_t term{};
+        int32_t charIndex{};
+        int32_t charCount{};
+        float left{};
+        float bottom{};
+        float right{};
+        float top{};
+        bool hasBox{}; // false: none of its characters had a box, and the edges are 0
+    };
+
+    struct Posting
+    {
+        int32_t pageIndex{};
+        uint32_t wordIndex{}; // into the page's words
+    };
+
+    uint32_t TermId(std::u16string const& term);
+    void RemovePage(int32_t pageIndex);
+
+    // Folded word -> term id; ordered so a prefix is a contiguous range.
+    std::map<std::u16string, uint32_t> m_vocabulary{};
+    std::vector<std::vector<Posting>> m_postings{}; // by term id
+    std::vector<std::vector<Word>> m_pages{};       // by page index
+    std::vector<bool> m_indexed{};
+    size_t m_indexedPages{};
+};
@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    // 16K spans is a few minutes of interactive use; ~0.75 MB.
+    constexpr uint64_t Capacity = 1u << 14;
+    constexpr uint64_t Mask = Capacity - 1;
+
+    // Seqlock per slot: odd while being written, 2 * (index + 1) once span `index` is complete.
+    // Fields are relaxed atomics so a reader racing a writer is defined behaviour; it simply
+    // discards the slot.
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{};
+        std::atomic<char const*> name{};
+        std::atomic<int64_t> page{};
+        std::atomic<uint64_t> startNs{};
+        std::atomic<uint64_t> durationNs{};
+        std::atomic<uint32_t> threadId{};
+    };
+
+    Slot g_slots[Capacity]{};
+    std::atomic<uint64_t> g_next{};
+    std::atomic<uint64_t> g_clearedAt{};
+    std::atomic<uint32_t> g_nextThreadId{};
+
+    std::mutex g_threadNamesMutex{};
+    std::map<uint32_t, std::string> g_threadNames{};
+
+    uint32_t CurrentThreadId() noexcept
+    {
+        thread_local const uint32_t id = g_nextThreadId.fetch_add(1, std::memory_order_relaxed) + 1;
+        return id;
+    }
+
+    std::string Escape(std::string const& text)
+    {
+        std::string escaped{};
+        escaped.reserve(text.size());
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    double Milliseconds(uint64_t ns) noexcept
+    {
+        return static_cast<double>(ns) / 1e6;
+    }
+}
+
+void SetTraceEnabled(bool enabled) noexcept
+{
+    TraceLogDetail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void ClearTrace() noexcept
+{
+    g_clearedAt.store(g_next.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void SetTraceThreadName(char const* name)
+{
+    const uint32_t id = CurrentThreadId();
+    std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+    g_threadNames[id] = name;
+}
+
+uint64_t TraceNowNs() noexcept
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void RecordTraceSpan(char const* name, int64_t page, uint64_t startNs, uint64_t endNs) noexcept
+{
+    const uint64_t index = g_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = g_slots[index & Mask];
+
+    slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.page.store(page, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs > startNs ? endNs - startNs : 0, std::memory_order_relaxed);
+    slot.threadId.store(CurrentThreadId(), std::memory_order_relaxed);
+    slot.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceSnapshot()
+{
+    const uint64_t end = g_next.load(std::memory_order_acquire);
+    const uint64_t begin = (std::max)(end > Capacity ? end - Capacity : 0, g_clearedAt.load(std::memory_order_acquire));
+
+    std::vector<TraceEvent> events{};
+    events.reserve(static_cast<size_t>(end - (std::min)(begin, end)));
+    for (uint64_t index = begin; index < end; ++index)
+    {
+        Slot const& slot = g_slots[index & Mask];
+        const uint64_t expected = index * 2 + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) continue; // in flight or overwritten
+
+        TraceEvent event{};
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.page = slot.page.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        event.threadId = slot.threadId.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected || !event.name) continue;
+        events.push_back(event);
+    }
+
+    std::sort(events.begin(), events.end(), [](TraceEvent const& a, TraceEvent const& b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+std::string ExportChromeTrace()
+{
+    const std::vector<TraceEvent> events = TraceSnapshot();
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char line[256]{};
+
+    {
+        std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+        for (auto const& [id, name] : g_threadNames)
+        {
+            std::snprintf(line, sizeof(line), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                first ? "" : ",", id);
+            json += line;
+            json += Escape(name) + "\"}}";
+            first = false;
+        }
+    }
+
+    for (TraceEvent const& event : events)
+    {
+        // The category is the prefix before the first '.', e.g. "pdf" for "pdf.rasterize".
+        const std::string name = event.name;
+        const std::string category = name.substr(0, name.find('.'));
+        std::snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+            first ? "" : ",", Escape(name).c_str(), Escape(category).c_str(),
+            static_cast<double>(event.startNs) / 1e3, static_cast<double>(event.durationNs) / 1e3, event.threadId);
+        json += line;
+        if (event.page >= 0)
+        {
+            std::snprintf(line, sizeof(line), ",\"args\":{\"page\":%lld}", static_cast<long long>(event.page + 1));
+            json += line;
+        }
+        json += "}";
+        first = false;
+    }
+
+    json += "\n],\"otherData\":{\"summary\":\"" + Escape(TraceSummary()) + "\"}}\n";
+    return json;
+}
+
+std::string TraceSummary(size_t slowest)
+{
+    std::vector<TraceEvent> events = TraceSnapshot();
+    if (events.empty()) return "No spans recorded.\n";
+
+    struct Totals
+    {
+        uint64_t count{};
+        uint64_t totalNs{};
+        uint64_t maxNs{};
+    };
+    std::map<std::string, Totals> byName{};
+    for (TraceEvent const& event : events)
+    {
+        Totals& totals = byName[event.name];
+        ++totals.count;
+        totals.totalNs += event.durationNs;
+        totals.maxNs = (std::max)(totals.maxNs, event.durationNs);
+    }
+
+    std::vector<std::pair<std::string, Totals>> operations(byName.begin(), byName.end());
+    std::sort(operations.begin(), operations.end(), [](auto const& a, auto const& b) { return a.second.totalNs > b.second.totalNs; });
+
+    const uint64_t spanNs = events.back().startNs + events.back().durationNs - events.front().startNs;
+    char line[160]{};
+    std::snprintf(line, sizeof(line), "%zu spans over %.1f ms\n%-24s %8s %12s %10s %10s\n",
+        events.size(), Milliseconds(spanNs), "operation", "count", "total ms", "mean ms", "max ms");
+    std::string summary = line;
+    for (auto const& [name, totals] : operations)
+    {
+        std::snprintf(line, sizeof(line), "%-24s %8llu %12.2f %10.2f %10.2f\n", name.c_str(),
+            static_cast<unsigned long long>(totals.count), Milliseconds(totals.totalNs),
+            Milliseconds(totals.totalNs) / static_cast<double>(totals.count), Milliseconds(totals.maxNs));
+        summary += line;
+    }
+
+    const size_t shown = (std::min)(slowest, events.size());
+    std::partial_sort(events.begin(), events.begin() + static_cast<ptrdiff_t>(shown), events.end(),
+        [](TraceEvent const& a, TraceEvent const& b) { return a.durationNs > b.durationNs; });
+
+    summary += "slowest:\n";
+    for (size_t i = 0; i < shown; ++i)
+    {
+        TraceEvent const& event = events[i];
+        char page[32]{};
+        if (event.page >= 0) std::snprintf(page, sizeof(page), " page %lld", static_cast<long long>(event.page + 1));
+        std::snprintf(line, sizeof(line), "  %10.2f ms  %s%s (at %.1f ms, thread %u)\n", Milliseconds(event.durationNs),
+            event.name, page, Milliseconds(event.startNs), event.threadId);
+        summary += line;
+    }
+    return summary;
+}
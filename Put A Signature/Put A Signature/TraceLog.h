@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped timing spans for the hot paths (file read, load, page load, rasterize, copy,
+// display, stamp, save), kept in a fixed-size lock-free ring buffer and exported on
+// demand as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Recording is off by default. While off, a TraceSpan costs one relaxed atomic load.
+// Once the ring is full the oldest spans are overwritten.
+
+namespace TraceLogDetail
+{
+    inline std::atomic<bool> enabled{ false };
+}
+
+struct TraceEvent
+{
+    char const* name{};   // string literal
+    int64_t page{ -1 };   // page index, or -1
+    uint64_t startNs{};   // since the first traced event of the process
+    uint64_t durationNs{};
+    uint32_t threadId{};  // small per-thread number, not the OS id
+};
+
+inline bool TraceEnabled() noexcept
+{
+    return TraceLogDetail::enabled.load(std::memory_order_relaxed);
+}
+
+void SetTraceEnabled(bool enabled) noexcept;
+
+// Drops every recorded span.
+void ClearTrace() noexcept;
+
+// Labels the calling thread in the export (e.g. "PDF executor").
+void SetTraceThreadName(char const* name);
+
+uint64_t TraceNowNs() noexcept;
+void RecordTraceSpan(char const* name, int64_t page, uint64_t startNs, uint64_t endNs) noexcept;
+
+// Spans currently in the ring, oldest first. Spans being written while the snapshot is
+// taken are skipped.
+std::vector<TraceEvent> TraceSnapshot();
+
+// {"traceEvents": [...], "otherData": {"summary": ...}} with one complete ("X") event per span.
+std::string ExportChromeTrace();
+
+// Per-operation count/total/max, busiest first, then the `slowest` longest single spans.
+std::string TraceSummary(size_t slowest = 10);
+
+// Times its own scope. `name` must be a string literal (it is stored, not copied).
+class TraceSpan
+{
+public:
+    explicit TraceSpan(char const* name, int64_t page = -1) noexcept
+    {
+        if (!TraceEnabled()) return;
+        m_name = name;
+        m_page = page;
+        m_startNs = TraceNowNs();
+    }
+
+    ~TraceSpan() { End(); }
+
+    // Ends the span early (e.g. before a co_await that should not be counted).
+    void End() noexcept
+    {
+        if (!m_name) return;
+        RecordTraceSpan(m_name, m_page, m_startNs, TraceNowNs());
+        m_name = nullptr;
+    }
+
+    TraceSpan(TraceSpan const&) = delete;
+    TraceSpan& operator=(TraceSpan const&) = delete;
+
+private:
+    char const* m_name{};
+    int64_t m_page{ -1 };
+    uint64_t m_startNs{};
+};
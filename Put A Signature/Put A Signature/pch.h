@@ -1,4 +1,8 @@
 #pragma once
+
+// Headless builds (tools/) compile the PDFium core on platforms without the
+// Windows App SDK; they get none of the WinUI/WinRT headers below.
+#if !defined(PUT_A_SIGNATURE_HEADLESS)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -31,3 +35,4 @@
 #include <winrt/Microsoft.UI.Xaml.Shapes.h>
 #include <winrt/Microsoft.UI.Dispatching.h>
 #include <wil/cppwinrt_helpers.h>
+#endif
@@ -0,0 +1,87 @@
+#include "BatchManifest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    std::vector<std::string> SplitTabs(std::string const& line)
+    {
+        std::vector<std::string> fields{};
+        size_t start = 0;
+        for (;;)
+        {
+            const size_t tab = line.find('\t', start);
+            fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+            if (tab == std::string::npos) break;
+            start = tab + 1;
+        }
+        return fields;
+    }
+
+    std::runtime_error ManifestError(std::string const& path, size_t lineNumber, std::string const& message)
+    {
+        return std::runtime_error(path + ":" + std::to_string(lineNumber) + ": " + message);
+    }
+
+    std::string Resolve(std::filesystem::path const& baseDir, std::string const& path)
+    {
+        std::filesystem::path p(path);
+        return (p.is_absolute() ? p : baseDir / p).lexically_normal().string();
+    }
+}
+
+std::vector<BatchJob> LoadBatchManifest(std::string const& manifestPath)
+{
+    std::ifstream in(manifestPath);
+    if (!in) throw std::runtime_error("Cannot open manifest: " + manifestPath);
+
+    const std::filesystem::path baseDir = std::filesystem::absolute(manifestPath).parent_path();
+
+    std::vector<BatchJob> jobs{};
+    std::string line{};
+    size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        const std::vector<std::string> fields = SplitTabs(line);
+        if (fields.size() != 5)
+        {
+            throw ManifestError(manifestPath, lineNumber, "expected 5 tab-separated fields, got " + std::to_string(fields.size()));
+        }
+
+        BatchJob job{};
+        job.input = Resolve(baseDir, fields[0]);
+        job.signature = Resolve(baseDir, fields[3]);
+        job.output = Resolve(baseDir, fields[4]);
+
+        try
+        {
+            size_t used = 0;
+            const int page = std::stoi(fields[1], &used);
+            if (used != fields[1].size() || page < 1) throw std::invalid_argument("page");
+            job.pageIndex = page - 1;
+        }
+        catch (std::exception const&)
+        {
+            throw ManifestError(manifestPath, lineNumber, "page must be a positive integer");
+        }
+
+        std::istringstream rect(fields[2]);
+        char comma1 = 0, comma2 = 0, comma3 = 0;
+        rect >> job.rect.x >> comma1 >> job.rect.y >> comma2 >> job.rect.width >> comma3 >> job.rect.height;
+        const bool consumed = rect && (rect >> std::ws, rect.peek() == std::char_traits<char>::eof());
+        if (!consumed || comma1 != ',' || comma2 != ',' || comma3 != ',' || job.rect.width <= 0 || job.rect.height <= 0)
+        {
+            throw ManifestError(manifestPath, lineNumber, "rect must be x,y,width,height with a positive size");
+        }
+
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
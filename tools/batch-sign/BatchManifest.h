@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PdfDocumentHandler.h"
+
+// One stamping job: put `signature` on `pageIndex` of `input` at `rect` and write `output`.
+struct BatchJob
+{
+    std::string input;
+    int32_t pageIndex{};
+    PdfRect rect{};
+    std::string signature;
+    std::string output;
+};
+
+// Reads a tab-separated manifest, one job per line:
+//
+//     input <TAB> page <TAB> x,y,width,height <TAB> signature <TAB> output
+//
+// page is 1-based; the rect is in PDF points from the bottom-left corner. Blank lines
+// and lines starting with '#' are skipped. Relative paths are resolved against the
+// manifest's directory. Throws std::runtime_error naming the offending line.
+std::vector<BatchJob> LoadBatchManifest(std::string const& manifestPath);
@@ -0,0 +1,106 @@
+#include "SignatureImage.h"
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Netpbm header token, skipping whitespace and '#' comments.
+    std::string NextToken(std::istream& in)
+    {
+        std::string token{};
+        int c = in.get();
+        for (;;)
+        {
+            while (c != EOF && std::isspace(c)) c = in.get();
+            if (c != '#') break;
+            while (c != EOF && c != '\n') c = in.get();
+        }
+        while (c != EOF && !std::isspace(c))
+        {
+            token.push_back(static_cast<char>(c));
+            c = in.get();
+        }
+        return token;
+    }
+
+    int NextInt(std::istream& in, char const* what)
+    {
+        const std::string token = NextToken(in);
+        try
+        {
+            return std::stoi(token);
+        }
+        catch (std::exception const&)
+        {
+            throw std::runtime_error(std::string("Bad ") + what + " in signature image header");
+        }
+    }
+}
+
+PixelBuffer LoadSignatureImage(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open signature image: " + path);
+
+    const std::string magic = NextToken(in);
+    int width = 0, height = 0, channels = 0, maxValue = 0;
+
+    if (magic == "P5" || magic == "P6")
+    {
+        width = NextInt(in, "width");
+        height = NextInt(in, "height");
+        maxValue = NextInt(in, "maxval");
+        channels = magic == "P5" ? 1 : 3;
+    }
+    else if (magic == "P7")
+    {
+        std::string tupleType{};
+        for (std::string key = NextToken(in); key != "ENDHDR"; key = NextToken(in))
+        {
+            if (key.empty()) throw std::runtime_error("Truncated PAM header: " + path);
+            if (key == "WIDTH") width = NextInt(in, "WIDTH");
+            else if (key == "HEIGHT") height = NextInt(in, "HEIGHT");
+            else if (key == "DEPTH") channels = NextInt(in, "DEPTH");
+            else if (key == "MAXVAL") maxValue = NextInt(in, "MAXVAL");
+            else if (key == "TUPLTYPE") tupleType = NextToken(in);
+        }
+        if (channels < 1 || channels > 4) throw std::runtime_error("Unsupported PAM depth: " + path);
+    }
+    else
+    {
+        throw std::runtime_error("Not a binary PAM/PPM/PGM image: " + path);
+    }
+
+    if (width <= 0 || height <= 0) throw std::runtime_error("Bad signature image size: " + path);
+    if (maxValue != 255) throw std::runtime_error("Only 8-bit signature images are supported: " + path);
+
+    const size_t rowBytes = static_cast<size_t>(width) * static_cast<size_t>(channels);
+    std::vector<uint8_t> row(rowBytes);
+
+    PixelBuffer pixels(width, height);
+    PixelView view = pixels.View();
+    for (int32_t y = 0; y < height; ++y)
+    {
+        if (!in.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(rowBytes)))
+        {
+            throw std::runtime_error("Truncated signature image: " + path);
+        }
+
+        uint8_t const* src = row.data();
+        uint8_t* dst = view.Row(y);
+        for (int32_t x = 0; x < width; ++x, src += channels, dst += PixelBuffer::BytesPerPixel)
+        {
+            // Gray or RGB, optionally followed by alpha; stored as BGRA.
+            const bool gray = channels <= 2;
+            dst[0] = gray ? src[0] : src[2];
+            dst[1] = gray ? src[0] : src[1];
+            dst[2] = src[0];
+            dst[3] = (channels == 2 || channels == 4) ? src[channels - 1] : 0xFF;
+        }
+    }
+    return pixels;
+}
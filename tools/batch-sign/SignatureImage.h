@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+#include "PixelBuffer.h"
+
+// Loads a signature image into BGRA pixels for PdfDocumentHandler::StampSignaturePixels.
+// Reads binary Netpbm files, which need no image library: PAM (P7, tuple types
+// RGB_ALPHA, RGB, GRAYSCALE_ALPHA, GRAYSCALE), PPM (P6) and PGM (P5), 8 bits per
+// channel. Use PAM with RGB_ALPHA for a transparent background.
+PixelBuffer LoadSignatureImage(std::string const& path);
@@ -0,0 +1,246 @@
+#include "WorkerPool.h"
+
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static_assert(sizeof(JobResult) <= PIPE_BUF, "JobResult must fit in one atomic pipe write");
+
+namespace
+{
+    constexpr int32_t StopJob = -1;
+
+    struct Worker
+    {
+        pid_t pid{ -1 };
+        int commandFd{ -1 }; // parent writes job indices
+        int resultFd{ -1 };  // parent reads JobResults
+        int32_t currentJob{ StopJob };
+        bool alive{};
+    };
+
+    // Reads exactly `size` bytes; false on EOF or error.
+    bool ReadAll(int fd, void* data, size_t size)
+    {
+        auto* bytes = static_cast<char*>(data);
+        while (size > 0)
+        {
+            const ssize_t got = ::read(fd, bytes, size);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            bytes += got;
+            size -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    bool WriteAll(int fd, void const* data, size_t size)
+    {
+        auto const* bytes = static_cast<char const*>(data);
+        while (size > 0)
+        {
+            const ssize_t put = ::write(fd, bytes, size);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) return false;
+            bytes += put;
+            size -= static_cast<size_t>(put);
+        }
+        return true;
+    }
+
+    void CloseFd(int& fd)
+    {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    [[noreturn]] void WorkerMain(int commandFd, int resultFd, WorkerPool::JobRunner const& runner)
+    {
+        int32_t jobIndex = StopJob;
+        while (ReadAll(commandFd, &jobIndex, sizeof(jobIndex)) && jobIndex != StopJob)
+        {
+            JobResult result = runner(jobIndex);
+            result.jobIndex = jobIndex;
+            if (!WriteAll(resultFd, &result, sizeof(result))) break;
+        }
+        // Skip static destructors and atexit handlers inherited from the parent.
+        ::_exit(0);
+    }
+}
+
+WorkerPool::WorkerPool(int32_t workerCount)
+    : m_workerCount(workerCount < 1 ? 1 : workerCount)
+{
+}
+
+void WorkerPool::Run(int32_t jobCount, JobRunner const& runner, ResultSink const& sink)
+{
+    if (jobCount <= 0) return;
+
+    // A worker that dies leaves a broken pipe; report that as a failed job instead of dying too.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int32_t workerCount = m_workerCount < jobCount ? m_workerCount : jobCount;
+    std::vector<Worker> workers(static_cast<size_t>(workerCount));
+
+    // Buffered output would otherwise be flushed again by every child.
+    std::fflush(nullptr);
+
+    for (int32_t i = 0; i < workerCount; ++i)
+    {
+        int commandPipe[2]{};
+        int resultPipe[2]{};
+        if (::pipe(commandPipe) != 0) throw std::runtime_error("pipe failed: " + std::string(std::strerror(errno)));
+        if (::pipe(resultPipe) != 0)
+        {
+            ::close(commandPipe[0]);
+            ::close(commandPipe[1]);
+            throw std::runtime_error("pipe failed: " + std::string(std::strerror(errno)));
+        }
+
+        const pid_t pid = ::fork();
+        if (pid < 0) throw std::runtime_error("fork failed: " + std::string(std::strerror(errno)));
+
+        if (pid == 0)
+        {
+            // Keep only this worker's own ends so siblings see EOF when the parent goes away.
+            for (int32_t j = 0; j < i; ++j)
+            {
+                CloseFd(workers[j].commandFd);
+                CloseFd(workers[j].resultFd);
+            }
+            ::close(commandPipe[1]);
+            ::close(resultPipe[0]);
+            WorkerMain(commandPipe[0], resultPipe[1], runner);
+        }
+
+        ::close(commandPipe[0]);
+        ::close(resultPipe[1]);
+        workers[i].pid = pid;
+        workers[i].commandFd = commandPipe[1];
+        workers[i].resultFd = resultPipe[0];
+        workers[i].alive = true;
+    }
+
+    int32_t nextJob = 0;
+    int32_t finished = 0;
+
+    auto dispatch = [&](Worker& worker)
+    {
+        while (worker.alive && nextJob < jobCount)
+        {
+            const int32_t job = nextJob++;
+            if (WriteAll(worker.commandFd, &job, sizeof(job)))
+            {
+                worker.currentJob = job;
+                return;
+            }
+            // Worker is gone; give the job back and stop using it.
+            --nextJob;
+            worker.alive = false;
+        }
+        worker.currentJob = StopJob;
+    };
+
+    auto failCurrent = [&](Worker& worker, char const* message)
+    {
+        if (worker.currentJob == StopJob) return;
+        JobResult result{};
+        result.jobIndex = worker.currentJob;
+        std::snprintf(result.error, sizeof(result.error), "%s", message);
+        worker.currentJob = StopJob;
+        ++finished;
+        sink(result);
+    };
+
+    for (auto& worker : workers) dispatch(worker);
+
+    std::vector<pollfd> fds{};
+    std::vector<Worker*> polled{};
+    while (finished < jobCount)
+    {
+        fds.clear();
+        polled.clear();
+        for (auto& worker : workers)
+        {
+            if (worker.currentJob == StopJob) continue;
+            fds.push_back({ worker.resultFd, POLLIN, 0 });
+            polled.push_back(&worker);
+        }
+
+        if (fds.empty())
+        {
+            // A job handed back by a dead worker may still fit on an idle one.
+            bool dispatched = false;
+            for (auto& worker : workers)
+            {
+                if (worker.currentJob != StopJob) continue;
+                dispatch(worker);
+                dispatched = dispatched || worker.currentJob != StopJob;
+            }
+            if (dispatched) continue;
+
+            // Every worker has died with jobs left over.
+            for (; nextJob < jobCount; ++nextJob)
+            {
+                JobResult result{};
+                result.jobIndex = nextJob;
+                std::snprintf(result.error, sizeof(result.error), "no worker processes left");
+                ++finished;
+                sink(result);
+            }
+            break;
+        }
+
+        if (::poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("poll failed: " + std::string(std::strerror(errno)));
+        }
+
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            if (fds[i].revents == 0) continue;
+            Worker& worker = *polled[i];
+
+            JobResult result{};
+            if (!ReadAll(worker.resultFd, &result, sizeof(result)))
+            {
+                worker.alive = false;
+                failCurrent(worker, "worker exited unexpectedly");
+                continue;
+            }
+
+            result.error[sizeof(result.error) - 1] = '\0';
+            worker.currentJob = StopJob;
+            ++finished;
+            sink(result);
+            dispatch(worker);
+        }
+    }
+
+    for (auto& worker : workers)
+    {
+        const int32_t stop = StopJob;
+        if (worker.alive) WriteAll(worker.commandFd, &stop, sizeof(stop));
+        CloseFd(worker.commandFd);
+        CloseFd(worker.resultFd);
+    }
+    for (auto& worker : workers)
+    {
+        int status = 0;
+        while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+}
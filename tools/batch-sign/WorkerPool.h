@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Outcome of one job, sent from a worker process back to the parent over a pipe.
+// Plain data and smaller than PIPE_BUF so each result arrives in a single atomic write.
+struct JobResult
+{
+    int32_t jobIndex{};
+    int32_t ok{};
+    double loadMs{};
+    double stampMs{};
+    double saveMs{};
+    double totalMs{};
+    uint64_t bytesWritten{};
+    char error[200]{};
+};
+
+// Runs jobs in forked worker processes. PDFium is not thread-safe, so parallelism
+// comes from processes: each worker initializes its own PDFium library and handles
+// one job at a time, and the parent hands out job indices as workers become free
+// (so one slow document does not hold up a fixed share of the batch).
+//
+// The parent never touches PDFium; construct PdfDocumentHandler only inside the
+// runner. POSIX only.
+class WorkerPool
+{
+public:
+    // Called in a worker process for each job index it receives. Must not throw.
+    using JobRunner = std::function<JobResult(int32_t jobIndex)>;
+
+    // Called in the parent as results arrive, in completion order.
+    using ResultSink = std::function<void(JobResult const& result)>;
+
+    explicit WorkerPool(int32_t workerCount);
+
+    // Runs jobs [0, jobCount) and returns once every job has a result. A worker that
+    // dies mid-job yields a failed result for that job; the rest of the batch continues
+    // on the remaining workers.
+    void Run(int32_t jobCount, JobRunner const& runner, ResultSink const& sink);
+
+private:
+    int32_t m_workerCount{};
+};
@@ -0,0 +1,230 @@
+// put-a-signature-batch: stamp a signature onto many PDFs from a manifest, using
+// one PDFium instance per worker process.
+//
+//     put-a-signature-batch <manifest.tsv> [--workers N] [--mode incremental|full]
+//                           [--stamp content|annotation] [--report file]
+//
+// Writes one tab-separated line per job (to --report, or stdout) and a throughput
+// summary to stderr. Exits 0 when every job succeeded, 1 if any failed, 2 on bad usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchManifest.h"
+#include "PdfDocumentHandler.h"
+#include "SignatureImage.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    struct Options
+    {
+        std::string manifestPath;
+        int32_t workers{};
+        PdfSaveMode mode{ PdfSaveMode::Incremental };
+        PdfStampMode stampMode{ PdfStampMode::PageContent };
+        std::string reportPath;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: put-a-signature-batch <manifest.tsv> [--workers N] [--mode incremental|full]\n"
+                     "                             [--stamp content|annotation] [--report file]\n"
+                     "\n"
+                     "Manifest lines: input <TAB> page <TAB> x,y,width,height <TAB> signature <TAB> output\n"
+                     "  page is 1-based; the rect is in PDF points from the bottom-left corner;\n"
+                     "  signature is a binary PAM/PPM/PGM image. '#' starts a comment line.\n";
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--workers" && hasValue)
+            {
+                options.workers = std::atoi(argv[++i]);
+                if (options.workers < 1) return false;
+            }
+            else if (arg == "--mode" && hasValue)
+            {
+                const std::string mode = argv[++i];
+                if (mode == "incremental") options.mode = PdfSaveMode::Incremental;
+                else if (mode == "full") options.mode = PdfSaveMode::FullRewrite;
+                else return false;
+            }
+            else if (arg == "--stamp" && hasValue)
+            {
+                const std::string stamp = argv[++i];
+                if (stamp == "content") options.stampMode = PdfStampMode::PageContent;
+                else if (stamp == "annotation") options.stampMode = PdfStampMode::Annotation;
+                else return false;
+            }
+            else if (arg == "--report" && hasValue)
+            {
+                options.reportPath = argv[++i];
+            }
+            else if (arg.rfind("--", 0) != 0 && options.manifestPath.empty())
+            {
+                options.manifestPath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (options.workers == 0)
+        {
+            options.workers = static_cast<int32_t>((std::max)(1u, std::thread::hardware_concurrency()));
+        }
+        return !options.manifestPath.empty();
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    }
+
+    std::wstring Widen(std::string const& path)
+    {
+        return std::filesystem::path(path).wstring();
+    }
+
+    // Runs inside a worker process. Signatures are usually shared by many jobs, so each
+    // worker decodes every distinct image once.
+    JobResult RunJob(BatchJob const& job, Options const& options, std::map<std::string, PixelBuffer>& signatures)
+    {
+        JobResult result{};
+        const auto started = std::chrono::steady_clock::now();
+        try
+        {
+            auto signature = signatures.find(job.signature);
+            if (signature == signatures.end())
+            {
+                signature = signatures.emplace(job.signature, LoadSignatureImage(job.signature)).first;
+            }
+
+            PdfDocumentHandler pdf{};
+            pdf.SetStampMode(options.stampMode);
+            auto phase = std::chrono::steady_clock::now();
+            pdf.LoadFromPath(Widen(job.input));
+            result.loadMs = MillisecondsSince(phase);
+
+            phase = std::chrono::steady_clock::now();
+            // Including writing it into the page (content or annotation), which SaveAs would
+            // otherwise do.
+            pdf.StampSignaturePixels(job.pageIndex, signature->second.View(), job.rect);
+            pdf.CommitStamps();
+            pdf.FlushPageContent();
+            result.stampMs = MillisecondsSince(phase);
+
+            phase = std::chrono::steady_clock::now();
+            const PdfSaveStats saved = pdf.SaveAs(Widen(job.output), options.mode);
+            result.saveMs = MillisecondsSince(phase);
+            result.bytesWritten = saved.bytesWritten;
+            result.ok = 1;
+        }
+        catch (std::exception const& ex)
+        {
+            std::snprintf(result.error, sizeof(result.error), "%s", ex.what());
+        }
+        catch (...)
+        {
+            std::snprintf(result.error, sizeof(result.error), "unknown error");
+        }
+        result.totalMs = MillisecondsSince(started);
+        return result;
+    }
+
+    // Tabs and newlines would break the report's columns.
+    std::string ReportField(char const* text)
+    {
+        std::string field = text;
+        std::replace_if(field.begin(), field.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+        return field;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options{};
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<BatchJob> jobs{};
+    try
+    {
+        jobs = LoadBatchManifest(options.manifestPath);
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 2;
+    }
+
+    std::ofstream reportFile{};
+    if (!options.reportPath.empty())
+    {
+        reportFile.open(options.reportPath, std::ios::trunc);
+        if (!reportFile)
+        {
+            std::cerr << "Cannot write report: " << options.reportPath << "\n";
+            return 2;
+        }
+    }
+    std::ostream& report = options.reportPath.empty() ? std::cout : reportFile;
+    report << "job\tstatus\tload_ms\tstamp_ms\tsave_ms\ttotal_ms\tbytes_written\tinput\toutput\terror\n";
+
+    std::map<std::string, PixelBuffer> signatures{};
+    auto runner = [&](int32_t jobIndex)
+    {
+        return RunJob(jobs[static_cast<size_t>(jobIndex)], options, signatures);
+    };
+
+    int32_t failures = 0;
+    auto sink = [&](JobResult const& result)
+    {
+        BatchJob const& job = jobs[static_cast<size_t>(result.jobIndex)];
+        if (!result.ok) ++failures;
+
+        char timings[128]{};
+        std::snprintf(timings, sizeof(timings), "%.2f\t%.2f\t%.2f\t%.2f", result.loadMs, result.stampMs, result.saveMs, result.totalMs);
+        report << (result.jobIndex + 1) << '\t' << (result.ok ? "ok" : "failed") << '\t' << timings << '\t'
+               << result.bytesWritten << '\t' << job.input << '\t' << job.output << '\t' << ReportField(result.error) << '\n';
+    };
+
+    const auto started = std::chrono::steady_clock::now();
+    try
+    {
+        WorkerPool pool(options.workers);
+        pool.Run(static_cast<int32_t>(jobs.size()), runner, sink);
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    const double wallSeconds = MillisecondsSince(started) / 1000.0;
+    report.flush();
+
+    const int32_t workers = (std::min)(options.workers, static_cast<int32_t>(jobs.size()));
+    std::fprintf(stderr, "%zu documents, %d failed, %.2f s wall, %.1f docs/s, %d workers\n",
+        jobs.size(), failures, wallSeconds, wallSeconds > 0 ? static_cast<double>(jobs.size()) / wallSeconds : 0.0, workers);
+
+    return failures == 0 ? 0 : 1;
+}
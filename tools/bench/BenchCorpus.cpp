@@ -0,0 +1,312 @@
+#include "BenchCorpus.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr double PageWidth = 612.0;  // US Letter, points
+    constexpr double PageHeight = 792.0;
+
+    // Scans are 100 dpi gray: ~0.9 MB per page.
+    constexpr int32_t ScanWidth = 850;
+    constexpr int32_t ScanHeight = 1100;
+
+    constexpr int32_t TextLinesPerPage = 60;
+    constexpr int32_t VectorPathsPerPage = 400;
+
+    char const* KindName(CorpusKind kind)
+    {
+        switch (kind)
+        {
+        case CorpusKind::Text: return "text";
+        case CorpusKind::Vector: return "vector";
+        case CorpusKind::Scan: return "scan";
+        }
+        return "?";
+    }
+
+    // Small deterministic generator so corpora are identical across runs and machines.
+    class Lcg
+    {
+    public:
+        explicit Lcg(uint32_t seed) : m_state(seed * 2654435761u + 1u) {}
+
+        uint32_t Next() noexcept
+        {
+            m_state = m_state * 1664525u + 1013904223u;
+            return m_state >> 8;
+        }
+
+        double Uniform(double lo, double hi) noexcept
+        {
+            return lo + (hi - lo) * static_cast<double>(Next() & 0xFFFF) / 65535.0;
+        }
+
+    private:
+        uint32_t m_state;
+    };
+
+    // Writes numbered objects and remembers their offsets for the xref table.
+    class PdfWriter
+    {
+    public:
+        PdfWriter(std::string const& path, int32_t objectCount)
+            : m_out(path, std::ios::binary | std::ios::trunc), m_offsets(static_cast<size_t>(objectCount) + 1, 0)
+        {
+            if (!m_out) throw std::runtime_error("Cannot write corpus file: " + path);
+            Write("%PDF-1.7\n%\xE2\xE3\xCF\xD3\n");
+        }
+
+        void BeginObject(int32_t number)
+        {
+            m_offsets.at(static_cast<size_t>(number)) = m_position;
+            Write(std::to_string(number) + " 0 obj\n");
+        }
+
+        void EndObject() { Write("\nendobj\n"); }
+
+        // Stream object whose dictionary is `dict` minus the closing ">>".
+        void StreamObject(int32_t number, std::string const& dict, std::string const& data)
+        {
+            BeginObject(number);
+            Write(dict + " /Length " + std::to_string(data.size()) + " >>\nstream\n");
+            Write(data);
+            Write("\nendstream");
+            EndObject();
+        }
+
+        void Write(std::string const& text)
+        {
+            m_out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            m_position += text.size();
+        }
+
+        void Finish(int32_t rootObject)
+        {
+            const uint64_t xref = m_position;
+            Write("xref\n0 " + std::to_string(m_offsets.size()) + "\n0000000000 65535 f \n");
+            char entry[32]{};
+            for (size_t i = 1; i < m_offsets.size(); ++i)
+            {
+                std::snprintf(entry, sizeof(entry), "%010llu 00000 n \n", static_cast<unsigned long long>(m_offsets[i]));
+                Write(entry);
+            }
+            Write("trailer\n<< /Size " + std::to_string(m_offsets.size()) + " /Root " + std::to_string(rootObject) +
+                " 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n");
+
+            m_out.flush();
+            if (!m_out) throw std::runtime_error("Failed writing corpus file");
+        }
+
+    private:
+        std::ofstream m_out;
+        std::vector<uint64_t> m_offsets;
+        uint64_t m_position{};
+    };
+
+    std::string Number(double value)
+    {
+        char text[32]{};
+        std::snprintf(text, sizeof(text), "%.2f", value);
+        return text;
+    }
+
+    std::string TextContent(Lcg& rng)
+    {
+        static char const* const words[] = {
+            "signature", "agreement", "party", "hereby", "page", "document", "the", "of", "and", "to",
+            "shall", "terms", "conditions", "effective", "date", "witness", "whereof", "executed", "by", "in",
+        };
+        constexpr size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+        std::string content = "BT /F1 10 Tf 12 TL 54 750 Td\n";
+        for (int32_t line = 0; line < TextLinesPerPage; ++line)
+        {
+            std::string text{};
+            while (text.size() < 90)
+            {
+                if (!text.empty()) text += ' ';
+                text += words[rng.Next() % wordCount];
+            }
+            content += "(" + text + ") '\n";
+        }
+        content += "ET";
+        return content;
+    }
+
+    std::string VectorContent(Lcg& rng)
+    {
+        std::string content = "1 J 1 j\n";
+        for (int32_t path = 0; path < VectorPathsPerPage; ++path)
+        {
+            content += Number(rng.Uniform(0, 1)) + " " + Number(rng.Uniform(0, 1)) + " " + Number(rng.Uniform(0, 1)) + " RG ";
+            content += Number(rng.Uniform(0.2, 2.0)) + " w\n";
+
+            double x = rng.Uniform(20, PageWidth - 20);
+            double y = rng.Uniform(20, PageHeight - 20);
+            content += Number(x) + " " + Number(y) + " m\n";
+            for (int32_t segment = 0; segment < 6; ++segment)
+            {
+                const double x1 = x + rng.Uniform(-30, 30), y1 = y + rng.Uniform(-30, 30);
+                const double x2 = x + rng.Uniform(-30, 30), y2 = y + rng.Uniform(-30, 30);
+                x += rng.Uniform(-40, 40);
+                y += rng.Uniform(-40, 40);
+                content += (segment % 2 == 0)
+                    ? Number(x1) + " " + Number(y1) + " " + Number(x2) + " " + Number(y2) + " " + Number(x) + " " + Number(y) + " c\n"
+                    : Number(x) + " " + Number(y) + " l\n";
+            }
+            content += "S\n";
+
+            if (path % 8 == 0)
+            {
+                content += Number(rng.Uniform(0, 1)) + " " + Number(rng.Uniform(0, 1)) + " " + Number(rng.Uniform(0, 1)) + " rg ";
+                content += Number(rng.Uniform(0, PageWidth)) + " " + Number(rng.Uniform(0, PageHeight)) + " " +
+                    Number(rng.Uniform(5, 60)) + " " + Number(rng.Uniform(5, 60)) + " re f\n";
+            }
+        }
+        return content;
+    }
+
+    // Paper-coloured noise with dark bars where text lines would be.
+    std::string ScanImage(Lcg& rng)
+    {
+        std::string pixels(static_cast<size_t>(ScanWidth) * ScanHeight, '\0');
+        for (int32_t y = 0; y < ScanHeight; ++y)
+        {
+            const bool textRow = y > 80 && y < ScanHeight - 80 && (y % 24) < 9;
+            int32_t wordEnd = 0;
+            bool inWord = false;
+            for (int32_t x = 0; x < ScanWidth; ++x)
+            {
+                if (x >= wordEnd)
+                {
+                    inWord = !inWord;
+                    wordEnd = x + static_cast<int32_t>(inWord ? 10 + rng.Next() % 50 : 4 + rng.Next() % 8);
+                }
+                const bool ink = textRow && inWord && x > 70 && x < ScanWidth - 70;
+                const uint32_t noise = rng.Next() & 0x0F;
+                pixels[static_cast<size_t>(y) * ScanWidth + x] = static_cast<char>(ink ? 30 + noise : 235 + noise);
+            }
+        }
+        return pixels;
+    }
+
+    void WriteCorpus(CorpusSpec const& spec, std::string const& path)
+    {
+        const bool scan = spec.kind == CorpusKind::Scan;
+        const int32_t objectsPerPage = scan ? 3 : 2;
+        constexpr int32_t catalog = 1, pages = 2, font = 3, firstPage = 4;
+
+        PdfWriter pdf(path, firstPage - 1 + spec.pages * objectsPerPage);
+
+        pdf.BeginObject(catalog);
+        pdf.Write("<< /Type /Catalog /Pages 2 0 R >>");
+        pdf.EndObject();
+
+        pdf.BeginObject(pages);
+        pdf.Write("<< /Type /Pages /Count " + std::to_string(spec.pages) + " /Kids [");
+        for (int32_t i = 0; i < spec.pages; ++i)
+        {
+            pdf.Write(std::to_string(firstPage + i * objectsPerPage) + " 0 R ");
+        }
+        pdf.Write("] >>");
+        pdf.EndObject();
+
+        pdf.BeginObject(font);
+        pdf.Write("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>");
+        pdf.EndObject();
+
+        for (int32_t i = 0; i < spec.pages; ++i)
+        {
+            Lcg rng(static_cast<uint32_t>(i) + 1);
+            const int32_t page = firstPage + i * objectsPerPage;
+            const int32_t content = page + 1;
+            const int32_t image = page + 2;
+
+            pdf.BeginObject(page);
+            pdf.Write("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + Number(PageWidth) + " " + Number(PageHeight) +
+                "] /Contents " + std::to_string(content) + " 0 R /Resources << /Font << /F1 3 0 R >>");
+            if (scan) pdf.Write(" /XObject << /Im0 " + std::to_string(image) + " 0 R >>");
+            pdf.Write(" >> >>");
+            pdf.EndObject();
+
+            switch (spec.kind)
+            {
+            case CorpusKind::Text:
+                pdf.StreamObject(content, "<<", TextContent(rng));
+                break;
+            case CorpusKind::Vector:
+                pdf.StreamObject(content, "<<", VectorContent(rng));
+                break;
+            case CorpusKind::Scan:
+                pdf.StreamObject(content, "<<", "q " + Number(PageWidth) + " 0 0 " + Number(PageHeight) + " 0 0 cm /Im0 Do Q");
+                pdf.StreamObject(image, "<< /Type /XObject /Subtype /Image /Width " + std::to_string(ScanWidth) +
+                    " /Height " + std::to_string(ScanHeight) + " /ColorSpace /DeviceGray /BitsPerComponent 8", ScanImage(rng));
+                break;
+            }
+        }
+
+        pdf.Finish(catalog);
+    }
+}
+
+std::string CorpusSpec::Name() const
+{
+    return std::string(KindName(kind)) + "-" + std::to_string(pages);
+}
+
+CorpusSpec ParseCorpusSpec(std::string const& name)
+{
+    const size_t dash = name.find('-');
+    if (dash == std::string::npos) throw std::invalid_argument("Corpus must look like text-100: " + name);
+
+    CorpusSpec spec{};
+    const std::string kind = name.substr(0, dash);
+    if (kind == "text") spec.kind = CorpusKind::Text;
+    else if (kind == "vector") spec.kind = CorpusKind::Vector;
+    else if (kind == "scan") spec.kind = CorpusKind::Scan;
+    else throw std::invalid_argument("Unknown corpus kind (text, vector, scan): " + kind);
+
+    const std::string pages = name.substr(dash + 1);
+    size_t parsed = 0;
+    try
+    {
+        spec.pages = std::stoi(pages, &parsed);
+    }
+    catch (...)
+    {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != pages.size() || spec.pages < 1)
+    {
+        throw std::invalid_argument("Corpus page count must be a positive integer: " + name);
+    }
+    return spec;
+}
+
+std::vector<CorpusSpec> DefaultCorpora()
+{
+    return {
+        { CorpusKind::Text, 1 }, { CorpusKind::Text, 100 }, { CorpusKind::Text, 5000 },
+        { CorpusKind::Vector, 1 }, { CorpusKind::Vector, 100 }, { CorpusKind::Vector, 5000 },
+        { CorpusKind::Scan, 1 }, { CorpusKind::Scan, 100 },
+    };
+}
+
+std::string EnsureCorpusFile(CorpusSpec const& spec, std::string const& directory)
+{
+    namespace fs = std::filesystem;
+
+    fs::create_directories(directory);
+    const fs::path path = fs::path(directory) / (spec.Name() + ".pdf");
+    if (fs::exists(path)) return path.string();
+
+    // Write under a temporary name so an interrupted run never leaves a truncated corpus behind.
+    const fs::path partial = fs::path(path).concat(".partial");
+    WriteCorpus(spec, partial.string());
+    fs::rename(partial, path);
+    return path.string();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic PDFs for the benchmarks, written directly (no PDFium) so every run
+// measures the same bytes.
+enum class CorpusKind
+{
+    Text,   // dense Helvetica text, ~60 lines per page
+    Vector, // a few thousand stroked and filled path segments per page
+    Scan,   // one full-page 8-bit gray image per page, uncompressed
+};
+
+struct CorpusSpec
+{
+    CorpusKind kind{ CorpusKind::Text };
+    int32_t pages{ 1 };
+
+    // "text-100", "vector-1", "scan-5000", ...
+    std::string Name() const;
+};
+
+// Parses "<text|vector|scan>-<pages>"; throws std::invalid_argument on anything else.
+CorpusSpec ParseCorpusSpec(std::string const& name);
+
+// text, vector and scan at 1 and 100 pages, plus text and vector at 5,000 pages.
+// scan-5000 (several GB) is only generated when asked for explicitly.
+std::vector<CorpusSpec> DefaultCorpora();
+
+// Writes the corpus to <directory>/<name>.pdf unless that file already exists,
+// and returns its path. Generation is deterministic.
+std::string EnsureCorpusFile(CorpusSpec const& spec, std::string const& directory);
@@ -0,0 +1,364 @@
+#include "BenchReport.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    std::string Quote(std::string const& text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8]{};
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    quoted += escaped;
+                }
+                else
+                {
+                    quoted += c;
+                }
+            }
+        }
+        return quoted + "\"";
+    }
+
+    std::string Fixed(double value)
+    {
+        char text[32]{};
+        std::snprintf(text, sizeof(text), "%.4f", std::isfinite(value) ? value : 0.0);
+        return text;
+    }
+
+    // Just enough JSON to read our own reports back.
+    struct JsonValue
+    {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type type{ Type::Null };
+        bool boolean{};
+        double number{};
+        std::string string{};
+        std::vector<JsonValue> array{};
+        std::vector<std::pair<std::string, JsonValue>> object{};
+
+        JsonValue const* Find(std::string const& key) const
+        {
+            for (auto const& [name, value] : object)
+            {
+                if (name == key) return &value;
+            }
+            return nullptr;
+        }
+
+        double NumberOr(std::string const& key, double fallback) const
+        {
+            JsonValue const* value = Find(key);
+            return value && value->type == Type::Number ? value->number : fallback;
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(std::string const& text, std::string const& source) : m_text(text), m_source(source) {}
+
+        JsonValue ParseDocument()
+        {
+            JsonValue value = ParseValue();
+            SkipSpace();
+            if (m_pos != m_text.size()) Fail("trailing characters");
+            return value;
+        }
+
+    private:
+        [[noreturn]] void Fail(char const* what) const
+        {
+            throw std::runtime_error(m_source + ": offset " + std::to_string(m_pos) + ": " + what);
+        }
+
+        void SkipSpace()
+        {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r' || m_text[m_pos] == '\t'))
+            {
+                ++m_pos;
+            }
+        }
+
+        bool Consume(char c)
+        {
+            SkipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        void Expect(char c)
+        {
+            if (!Consume(c)) Fail("unexpected character");
+        }
+
+        bool ConsumeWord(char const* word)
+        {
+            const std::string w = word;
+            if (m_text.compare(m_pos, w.size(), w) != 0) return false;
+            m_pos += w.size();
+            return true;
+        }
+
+        JsonValue ParseValue()
+        {
+            if (++m_depth > 64) Fail("nesting too deep");
+            SkipSpace();
+            if (m_pos >= m_text.size()) Fail("unexpected end of input");
+
+            JsonValue value{};
+            const char c = m_text[m_pos];
+            if (c == '{')
+            {
+                ++m_pos;
+                value.type = JsonValue::Type::Object;
+                if (!Consume('}'))
+                {
+                    do
+                    {
+                        SkipSpace();
+                        std::string key = ParseString();
+                        Expect(':');
+                        value.object.emplace_back(std::move(key), ParseValue());
+                    } while (Consume(','));
+                    Expect('}');
+                }
+            }
+            else if (c == '[')
+            {
+                ++m_pos;
+                value.type = JsonValue::Type::Array;
+                if (!Consume(']'))
+                {
+                    do
+                    {
+                        value.array.push_back(ParseValue());
+                    } while (Consume(','));
+                    Expect(']');
+                }
+            }
+            else if (c == '"')
+            {
+                value.type = JsonValue::Type::String;
+                value.string = ParseString();
+            }
+            else if (ConsumeWord("true") || ConsumeWord("false"))
+            {
+                value.type = JsonValue::Type::Bool;
+                value.boolean = c == 't';
+            }
+            else if (ConsumeWord("null"))
+            {
+                value.type = JsonValue::Type::Null;
+            }
+            else
+            {
+                char const* begin = m_text.c_str() + m_pos;
+                char* end = nullptr;
+                value.type = JsonValue::Type::Number;
+                value.number = std::strtod(begin, &end);
+                if (end == begin) Fail("expected a value");
+                m_pos += static_cast<size_t>(end - begin);
+            }
+            --m_depth;
+            return value;
+        }
+
+        // Escapes other than \uXXXX are decoded; \uXXXX is kept only for ASCII.
+        std::string ParseString()
+        {
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') Fail("expected a string");
+            ++m_pos;
+
+            std::string result{};
+            while (m_pos < m_text.size() && m_text[m_pos] != '"')
+            {
+                char c = m_text[m_pos++];
+                if (c == '\\')
+                {
+                    if (m_pos >= m_text.size()) break;
+                    c = m_text[m_pos++];
+                    switch (c)
+                    {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u':
+                        if (m_pos + 4 > m_text.size()) Fail("bad escape");
+                        c = static_cast<char>(std::strtoul(m_text.substr(m_pos, 4).c_str(), nullptr, 16) & 0x7F);
+                        m_pos += 4;
+                        break;
+                    default: break; // \" \\ \/
+                    }
+                }
+                result += c;
+            }
+            if (m_pos >= m_text.size()) Fail("unterminated string");
+            ++m_pos;
+            return result;
+        }
+
+        std::string const& m_text;
+        std::string const& m_source;
+        size_t m_pos{};
+        int32_t m_depth{};
+    };
+}
+
+std::vector<BenchComparison> CompareBenchReports(BenchReport const& baseline, BenchReport const& current,
+    RegressionThresholds const& thresholds)
+{
+    std::map<std::string, double> baselineMs{};
+    for (auto const& result : baseline.benchmarks) baselineMs[result.name] = result.ms.p50;
+    std::map<std::string, uint64_t> baselineRss(baseline.peakRssKb.begin(), baseline.peakRssKb.end());
+
+    std::vector<BenchComparison> comparison{};
+    for (auto const& result : current.benchmarks)
+    {
+        auto it = baselineMs.find(result.name);
+        if (it == baselineMs.end()) continue;
+
+        BenchComparison entry{ result.name, "p50_ms", it->second, result.ms.p50, false };
+        entry.regressed = entry.current > entry.baseline * (1.0 + thresholds.fraction) &&
+            entry.current - entry.baseline >= thresholds.minDeltaMs;
+        comparison.push_back(entry);
+    }
+
+    for (auto const& [name, kb] : current.peakRssKb)
+    {
+        auto it = baselineRss.find(name);
+        if (it == baselineRss.end()) continue;
+
+        BenchComparison entry{ name, "peak_rss_kb", static_cast<double>(it->second), static_cast<double>(kb), false };
+        entry.regressed = entry.current > entry.baseline * (1.0 + thresholds.fraction) &&
+            entry.current - entry.baseline >= thresholds.minDeltaRssKb;
+        comparison.push_back(entry);
+    }
+    return comparison;
+}
+
+void WriteBenchReportJson(std::ostream& out, BenchReport const& report, std::vector<BenchComparison> const* comparison)
+{
+    out << "{\n  \"version\": 1,\n  \"host\": {";
+    for (size_t i = 0; i < report.host.size(); ++i)
+    {
+        out << (i ? ", " : "") << Quote(report.host[i].first) << ": " << Quote(report.host[i].second);
+    }
+    out << "},\n  \"iterations\": " << report.iterations << ",\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < report.benchmarks.size(); ++i)
+    {
+        BenchResult const& result = report.benchmarks[i];
+        out << (i ? "," : "") << "\n    { \"name\": " << Quote(result.name)
+            << ", \"samples\": " << result.ms.count
+            << ", \"min_ms\": " << Fixed(result.ms.min)
+            << ", \"p50_ms\": " << Fixed(result.ms.p50)
+            << ", \"p90_ms\": " << Fixed(result.ms.p90)
+            << ", \"p99_ms\": " << Fixed(result.ms.p99)
+            << ", \"max_ms\": " << Fixed(result.ms.max)
+            << ", \"mean_ms\": " << Fixed(result.ms.mean) << " }";
+    }
+    out << "\n  ],\n  \"peak_rss_kb\": {";
+
+    for (size_t i = 0; i < report.peakRssKb.size(); ++i)
+    {
+        out << (i ? "," : "") << "\n    " << Quote(report.peakRssKb[i].first) << ": " << report.peakRssKb[i].second;
+    }
+    out << "\n  }";
+
+    if (comparison)
+    {
+        out << ",\n  \"comparison\": [";
+        for (size_t i = 0; i < comparison->size(); ++i)
+        {
+            BenchComparison const& entry = (*comparison)[i];
+            out << (i ? "," : "") << "\n    { \"name\": " << Quote(entry.name)
+                << ", \"metric\": " << Quote(entry.metric)
+                << ", \"baseline\": " << Fixed(entry.baseline)
+                << ", \"current\": " << Fixed(entry.current)
+                << ", \"ratio\": " << Fixed(entry.Ratio())
+                << ", \"regressed\": " << (entry.regressed ? "true" : "false") << " }";
+        }
+        out << "\n  ]";
+    }
+    out << "\n}\n";
+}
+
+BenchReport ReadBenchReportJson(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot read baseline: " + path);
+    std::stringstream buffer{};
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    const JsonValue root = JsonParser(text, path).ParseDocument();
+    if (root.type != JsonValue::Type::Object) throw std::runtime_error(path + ": not a benchmark report");
+
+    BenchReport report{};
+    report.iterations = static_cast<int32_t>(root.NumberOr("iterations", 0));
+
+    if (JsonValue const* host = root.Find("host"))
+    {
+        for (auto const& [key, value] : host->object)
+        {
+            if (value.type == JsonValue::Type::String) report.host.emplace_back(key, value.string);
+        }
+    }
+
+    if (JsonValue const* benchmarks = root.Find("benchmarks"))
+    {
+        for (JsonValue const& entry : benchmarks->array)
+        {
+            JsonValue const* name = entry.Find("name");
+            if (!name || name->type != JsonValue::Type::String) continue;
+
+            BenchResult result{};
+            result.name = name->string;
+            result.ms.count = static_cast<size_t>(entry.NumberOr("samples", 0));
+            result.ms.min = entry.NumberOr("min_ms", 0);
+            result.ms.p50 = entry.NumberOr("p50_ms", 0);
+            result.ms.p90 = entry.NumberOr("p90_ms", 0);
+            result.ms.p99 = entry.NumberOr("p99_ms", 0);
+            result.ms.max = entry.NumberOr("max_ms", 0);
+            result.ms.mean = entry.NumberOr("mean_ms", 0);
+            report.benchmarks.push_back(std::move(result));
+        }
+    }
+
+    if (JsonValue const* rss = root.Find("peak_rss_kb"))
+    {
+        for (auto const& [key, value] : rss->object)
+        {
+            if (value.type == JsonValue::Type::Number) report.peakRssKb.emplace_back(key, static_cast<uint64_t>(value.number));
+        }
+    }
+    return report;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchStats.h"
+
+// One timed operation, e.g. "text-100/render/scale-2". Samples are milliseconds.
+struct BenchResult
+{
+    std::string name;
+    SampleSummary ms{};
+};
+
+struct BenchReport
+{
+    std::vector<std::pair<std::string, std::string>> host{}; // free-form: kernel level, cpus, ...
+    int32_t iterations{};
+    std::vector<BenchResult> benchmarks{};
+    std::vector<std::pair<std::string, uint64_t>> peakRssKb{}; // per corpus, plus "process"
+};
+
+// A benchmark or peak RSS present in both reports. Timings are compared by p50.
+struct BenchComparison
+{
+    std::string name;
+    std::string metric; // "p50_ms" or "peak_rss_kb"
+    double baseline{};
+    double current{};
+    bool regressed{};
+
+    double Ratio() const noexcept { return baseline > 0 ? current / baseline : 1.0; }
+};
+
+struct RegressionThresholds
+{
+    double fraction{ 0.10 };        // slower / bigger than baseline by more than this...
+    double minDeltaMs{ 0.05 };      // ...and by at least this much (sub-timer-noise changes are ignored)
+    double minDeltaRssKb{ 4096.0 };
+};
+
+std::vector<BenchComparison> CompareBenchReports(BenchReport const& baseline, BenchReport const& current,
+    RegressionThresholds const& thresholds);
+
+// JSON layout:
+//   { "version": 1, "host": {...}, "iterations": N,
+//     "benchmarks": [ { "name", "samples", "min_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms", "mean_ms" } ],
+//     "peak_rss_kb": { "<corpus>": kb, "process": kb },
+//     "comparison": [ { "name", "metric", "baseline", "current", "ratio", "regressed" } ] }
+// "comparison" is only written when a baseline was given.
+void WriteBenchReportJson(std::ostream& out, BenchReport const& report, std::vector<BenchComparison> const* comparison);
+
+// Reads a report written by WriteBenchReportJson (the "comparison" part is ignored).
+// Throws std::runtime_error with the path and byte offset on malformed input.
+BenchReport ReadBenchReportJson(std::string const& path);
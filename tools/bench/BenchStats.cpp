@@ -0,0 +1,70 @@
+#include "BenchStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+#include <sys/resource.h>
+
+namespace
+{
+    double Percentile(std::vector<double> const& sorted, double fraction)
+    {
+        const double rank = fraction * static_cast<double>(sorted.size() - 1);
+        const size_t lower = static_cast<size_t>(rank);
+        const size_t upper = (std::min)(lower + 1, sorted.size() - 1);
+        const double weight = rank - static_cast<double>(lower);
+        return sorted[lower] + (sorted[upper] - sorted[lower]) * weight;
+    }
+}
+
+SampleSummary Summarize(std::vector<double> samples)
+{
+    SampleSummary summary{};
+    if (samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+    summary.count = samples.size();
+    summary.min = samples.front();
+    summary.max = samples.back();
+    summary.p50 = Percentile(samples, 0.50);
+    summary.p90 = Percentile(samples, 0.90);
+    summary.p99 = Percentile(samples, 0.99);
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    return summary;
+}
+
+bool ResetPeakRss() noexcept
+{
+    // "5" resets the peak RSS counter of the writing process.
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (!file) return false;
+    const bool ok = std::fputs("5", file) >= 0;
+    return std::fclose(file) == 0 && ok;
+}
+
+uint64_t PeakRssKb() noexcept
+{
+    if (FILE* file = std::fopen("/proc/self/status", "r"))
+    {
+        char line[256]{};
+        unsigned long long kb = 0;
+        bool found = false;
+        while (std::fgets(line, sizeof(line), file))
+        {
+            if (std::strncmp(line, "VmHWM:", 6) == 0)
+            {
+                found = std::sscanf(line + 6, "%llu", &kb) == 1;
+                break;
+            }
+        }
+        std::fclose(file);
+        if (found) return kb;
+    }
+
+    // No procfs: the process-wide peak (KiB on Linux).
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Distribution of one benchmark's samples. Percentiles interpolate linearly
+// between the two nearest ranks.
+struct SampleSummary
+{
+    size_t count{};
+    double min{};
+    double p50{};
+    double p90{};
+    double p99{};
+    double max{};
+    double mean{};
+};
+
+SampleSummary Summarize(std::vector<double> samples);
+
+// Peak resident set size of this process in KiB (VmHWM). ResetPeakRss starts a new
+// high-water mark where the kernel allows it (Linux 4.0+, /proc/self/clear_refs);
+// returns false if it could not, in which case PeakRssKb keeps the process-wide peak.
+bool ResetPeakRss() noexcept;
+uint64_t PeakRssKb() noexcept;
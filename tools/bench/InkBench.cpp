@@ -0,0 +1,313 @@
+#include "InkBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include "SignatureInk.h"
+
+namespace
+{
+    using Point = SignatureInk::Point;
+    using Stroke = std::vector<Point>;
+
+    // Pen samples along a looping stroke, 0.2 to 3 DIPs apart with a little jitter,
+    // like pointer input at varying speed.
+    std::vector<Stroke> MakeTrace(int32_t strokeCount, int32_t samplesPerStroke, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> step(0.2f, 3.0f);
+        std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+
+        std::vector<Stroke> strokes{};
+        for (int32_t s = 0; s < strokeCount; ++s)
+        {
+            Stroke stroke{};
+            float t = 0.0f;
+            for (int32_t i = 0; i < samplesPerStroke; ++i)
+            {
+                t += step(rng) / 40.0f;
+                stroke.push_back({ 30.0f + s * 90.0f + 40.0f * std::sin(t * 0.7f) + 25.0f * std::cos(t * 2.3f) + jitter(rng),
+                    80.0f + 45.0f * std::sin(t * 1.9f) * std::cos(t * 0.5f) + jitter(rng) });
+            }
+            strokes.push_back(std::move(stroke));
+        }
+        return strokes;
+    }
+
+    // Feeds the trace to `ink` and returns the samples it accepted, per stroke.
+    std::vector<Stroke> Capture(SignatureInk& ink, std::vector<Stroke> const& trace)
+    {
+        std::vector<Stroke> accepted{};
+        for (Stroke const& stroke : trace)
+        {
+            ink.BeginStroke(stroke.front());
+            accepted.push_back({ stroke.front() });
+            for (size_t i = 1; i < stroke.size(); ++i)
+            {
+                if (ink.AddPoint(stroke[i])) accepted.back().push_back(stroke[i]);
+            }
+            ink.EndStroke();
+        }
+        return accepted;
+    }
+
+    bool Same(Point a, Point b) noexcept
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    float SegmentDistance(Point p, Point a, Point b) noexcept
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float lengthSquared = dx * dx + dy * dy;
+        float t = lengthSquared > 0.0f ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared : 0.0f;
+        t = (std::min)(1.0f, (std::max)(0.0f, t));
+        return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+    }
+
+    void CheckStrokes(SignatureInk const& ink, std::vector<Stroke> const& accepted, float tolerance,
+        std::string const& label, std::vector<std::string>& failures)
+    {
+        if (ink.StrokeCount() != accepted.size())
+        {
+            failures.push_back(label + ": stroke count differs");
+            return;
+        }
+
+        float minX = accepted.front().front().x, maxX = minX;
+        float minY = accepted.front().front().y, maxY = minY;
+        for (size_t s = 0; s < accepted.size(); ++s)
+        {
+            Stroke const& raw = accepted[s];
+            const SignatureInk::StrokeView kept = ink.Stroke(s);
+            const std::string where = label + ", stroke " + std::to_string(s);
+
+            if (kept.count == 0 || !Same(kept.points[0], raw.front()) || !Same(kept.points[kept.count - 1], raw.back()))
+            {
+                failures.push_back(where + ": end points not kept");
+                continue;
+            }
+
+            // Kept points are accepted samples, in order...
+            std::vector<size_t> keptAt{};
+            for (size_t next = 0; keptAt.size() < kept.count && next < raw.size(); ++next)
+            {
+                if (Same(raw[next], kept.points[keptAt.size()])) keptAt.push_back(next);
+            }
+            if (keptAt.size() != kept.count)
+            {
+                failures.push_back(where + ": kept points are not a subsequence of the samples");
+                continue;
+            }
+
+            // ...and every sample between two of them is within the tolerance of their segment.
+            for (size_t k = 0; k + 1 < keptAt.size(); ++k)
+            {
+                bool within = true;
+                for (size_t i = keptAt[k] + 1; within && i < keptAt[k + 1]; ++i)
+                {
+                    within = SegmentDistance(raw[i], raw[keptAt[k]], raw[keptAt[k + 1]]) <= tolerance + 1e-3f;
+                }
+                if (!within)
+                {
+                    failures.push_back(where + ": a sample is farther than the tolerance from the simplified stroke");
+                    break;
+                }
+            }
+
+            for (Point const& point : raw)
+            {
+                minX = (std::min)(minX, point.x);
+                maxX = (std::max)(maxX, point.x);
+                minY = (std::min)(minY, point.y);
+                maxY = (std::max)(maxY, point.y);
+            }
+        }
+
+        const PdfRect bounds = ink.Bounds();
+        if (bounds.x != minX || bounds.y != minY || std::abs(bounds.x + bounds.width - maxX) > 1e-3
+            || std::abs(bounds.y + bounds.height - maxY) > 1e-3)
+        {
+            failures.push_back(label + ": Bounds differs from the accepted samples");
+        }
+    }
+
+    void CheckSmoothing(SignatureInk const& ink, std::string const& label, std::vector<std::string>& failures)
+    {
+        for (size_t s = 0; s < ink.StrokeCount(); ++s)
+        {
+            std::vector<PdfPoint> points{};
+            for (Point const& point : ink.Stroke(s)) points.push_back({ point.x, point.y });
+
+            std::vector<InkCurve> curves{};
+            SmoothStroke(points.data(), points.size(), curves);
+            bool joined = curves.size() == (points.size() < 2 ? 0 : points.size() - 1);
+            for (size_t i = 0; joined && i < curves.size(); ++i)
+            {
+                joined = curves[i].end.x == points[i + 1].x && curves[i].end.y == points[i + 1].y;
+            }
+            if (!joined) failures.push_back(label + ", stroke " + std::to_string(s) + ": smoothed curves do not join the points");
+        }
+
+        // Collinear points stay on their line.
+        const PdfPoint line[]{ { 0, 0 }, { 1, 2 }, { 3, 6 }, { 4, 8 } };
+        std::vector<InkCurve> curves{};
+        SmoothStroke(line, 4, curves);
+        for (InkCurve const& curve : curves)
+        {
+            if (std::abs(curve.control1.y - 2 * curve.control1.x) > 1e-9 || std::abs(curve.control2.y - 2 * curve.control2.x) > 1e-9)
+            {
+                failures.push_back("SmoothStroke leaves the line through collinear points");
+                break;
+            }
+        }
+    }
+
+    void CheckRoundTrip(SignatureInk const& ink, std::string const& label, std::vector<std::string>& failures)
+    {
+        const std::vector<uint8_t> bytes = ink.Serialize();
+        const SignatureInk copy = SignatureInk::Deserialize(bytes.data(), bytes.size());
+
+        bool same = copy.StrokeCount() == ink.StrokeCount() && copy.PointCount() == ink.PointCount();
+        for (size_t s = 0; same && s < ink.StrokeCount(); ++s)
+        {
+            same = copy.Stroke(s).count == ink.Stroke(s).count
+                && std::memcmp(copy.Stroke(s).points, ink.Stroke(s).points, ink.Stroke(s).count * sizeof(Point)) == 0;
+        }
+        // The copy only has the kept points; the original's box also covers dropped samples.
+        const PdfRect a = ink.Bounds(), b = copy.Bounds();
+        same = same && b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+        if (!same) failures.push_back(label + ": Deserialize(Serialize()) differs");
+    }
+
+    void Patch(std::vector<uint8_t>& bytes, size_t offset, float value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+
+    void CheckRejected(SignatureInk const& ink, std::vector<std::string>& failures)
+    {
+        const std::vector<uint8_t> good = ink.Serialize();
+        constexpr size_t toleranceOffset = 4;
+        constexpr size_t firstPointOffset = 4 + 4 + 4 + 4;
+
+        struct Case
+        {
+            char const* name;
+            std::vector<uint8_t> bytes;
+        };
+        std::vector<Case> cases{};
+        cases.push_back({ "bad magic", good });
+        cases.back().bytes[0] = 'X';
+        cases.push_back({ "truncated", std::vector<uint8_t>(good.begin(), good.end() - 1) });
+        cases.push_back({ "trailing byte", good });
+        cases.back().bytes.push_back(0);
+        cases.push_back({ "NaN tolerance", good });
+        Patch(cases.back().bytes, toleranceOffset, std::numeric_limits<float>::quiet_NaN());
+        cases.push_back({ "negative tolerance", good });
+        Patch(cases.back().bytes, toleranceOffset, -1.0f);
+        cases.push_back({ "infinite coordinate", good });
+        Patch(cases.back().bytes, firstPointOffset, std::numeric_limits<float>::infinity());
+        cases.push_back({ "empty stroke", std::vector<uint8_t>(good.begin(), good.begin() + 8) });
+        const uint32_t one = 1, zero = 0;
+        cases.back().bytes.insert(cases.back().bytes.end(), reinterpret_cast<uint8_t const*>(&one), reinterpret_cast<uint8_t const*>(&one) + 4);
+        cases.back().bytes.insert(cases.back().bytes.end(), reinterpret_cast<uint8_t const*>(&zero), reinterpret_cast<uint8_t const*>(&zero) + 4);
+
+        for (Case const& test : cases)
+        {
+            try
+            {
+                SignatureInk::Deserialize(test.bytes.data(), test.bytes.size());
+                failures.push_back(std::string("Deserialize accepted ") + test.name);
+            }
+            catch (std::runtime_error const&)
+            {
+            }
+        }
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    }
+}
+
+std::vector<std::string> ValidateSignatureInk()
+{
+    std::vector<std::string> failures{};
+    std::mt19937 rng(4242);
+
+    const float tolerances[]{ 0.0f, SignatureInk::DefaultTolerance, 2.0f };
+    const int32_t lengths[]{ 1, 2, 3, 50, 2000 };
+    for (const float tolerance : tolerances)
+    {
+        for (const int32_t length : lengths)
+        {
+            const std::string label = "tolerance " + std::to_string(tolerance) + ", " + std::to_string(length) + " samples";
+            SignatureInk ink(tolerance);
+            const std::vector<Stroke> accepted = Capture(ink, MakeTrace(3, length, rng));
+            try
+            {
+                CheckStrokes(ink, accepted, tolerance, label, failures);
+                CheckSmoothing(ink, label, failures);
+                CheckRoundTrip(ink, label, failures);
+            }
+            catch (std::exception const& ex)
+            {
+                failures.push_back(label + ": " + ex.what());
+            }
+        }
+    }
+
+    SignatureInk ink{};
+    Capture(ink, MakeTrace(2, 20, rng));
+    CheckRejected(ink, failures);
+    return failures;
+}
+
+void BenchSignatureInk(int32_t iterations, std::vector<BenchResult>& results)
+{
+    // A long signature: 6 strokes of 4000 pointer samples each.
+    std::mt19937 rng(9876);
+    const std::vector<Stroke> trace = MakeTrace(6, 4000, rng);
+
+    SignatureInk ink{};
+    std::vector<double> capture{}, smooth{}, serialize{}, deserialize{};
+    for (int32_t i = 0; i < iterations; ++i)
+    {
+        ink.Clear();
+        auto started = std::chrono::steady_clock::now();
+        Capture(ink, trace);
+        capture.push_back(MillisecondsSince(started));
+
+        std::vector<PdfPoint> points{};
+        std::vector<InkCurve> curves{};
+        started = std::chrono::steady_clock::now();
+        for (size_t s = 0; s < ink.StrokeCount(); ++s)
+        {
+            points.clear();
+            for (Point const& point : ink.Stroke(s)) points.push_back({ point.x, point.y });
+            SmoothStroke(points.data(), points.size(), curves);
+        }
+        smooth.push_back(MillisecondsSince(started));
+
+        started = std::chrono::steady_clock::now();
+        const std::vector<uint8_t> bytes = ink.Serialize();
+        serialize.push_back(MillisecondsSince(started));
+
+        started = std::chrono::steady_clock::now();
+        const SignatureInk copy = SignatureInk::Deserialize(bytes.data(), bytes.size());
+        deserialize.push_back(MillisecondsSince(started));
+        if (copy.PointCount() != ink.PointCount()) throw std::runtime_error("ink round trip lost points");
+    }
+
+    results.push_back({ "ink/capture", Summarize(std::move(capture)) });
+    results.push_back({ "ink/smooth", Summarize(std::move(smooth)) });
+    results.push_back({ "ink/serialize", Summarize(std::move(serialize)) });
+    results.push_back({ "ink/deserialize", Summarize(std::move(deserialize)) });
+}
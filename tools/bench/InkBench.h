@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "BenchReport.h"
+
+// Feeds SignatureInk generated pen traces and checks the model: simplified strokes
+// keep their end points and stay within the tolerance of every accepted sample,
+// Bounds covers exactly the accepted samples, SmoothStroke joins consecutive points,
+// Serialize/Deserialize round-trip, and Deserialize rejects malformed data.
+// Returns one line per failure; empty means all checks passed.
+std::vector<std::string> ValidateSignatureInk();
+
+// Times capturing (sampling plus simplification), smoothing and serializing a long
+// signature and appends "ink/<step>" results.
+void BenchSignatureInk(int32_t iterations, std::vector<BenchResult>& results);
@@ -0,0 +1,178 @@
+#include "KernelBench.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#include "PixelKernels.h"
+
+namespace
+{
+    // Kernel output: the dst pixels plus anything the kernel returns separately
+    // (gray plane, scan positions).
+    using KernelRun = void (*)(ConstPixelView src, PixelView dst, std::vector<uint8_t>& extra);
+
+    struct KernelCase
+    {
+        char const* name;
+        KernelRun run;
+    };
+
+    void AppendInt(std::vector<uint8_t>& out, int32_t value)
+    {
+        uint8_t bytes[sizeof(value)]{};
+        std::memcpy(bytes, &value, sizeof(value));
+        out.insert(out.end(), bytes, bytes + sizeof(value));
+    }
+
+    const KernelCase Kernels[] = {
+        { "fill", [](ConstPixelView, PixelView dst, std::vector<uint8_t>&) { FillPixels(dst, 0x80FF4020u); } },
+        { "premultiply", [](ConstPixelView src, PixelView dst, std::vector<uint8_t>&) { PremultiplyAlpha(dst, src); } },
+        { "unpremultiply", [](ConstPixelView src, PixelView dst, std::vector<uint8_t>&) { UnpremultiplyAlpha(dst, src); } },
+        { "composite-over", [](ConstPixelView src, PixelView dst, std::vector<uint8_t>&) { CompositeOver(dst, src); } },
+        { "bgra-to-gray", [](ConstPixelView src, PixelView, std::vector<uint8_t>& extra)
+            {
+                const int32_t stride = src.width + 3;
+                extra.assign(static_cast<size_t>(stride) * static_cast<size_t>(src.height), 0xCD);
+                BgraToGray(extra.data(), stride, src);
+            } },
+        { "find-alpha", [](ConstPixelView src, PixelView, std::vector<uint8_t>& extra)
+            {
+                for (int32_t y = 0; y < src.height; ++y)
+                {
+                    uint8_t const* row = src.Row(y);
+                    const int32_t w = src.width;
+                    AppendInt(extra, FindAlphaForward(row, 0, w));
+                    AppendInt(extra, FindAlphaBackward(row, 0, w));
+                    AppendInt(extra, FindAlphaForward(row, w / 3, w));
+                    AppendInt(extra, FindAlphaBackward(row, 0, w - w / 3));
+                }
+            } },
+    };
+
+    std::vector<PixelKernelLevel> SupportedLevels()
+    {
+        std::vector<PixelKernelLevel> levels{};
+        for (int32_t level = 0; level <= static_cast<int32_t>(DetectedPixelKernelLevel()); ++level)
+        {
+            levels.push_back(static_cast<PixelKernelLevel>(level));
+        }
+        return levels;
+    }
+
+    // Pixels and padding are random. Alpha favours 0 and 255, and every third row is
+    // transparent apart from at most one pixel so the alpha scans have work to do.
+    void Randomize(std::vector<uint8_t>& bytes, int32_t width, int32_t height, int32_t stride, std::mt19937& rng)
+    {
+        for (auto& byte : bytes) byte = static_cast<uint8_t>(rng());
+        for (int32_t y = 0; y < height; ++y)
+        {
+            uint8_t* row = bytes.data() + static_cast<size_t>(y) * static_cast<size_t>(stride);
+            const bool sparse = y % 3 == 0;
+            const int32_t lone = static_cast<int32_t>(rng() % static_cast<uint32_t>(width * 2)); // past the end half the time
+            for (int32_t x = 0; x < width; ++x)
+            {
+                uint8_t& alpha = row[x * 4 + 3];
+                if (sparse) alpha = x == lone ? static_cast<uint8_t>(1 + rng() % 255) : 0;
+                else if (rng() % 4 == 0) alpha = 0;
+                else if (rng() % 3 == 0) alpha = 255;
+            }
+        }
+    }
+
+    struct KernelOutput
+    {
+        std::vector<uint8_t> dst;
+        std::vector<uint8_t> extra;
+    };
+
+    KernelOutput RunKernel(KernelCase const& kernel, std::vector<uint8_t> const& src, std::vector<uint8_t> const& background,
+        int32_t width, int32_t height, int32_t stride)
+    {
+        KernelOutput output{ background, {} };
+        kernel.run({ src.data(), width, height, stride }, { output.dst.data(), width, height, stride }, output.extra);
+        return output;
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    }
+}
+
+std::vector<std::string> ValidatePixelKernels()
+{
+    const PixelKernelLevel original = ActivePixelKernelLevel();
+    std::vector<std::string> mismatches{};
+    std::mt19937 rng(12345);
+
+    std::vector<int32_t> widths{};
+    for (int32_t width = 1; width <= 67; ++width) widths.push_back(width);
+    widths.push_back(255);
+    widths.push_back(1021);
+
+    for (const int32_t width : widths)
+    {
+        constexpr int32_t height = 7;
+        const int32_t stride = width * 4 + 12; // padding must come through untouched
+        std::vector<uint8_t> src(static_cast<size_t>(stride) * height);
+        std::vector<uint8_t> background(src.size());
+        Randomize(src, width, height, stride, rng);
+        Randomize(background, width, height, stride, rng);
+
+        for (KernelCase const& kernel : Kernels)
+        {
+            SetPixelKernelLevel(PixelKernelLevel::Scalar);
+            const KernelOutput expected = RunKernel(kernel, src, background, width, height, stride);
+
+            for (const PixelKernelLevel level : SupportedLevels())
+            {
+                if (level == PixelKernelLevel::Scalar) continue;
+                SetPixelKernelLevel(level);
+                const KernelOutput actual = RunKernel(kernel, src, background, width, height, stride);
+                if (actual.dst != expected.dst || actual.extra != expected.extra)
+                {
+                    mismatches.push_back(std::string(kernel.name) + " differs from scalar at " +
+                        PixelKernelLevelName(level) + ", width " + std::to_string(width));
+                }
+            }
+        }
+    }
+
+    SetPixelKernelLevel(original);
+    return mismatches;
+}
+
+void BenchPixelKernels(int32_t iterations, std::vector<BenchResult>& results)
+{
+    const PixelKernelLevel original = ActivePixelKernelLevel();
+    constexpr int32_t size = 1024;
+    constexpr int32_t stride = size * 4;
+
+    std::mt19937 rng(6789);
+    std::vector<uint8_t> src(static_cast<size_t>(stride) * size);
+    std::vector<uint8_t> dst(src.size());
+    Randomize(src, size, size, stride, rng);
+    std::vector<uint8_t> extra{};
+    extra.reserve(src.size());
+
+    for (KernelCase const& kernel : Kernels)
+    {
+        for (const PixelKernelLevel level : SupportedLevels())
+        {
+            SetPixelKernelLevel(level);
+            std::vector<double> samples{};
+            for (int32_t i = 0; i < iterations; ++i)
+            {
+                std::memcpy(dst.data(), src.data(), dst.size()); // same starting point for in-place kernels
+                extra.clear();
+                const auto started = std::chrono::steady_clock::now();
+                kernel.run({ src.data(), size, size, stride }, { dst.data(), size, size, stride }, extra);
+                samples.push_back(MillisecondsSince(started));
+            }
+            results.push_back({ std::string("kernels/") + kernel.name + "/" + PixelKernelLevelName(level), Summarize(std::move(samples)) });
+        }
+    }
+
+    SetPixelKernelLevel(original);
+}
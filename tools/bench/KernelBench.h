@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "BenchReport.h"
+
+// Runs every PixelKernels function at every level this CPU supports on randomised
+// inputs (odd widths, padded strides, alpha 0/255/in-between) and compares the
+// bytes with the Scalar level. Returns one line per mismatch; empty means all agree.
+std::vector<std::string> ValidatePixelKernels();
+
+// Times each kernel at each supported level on a 1024x1024 buffer and appends
+// "kernels/<kernel>/<level>" results.
+void BenchPixelKernels(int32_t iterations, std::vector<BenchResult>& results);
@@ -0,0 +1,540 @@
+// put-a-signature-bench: time PdfDocumentHandler's hot paths (load, render, stamp,
+// save), switching documents in a PdfDocumentPool, the signature stroke model and the pixel
+// kernels over generated PDFs.
+//
+//     put-a-signature-bench [--corpus text-100,scan-1,...] [--corpus-dir dir] [--iterations N]
+//                           [--warmup N] [--suite load,render,stamp,save,pool,ink,kernels]
+//                           [--out report.json] [--baseline old.json] [--threshold percent]
+//
+// Writes a JSON report (to --out, or stdout) and progress to stderr. Exits 0 on
+// success, 1 if anything regressed against --baseline, 2 on bad usage, 3 if a
+// benchmark failed, a SIMD kernel disagreed with the scalar one or a stroke model check failed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "BenchCorpus.h"
+#include "BenchReport.h"
+#include "BenchStats.h"
+#include "InkBench.h"
+#include "KernelBench.h"
+#include "PdfDocumentHandler.h"
+#include "PdfDocumentPool.h"
+#include "PixelKernels.h"
+
+namespace
+{
+    const char* const AllSuites[] = { "load", "render", "stamp", "save", "pool", "ink", "kernels" };
+    const float RenderScales[] = { 0.5f, 1.0f, 2.0f };
+    constexpr int32_t PoolPacketSize = 8;
+
+    struct Options
+    {
+        std::vector<CorpusSpec> corpora{ DefaultCorpora() };
+        std::string corpusDir{ "bench-corpus" };
+        int32_t iterations{ 10 };
+        int32_t warmup{ 1 };
+        std::set<std::string> suites{ std::begin(AllSuites), std::end(AllSuites) };
+        std::string outPath;
+        std::string baselinePath;
+        RegressionThresholds thresholds{};
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: put-a-signature-bench [--corpus list] [--corpus-dir dir] [--iterations N] [--warmup N]\n"
+                     "                             [--suite list] [--out report.json] [--baseline old.json] [--threshold percent]\n"
+                     "\n"
+                     "  --corpus      comma-separated <text|vector|scan>-<pages>; default text/vector/scan at 1 and 100\n"
+                     "                pages plus text-5000 and vector-5000. Files are generated into --corpus-dir once.\n"
+                     "  --suite       comma-separated subset of load,render,stamp,save,pool,ink,kernels (default: all)\n"
+                     "  --baseline    compare p50 timings and peak RSS with an earlier report; anything worse by\n"
+                     "                more than --threshold percent (default 10) is reported and the exit code is 1\n";
+    }
+
+    std::vector<std::string> SplitList(std::string const& list)
+    {
+        std::vector<std::string> items{};
+        std::stringstream stream(list);
+        std::string item{};
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--corpus" && hasValue)
+            {
+                options.corpora.clear();
+                for (auto const& name : SplitList(argv[++i]))
+                {
+                    try
+                    {
+                        options.corpora.push_back(ParseCorpusSpec(name));
+                    }
+                    catch (std::exception const& ex)
+                    {
+                        std::cerr << ex.what() << "\n";
+                        return false;
+                    }
+                }
+            }
+            else if (arg == "--corpus-dir" && hasValue)
+            {
+                options.corpusDir = argv[++i];
+            }
+            else if (arg == "--iterations" && hasValue)
+            {
+                options.iterations = std::atoi(argv[++i]);
+                if (options.iterations < 1) return false;
+            }
+            else if (arg == "--warmup" && hasValue)
+            {
+                options.warmup = std::atoi(argv[++i]);
+                if (options.warmup < 0) return false;
+            }
+            else if (arg == "--suite" && hasValue)
+            {
+                options.suites.clear();
+                for (auto const& suite : SplitList(argv[++i]))
+                {
+                    if (std::find(std::begin(AllSuites), std::end(AllSuites), suite) == std::end(AllSuites)) return false;
+                    options.suites.insert(suite);
+                }
+            }
+            else if (arg == "--out" && hasValue)
+            {
+                options.outPath = argv[++i];
+            }
+            else if (arg == "--baseline" && hasValue)
+            {
+                options.baselinePath = argv[++i];
+            }
+            else if (arg == "--threshold" && hasValue)
+            {
+                const double percent = std::atof(argv[++i]);
+                if (!(percent > 0)) return false;
+                options.thresholds.fraction = percent / 100.0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !options.corpora.empty() && !options.suites.empty();
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    }
+
+    std::wstring Widen(std::string const& path)
+    {
+        return std::filesystem::path(path).wstring();
+    }
+
+    std::vector<uint8_t> ReadFile(std::string const& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot read " + path);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void Record(std::vector<BenchResult>& results, std::string name, std::vector<double> samples)
+    {
+        results.push_back({ std::move(name), Summarize(std::move(samples)) });
+        BenchResult const& result = results.back();
+        std::fprintf(stderr, "  %-40s p50 %9.3f ms  p90 %9.3f ms  max %9.3f ms\n", result.name.c_str(), result.ms.p50, result.ms.p90, result.ms.max);
+    }
+
+    // Runs `sample` warmup + iterations times; sample(i) returns the milliseconds to record.
+    void Measure(Options const& options, std::string name, std::function<double(int32_t)> const& sample, std::vector<BenchResult>& results)
+    {
+        for (int32_t i = 0; i < options.warmup; ++i) sample(i);
+
+        std::vector<double> samples{};
+        samples.reserve(static_cast<size_t>(options.iterations));
+        for (int32_t i = 0; i < options.iterations; ++i) samples.push_back(sample(i));
+        Record(results, std::move(name), std::move(samples));
+    }
+
+    // A handwritten-looking stroke on a transparent 400x160 canvas (straight alpha), like a captured signature.
+    PixelBuffer MakeSignature()
+    {
+        PixelBuffer signature(400, 160);
+        FillPixels(signature.View(), 0x00000000u);
+        constexpr double radius = 2.5;
+        for (double t = 0; t < 1.0; t += 0.0005)
+        {
+            const double cx = 20 + 360 * t;
+            const double cy = 80 + 45 * std::sin(t * 19.0) * std::cos(t * 5.0);
+            for (int32_t y = static_cast<int32_t>(cy - radius); y <= static_cast<int32_t>(cy + radius); ++y)
+            {
+                for (int32_t x = static_cast<int32_t>(cx - radius); x <= static_cast<int32_t>(cx + radius); ++x)
+                {
+                    const double distance = std::hypot(x - cx, y - cy);
+                    if (distance > radius || x < 0 || y < 0 || x >= signature.Width() || y >= signature.Height()) continue;
+                    uint8_t* pixel = signature.View().Row(y) + x * 4;
+                    const uint8_t alpha = static_cast<uint8_t>(255.0 * (std::min)(1.0, radius - distance + 0.5));
+                    pixel[0] = 0x80; pixel[1] = 0x20; pixel[2] = 0x10;
+                    pixel[3] = (std::max)(pixel[3], alpha);
+                }
+            }
+        }
+        return signature;
+    }
+
+    // Pages sampled for per-page benchmarks: spread evenly so big documents are not
+    // measured only at their start.
+    int32_t SamplePage(int32_t iteration, int32_t samples, int32_t pageCount)
+    {
+        return static_cast<int32_t>(static_cast<int64_t>(iteration % samples) * pageCount / samples);
+    }
+
+    void BenchCorpus(Options const& options, CorpusSpec const& spec, PixelBuffer const& signature,
+        BenchReport& report)
+    {
+        const std::string name = spec.Name();
+        const std::string path = EnsureCorpusFile(spec, options.corpusDir);
+        const std::vector<uint8_t> bytes = ReadFile(path);
+        const int32_t samples = options.iterations;
+        auto& results = report.benchmarks;
+
+        const bool rssPerCorpus = ResetPeakRss();
+        std::fprintf(stderr, "%s (%.1f MB)\n", name.c_str(), static_cast<double>(bytes.size()) / (1024.0 * 1024.0));
+
+        if (options.suites.count("load"))
+        {
+            Measure(options, name + "/load/bytes", [&](int32_t)
+            {
+                PdfDocumentHandler pdf{};
+                std::vector<uint8_t> copy = bytes;
+                const auto started = std::chrono::steady_clock::now();
+                pdf.LoadFromBytes(std::move(copy));
+                return MillisecondsSince(started);
+            }, results);
+
+            Measure(options, name + "/load/path", [&](int32_t)
+            {
+                PdfDocumentHandler pdf{};
+                const auto started = std::chrono::steady_clock::now();
+                pdf.LoadFromPath(Widen(path));
+                return MillisecondsSince(started);
+            }, results);
+        }
+
+        if (options.suites.count("render"))
+        {
+            // Cold renders: no render cache, so every sample rasterises. The copy out of the
+            // shared buffer stands in for RenderPageToSoftwareBitmap's copy into a SoftwareBitmap.
+            PdfDocumentHandler pdf{};
+            pdf.LoadFromPath(Widen(path));
+            pdf.SetRenderCacheBudget(0);
+            const int32_t pageCount = pdf.PageCount();
+
+            for (const float scale : RenderScales)
+            {
+                char label[32]{};
+                std::snprintf(label, sizeof(label), "/render/scale-%g", scale);
+                Measure(options, name + label, [&](int32_t i)
+                {
+                    const auto started = std::chrono::steady_clock::now();
+                    auto pixels = pdf.RenderPage(SamplePage(i, samples, pageCount), scale);
+                    PixelBuffer copy(pixels->Width(), pixels->Height());
+                    CopyPixels(copy.View(), pixels->View());
+                    return MillisecondsSince(started);
+                }, results);
+            }
+
+            // What redrawing one signature-sized rect costs next to the whole page above.
+            const PdfRect stampRect{ 300, 60, 200, 80 };
+            Measure(options, name + "/render/region", [&](int32_t i)
+            {
+                const int32_t page = SamplePage(i, samples, pageCount);
+                const auto started = std::chrono::steady_clock::now();
+                const PdfRect regionPx = pdf.PageRectToPixels(page, 2.0f, stampRect);
+                if (regionPx.width > 0.0 && regionPx.height > 0.0) pdf.RenderPageRegion(page, 2.0f, regionPx);
+                return MillisecondsSince(started);
+            }, results);
+        }
+
+        const bool stamp = options.suites.count("stamp") != 0;
+        const bool save = options.suites.count("save") != 0;
+        if (stamp || save)
+        {
+            namespace fs = std::filesystem;
+            const fs::path outDir = fs::path(options.corpusDir) / "out";
+            fs::create_directories(outDir);
+            const std::string incrementalPath = (outDir / (name + "-incremental.pdf")).string();
+            const std::string fullPath = (outDir / (name + "-full.pdf")).string();
+            const PdfRect rect{ 300, 60, 200, 80 };
+
+            std::vector<double> first{}, repeat{}, commit{}, incremental{}, full{};
+            std::vector<double> annotationCommit{}, annotationIncremental{};
+            uint64_t incrementalBytes = 0, fullBytes = 0, annotationBytes = 0;
+            for (int32_t i = -options.warmup; i < samples; ++i)
+            {
+                PdfDocumentHandler pdf{};
+                pdf.LoadFromPath(Widen(path));
+                const int32_t pageCount = pdf.PageCount();
+                const int32_t page = SamplePage((std::max)(i, 0), samples, pageCount);
+
+                // The first stamp embeds the image; the second only references it.
+                auto started = std::chrono::steady_clock::now();
+                pdf.StampSignaturePixels(page, signature.View(), rect);
+                const double firstMs = MillisecondsSince(started);
+
+                started = std::chrono::steady_clock::now();
+                pdf.StampSignaturePixels((page + 1) % pageCount, signature.View(), rect);
+                const double repeatMs = MillisecondsSince(started);
+
+                // Stamps are journaled; writing them into the page content happens here.
+                started = std::chrono::steady_clock::now();
+                pdf.CommitStamps();
+                pdf.FlushPageContent();
+                const double commitMs = MillisecondsSince(started);
+
+                const PdfSaveStats incrementalStats = pdf.SaveAs(Widen(incrementalPath), PdfSaveMode::Incremental);
+                const PdfSaveStats fullStats = pdf.SaveAs(Widen(fullPath), PdfSaveMode::FullRewrite);
+
+                // The same two stamps as annotations: no content stream is regenerated, so the
+                // incremental tail is the annotations and page dictionaries (plus any large
+                // image PDFium parsed, such as a scanned page's).
+                PdfDocumentHandler annotated{};
+                annotated.LoadFromPath(Widen(path));
+                annotated.SetStampMode(PdfStampMode::Annotation);
+                annotated.StampSignaturePixels(page, signature.View(), rect);
+                annotated.StampSignaturePixels((page + 1) % pageCount, signature.View(), rect);
+                started = std::chrono::steady_clock::now();
+                annotated.CommitStamps();
+                const double annotationCommitMs = MillisecondsSince(started);
+                const PdfSaveStats annotationStats = annotated.SaveAs(Widen(incrementalPath), PdfSaveMode::Incremental);
+                if (i < 0) continue;
+
+                first.push_back(firstMs);
+                repeat.push_back(repeatMs);
+                commit.push_back(commitMs);
+                incremental.push_back(incrementalStats.elapsedMs);
+                full.push_back(fullStats.elapsedMs);
+                annotationCommit.push_back(annotationCommitMs);
+                annotationIncremental.push_back(annotationStats.elapsedMs);
+                incrementalBytes = incrementalStats.bytesWritten;
+                fullBytes = fullStats.bytesWritten;
+                annotationBytes = annotationStats.bytesWritten;
+            }
+
+            std::error_code ignored{};
+            fs::remove(incrementalPath, ignored);
+            fs::remove(fullPath, ignored);
+
+            if (stamp)
+            {
+                Record(results, name + "/stamp/first", std::move(first));
+                Record(results, name + "/stamp/repeat", std::move(repeat));
+                Record(results, name + "/stamp/commit", std::move(commit));
+                Record(results, name + "/stamp/commit-annotation", std::move(annotationCommit));
+            }
+            if (save)
+            {
+                Record(results, name + "/save/incremental", std::move(incremental));
+                Record(results, name + "/save/full", std::move(full));
+                Record(results, name + "/save/incremental-annotation", std::move(annotationIncremental));
+                // An incremental save copies the source and writes only its tail, so
+                // bytesWritten is what it appended; set it against the source size.
+                const uintmax_t sourceBytes = fs::file_size(path, ignored);
+                auto percent = [sourceBytes](uint64_t bytes) { return sourceBytes ? 100.0 * bytes / sourceBytes : 0.0; };
+                std::fprintf(stderr, "  %-40s source %llu bytes; appended %llu (%.0f%%) content, %llu (%.0f%%) annotations; full rewrite %llu\n", "",
+                    static_cast<unsigned long long>(sourceBytes),
+                    static_cast<unsigned long long>(incrementalBytes), percent(incrementalBytes),
+                    static_cast<unsigned long long>(annotationBytes), percent(annotationBytes),
+                    static_cast<unsigned long long>(fullBytes));
+            }
+        }
+
+        if (options.suites.count("pool"))
+        {
+            // A packet of PoolPacketSize copies of the document under a budget that holds about
+            // two of them, switched between round-robin: every switch reopens the parked least
+            // recently used one and renders a page, as picking another document in the app does.
+            PdfDocumentPool pool{};
+            std::vector<PdfDocumentId> ids{};
+            for (int32_t i = 0; i < PoolPacketSize; ++i)
+            {
+                const PdfDocumentId id = pool.Add();
+                PdfDocumentHandler& pdf = pool.Use(id);
+                pdf.LoadFromPath(Widen(path));
+                pdf.RenderPage(0, 1.0f);
+                ids.push_back(id);
+            }
+            const size_t documentBytes = pool.Documents().front().memory.Total();
+            pool.SetBudget(2 * (std::max)(documentBytes, size_t{ 1 }));
+            pool.Enforce();
+
+            Measure(options, name + "/pool/switch", [&](int32_t i)
+            {
+                const PdfDocumentId id = ids[static_cast<size_t>(i) % ids.size()];
+                const auto started = std::chrono::steady_clock::now();
+                PdfDocumentHandler& pdf = pool.Use(id);
+                pdf.RenderPage(SamplePage(i, samples, pdf.PageCount()), 1.0f);
+                pool.Enforce();
+                return MillisecondsSince(started);
+            }, results);
+
+            const PdfPoolStats stats = pool.Stats();
+            std::fprintf(stderr, "  %-40s %.1f MB held, budget %.1f MB; %llu cache releases, %llu parked, %llu reopened\n", "",
+                static_cast<double>(pool.MemoryBytes()) / (1024.0 * 1024.0), static_cast<double>(pool.Budget()) / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(stats.cachesReleased), static_cast<unsigned long long>(stats.parked),
+                static_cast<unsigned long long>(stats.reopened));
+        }
+
+        if (rssPerCorpus) report.peakRssKb.emplace_back(name, PeakRssKb());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options{};
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    std::ofstream outFile{};
+    if (!options.outPath.empty())
+    {
+        outFile.open(options.outPath, std::ios::trunc);
+        if (!outFile)
+        {
+            std::cerr << "Cannot write report: " << options.outPath << "\n";
+            return 2;
+        }
+    }
+
+    BenchReport baseline{};
+    if (!options.baselinePath.empty())
+    {
+        try
+        {
+            baseline = ReadBenchReportJson(options.baselinePath);
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << ex.what() << "\n";
+            return 2;
+        }
+    }
+
+    BenchReport report{};
+    report.iterations = options.iterations;
+    report.host.emplace_back("kernel_level", PixelKernelLevelName(DetectedPixelKernelLevel()));
+    report.host.emplace_back("cpus", std::to_string(std::thread::hardware_concurrency()));
+#if defined(NDEBUG)
+    report.host.emplace_back("build", "release");
+#else
+    report.host.emplace_back("build", "debug");
+#endif
+
+    bool failed = false;
+    if (options.suites.count("kernels"))
+    {
+        std::fprintf(stderr, "pixel kernels (detected %s)\n", PixelKernelLevelName(DetectedPixelKernelLevel()));
+        for (auto const& mismatch : ValidatePixelKernels())
+        {
+            std::fprintf(stderr, "  MISMATCH %s\n", mismatch.c_str());
+            failed = true;
+        }
+        const size_t first = report.benchmarks.size();
+        BenchPixelKernels(options.iterations, report.benchmarks);
+        for (size_t i = first; i < report.benchmarks.size(); ++i)
+        {
+            BenchResult const& result = report.benchmarks[i];
+            std::fprintf(stderr, "  %-40s p50 %9.3f ms\n", result.name.c_str(), result.ms.p50);
+        }
+    }
+
+    if (options.suites.count("ink"))
+    {
+        std::fprintf(stderr, "signature ink\n");
+        for (auto const& failure : ValidateSignatureInk())
+        {
+            std::fprintf(stderr, "  FAILED %s\n", failure.c_str());
+            failed = true;
+        }
+        const size_t first = report.benchmarks.size();
+        BenchSignatureInk(options.iterations, report.benchmarks);
+        for (size_t i = first; i < report.benchmarks.size(); ++i)
+        {
+            BenchResult const& result = report.benchmarks[i];
+            std::fprintf(stderr, "  %-40s p50 %9.3f ms\n", result.name.c_str(), result.ms.p50);
+        }
+    }
+
+    const bool pdfSuites = options.suites.size() > options.suites.count("kernels") + options.suites.count("ink");
+    if (pdfSuites)
+    {
+        const PixelBuffer signature = MakeSignature();
+        for (CorpusSpec const& spec : options.corpora)
+        {
+            try
+            {
+                BenchCorpus(options, spec, signature, report);
+            }
+            catch (std::exception const& ex)
+            {
+                std::fprintf(stderr, "%s: %s\n", spec.Name().c_str(), ex.what());
+                failed = true;
+            }
+        }
+    }
+
+    // Process-wide peak, including corpus generation.
+    rusage usage{};
+    report.peakRssKb.emplace_back("process", getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<uint64_t>(usage.ru_maxrss) : 0);
+
+    std::vector<BenchComparison> comparison{};
+    int32_t regressions = 0;
+    if (!options.baselinePath.empty())
+    {
+        comparison = CompareBenchReports(baseline, report, options.thresholds);
+        for (BenchComparison const& entry : comparison)
+        {
+            if (!entry.regressed) continue;
+            ++regressions;
+            std::fprintf(stderr, "REGRESSION %s %s: %.3f -> %.3f (%+.1f%%)\n", entry.name.c_str(), entry.metric.c_str(),
+                entry.baseline, entry.current, (entry.Ratio() - 1.0) * 100.0);
+        }
+        std::fprintf(stderr, "%zu compared with %s, %d regressed (threshold %.0f%%)\n", comparison.size(),
+            options.baselinePath.c_str(), regressions, options.thresholds.fraction * 100.0);
+    }
+
+    std::ostream& out = options.outPath.empty() ? std::cout : outFile;
+    WriteBenchReportJson(out, report, options.baselinePath.empty() ? nullptr : &comparison);
+    out.flush();
+
+    if (failed) return 3;
+    return regressions == 0 ? 0 : 1;
+}